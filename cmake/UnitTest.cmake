@@ -46,3 +46,16 @@ function(add_unit_test name)
 
     add_test(NAME ${name} COMMAND ${name}_test WORKING_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR})
 endfunction()
+
+# Benchmarks use QtTest too, but take too long for every test run. They are built, not added to ctest.
+function(add_benchmark name)
+    set(options "")
+    set(oneValueArgs "")
+    set(multiValueArgs SOURCES LIBS)
+
+    cmake_parse_arguments(OPT "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN} )
+
+    add_executable(${name}_benchmark ${OPT_SOURCES})
+    target_link_libraries(${name}_benchmark Qt5::Test ${OPT_LIBS})
+    target_include_directories(${name}_benchmark PRIVATE "${TEST_RESOURCE_PATH}/UnitTest/")
+endfunction()
@@ -51,6 +51,8 @@
 #include <minecraft/auth/AccountList.h>
 #include "icons/IconList.h"
 #include "net/HttpMetaCache.h"
+#include "ContentStore.h"
+#include "hashing/MultiHash.h"
 
 #include "java/JavaUtils.h"
 
@@ -447,6 +449,7 @@ Application::Application(int &argc, char **argv) : QApplication(argc, argv)
                     "libraries",
                     "meta",
                     "metacache",
+                    "metacache.journal",
                     "mods",
                     BuildConfig.LAUNCHER_CONFIGFILE,
                     "themes",
@@ -700,8 +703,19 @@ Application::Application(int &argc, char **argv) : QApplication(argc, argv)
         m_settings->registerSetting("Downloadsource", "Mojang");
         m_settings->registerSetting("Downloadsourceurl", "");
         m_settings->registerSetting("Downloadsourceproxy",false);
+        // extra URL rewriting rules, "match=replacement" separated by ';'
+        m_settings->registerSetting("DownloadRewriteRules", "");
 
         m_settings->registerSetting("Threads", 8);
+        // download rate limits in KiB/s, 0 means unlimited
+        m_settings->registerSetting("DownloadRateLimit", 0);
+        m_settings->registerSetting("BackgroundRateLimit", 0);
+        // write a summary of every network job next to the log
+        m_settings->registerSetting("NetworkTraces", false);
+        // ask hosts for HTTP/2, falling back to HTTP/1.1 where they don't have it
+        m_settings->registerSetting("NetworkHttp2", true);
+        // let instances share files with the content store through hard links, where the file system can't clone them
+        m_settings->registerSetting("ContentStoreHardlinks", true);
 
         // Console
         m_settings->registerSetting("ShowConsole", false);
@@ -804,12 +818,61 @@ Application::Application(int &argc, char **argv) : QApplication(argc, argv)
     // initialize network access and proxy setup
     {
         m_network = new QNetworkAccessManager();
+        // resume TLS sessions instead of doing full handshakes to the same hosts over and over
+        Net::ConnectionWarmer::enableSessionReuse();
         QString proxyTypeStr = settings()->get("ProxyType").toString();
         QString addr = settings()->get("ProxyAddr").toString();
         int port = settings()->get("ProxyPort").value<qint16>();
         QString user = settings()->get("ProxyUser").toString();
         QString pass = settings()->get("ProxyPass").toString();
         updateProxySettings(proxyTypeStr, addr, port, user, pass);
+
+        // all downloads share one connection budget
+        m_netScheduler.reset(new Net::Scheduler());
+        auto threadsSetting = m_settings->getSetting("Threads");
+        m_netScheduler->setConnectionLimit(getconfigfile() ? threadsSetting->get().toInt() : 6);
+        connect(threadsSetting.get(), &Setting::SettingChanged, [&](const Setting &, QVariant value)
+                {
+                    m_netScheduler->setConnectionLimit(getconfigfile() ? value.toInt() : 6);
+                });
+        auto rateSetting = m_settings->getSetting("DownloadRateLimit");
+        m_netScheduler->rateLimiter().setGlobalLimit(rateSetting->get().toLongLong() * 1024);
+        connect(rateSetting.get(), &Setting::SettingChanged, [&](const Setting &, QVariant value)
+                {
+                    m_netScheduler->rateLimiter().setGlobalLimit(value.toLongLong() * 1024);
+                });
+        auto backgroundRateSetting = m_settings->getSetting("BackgroundRateLimit");
+        m_netScheduler->rateLimiter().setBackgroundLimit(backgroundRateSetting->get().toLongLong() * 1024);
+        connect(backgroundRateSetting.get(), &Setting::SettingChanged, [&](const Setting &, QVariant value)
+                {
+                    m_netScheduler->rateLimiter().setBackgroundLimit(value.toLongLong() * 1024);
+                });
+        auto http2Setting = m_settings->getSetting("NetworkHttp2");
+        m_netScheduler->warmer().setHttp2Allowed(http2Setting->get().toBool());
+        connect(http2Setting.get(), &Setting::SettingChanged, [&](const Setting &, QVariant value)
+                {
+                    m_netScheduler->warmer().setHttp2Allowed(value.toBool());
+                });
+        updateDownloadRoutes();
+        for(auto name: {"Downloadsource", "Downloadsourceurl", "Downloadsourceproxy", "DownloadRewriteRules"})
+        {
+            connect(m_settings->getSetting(name).get(), &Setting::SettingChanged, [&](const Setting &, QVariant)
+                    {
+                        updateDownloadRoutes();
+                    });
+        }
+        static const QString traceFile = BuildConfig.LAUNCHER_NAME + "-net.jsonl";
+        auto tracesSetting = m_settings->getSetting("NetworkTraces");
+        if(tracesSetting->get().toBool())
+        {
+            // like the log, it only covers the current run
+            QFile::remove(traceFile);
+            m_netScheduler->setTraceFile(traceFile);
+        }
+        connect(tracesSetting.get(), &Setting::SettingChanged, [&](const Setting &, QVariant value)
+                {
+                    m_netScheduler->setTraceFile(value.toBool() ? traceFile : QString());
+                });
         qDebug() << "<> Network done.";
     }
 
@@ -945,6 +1008,8 @@ Application::Application(int &argc, char **argv) : QApplication(argc, argv)
         m_metacache->addBase("icons", QDir("cache/icons").absolutePath());
         m_metacache->addBase("meta", QDir("meta").absolutePath());
         m_metacache->Load();
+        m_contentStore = std::make_shared<ContentStore>("store");
+        m_contentStore->setAllowHardlinks(m_settings->get("ContentStoreHardlinks").toBool());
         qDebug() << "<> Cache initialized.";
     }
 
@@ -1601,11 +1666,21 @@ shared_qobject_ptr< HttpMetaCache > Application::metacache()
     return m_metacache;
 }
 
+std::shared_ptr<ContentStore> Application::contentStore()
+{
+    return m_contentStore;
+}
+
 shared_qobject_ptr<QNetworkAccessManager> Application::network()
 {
     return m_network;
 }
 
+shared_qobject_ptr<Net::Scheduler> Application::netScheduler()
+{
+    return m_netScheduler;
+}
+
 shared_qobject_ptr<Meta::Index> Application::metadataIndex()
 {
     if (!m_metadataIndex)
@@ -1658,17 +1733,8 @@ void Application::requestFinished()
 //判断 authlib hash256s是否一致
 bool Application::FileHash(QString srcDir, QString hash256)
 {
-    QFile file(srcDir);
-    QCryptographicHash Hash(QCryptographicHash::Sha256);
-    if(file.open(QIODevice::ReadOnly)){
-        Hash.addData(file.readAll());
-        QByteArray HASH256 = Hash.result();
-        if(HASH256.toHex() == hash256)
-        {
-            return true;
-        }
-    }
-    return false;
+    QByteArray HASH256 = Hashing::MultiHash::hashFile(Hashing::Algorithm::Sha256, srcDir);
+    return !HASH256.isEmpty() && HASH256.toHex() == hash256;
 }
 void Application::authlibFinished()
 {
@@ -1676,6 +1742,40 @@ void Application::authlibFinished()
     authlib_filesNetJob.reset();
 
 }
+void Application::warmUpConnections(const QList<QUrl> &urls)
+{
+    m_netScheduler->warmUp(m_network.get(), urls);
+}
+
+void Application::updateDownloadRoutes()
+{
+    // the selected source goes first, the others are there to fail over to
+    QList<Net::UrlRouter::Source> sources;
+    auto selected = m_settings->get("Downloadsource").toString();
+    if(getconfigfile() && selected != "Mojang")
+    {
+        Net::UrlRouter::Source source;
+        source.name = selected;
+        source.baseUrl = m_settings->get("Downloadsourceurl").toString();
+        source.proxy = m_settings->get("Downloadsourceproxy").toBool();
+        sources.append(source);
+        for(auto & other : downloadSources)
+        {
+            if(other.getType() == "Mojang" || other.getUrl().trimmed().isEmpty())
+            {
+                continue;
+            }
+            Net::UrlRouter::Source mirror;
+            mirror.name = other.getType();
+            mirror.baseUrl = other.getUrl();
+            mirror.proxy = other.isProxy();
+            sources.append(mirror);
+        }
+    }
+    auto userRules = Net::UrlRouter::parseUserRules(m_settings->get("DownloadRewriteRules").toString());
+    m_netScheduler->router().compile(sources, userRules);
+}
+
 // Getter methods
 const QList<DownloadSource>& Application::getDownloadSources() const { return downloadSources; }
 const QList<YggSource>& Application::getYggSources() const { return yggSources; }
@@ -1740,6 +1840,7 @@ void Application::sourceFinished()
 
             addDownloadSource(source);
         }
+        updateDownloadRoutes();
     }
     else
     {
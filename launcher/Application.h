@@ -23,6 +23,7 @@ class SetupWizard;
 class GenericPageProvider;
 class QFile;
 class HttpMetaCache;
+class ContentStore;
 class SettingsObject;
 class InstanceList;
 class AccountList;
@@ -128,6 +129,10 @@ public:
 
     shared_qobject_ptr<HttpMetaCache> metacache();
 
+    std::shared_ptr<ContentStore> contentStore();
+
+    shared_qobject_ptr<Net::Scheduler> netScheduler();
+
     shared_qobject_ptr<Meta::Index> metadataIndex();
 
     QString getJarsPath();
@@ -205,6 +210,10 @@ private:
     void addRunningInstance();
     void subRunningInstance();
     bool shouldExitNow() const;
+    // rebuild the download URL rewriting rules from the settings
+    void updateDownloadRoutes();
+    // connect ahead of time to the hosts the URLs are going to be downloaded from
+    void warmUpConnections(const QList<QUrl> &urls);
 
 private:
     NetJob::Ptr m_filesNetJob;
@@ -214,11 +223,13 @@ private:
     QDateTime startTime;
 
     shared_qobject_ptr<QNetworkAccessManager> m_network;
+    shared_qobject_ptr<Net::Scheduler> m_netScheduler;
 
     shared_qobject_ptr<UpdateChecker> m_updateChecker;
     shared_qobject_ptr<AccountList> m_accounts;
 
     shared_qobject_ptr<HttpMetaCache> m_metacache;
+    std::shared_ptr<ContentStore> m_contentStore;
     shared_qobject_ptr<Meta::Index> m_metadataIndex;
 
     std::shared_ptr<SettingsObject> m_settings;
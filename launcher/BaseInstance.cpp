@@ -236,6 +236,24 @@ void BaseInstance::setRunning(bool running)
     emit runningStatusChanged(running);
 }
 
+void BaseInstance::beginUpdate()
+{
+    m_updating++;
+}
+
+void BaseInstance::endUpdate()
+{
+    if(m_updating > 0)
+    {
+        m_updating--;
+    }
+}
+
+bool BaseInstance::isUpdating() const
+{
+    return m_updating > 0;
+}
+
 int64_t BaseInstance::totalTimePlayed() const
 {
     qint64 current = settings()->get("totalTimePlayed").toLongLong();
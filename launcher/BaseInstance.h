@@ -22,6 +22,7 @@
 #include <QDateTime>
 #include <QSet>
 #include <QProcess>
+#include <QUrl>
 
 #include "settings/SettingsObject.h"
 
@@ -85,6 +86,12 @@ public:
 
     void setRunning(bool running);
     bool isRunning() const;
+
+    /// Update tasks downloading into the shared folders for this instance, nesting is allowed
+    void beginUpdate();
+    void endUpdate();
+    bool isUpdating() const;
+
     int64_t totalTimePlayed() const;
     int64_t lastTimePlayed() const;
     void resetTimePlayed();
@@ -163,6 +170,18 @@ public:
     /// returns a valid update task
     virtual Task::Ptr createUpdateTask(Net::Mode mode) = 0;
 
+    /// returns the update task to run right before a launch, which may skip work done by an earlier one
+    virtual Task::Ptr createLaunchUpdateTask(Net::Mode mode)
+    {
+        return createUpdateTask(mode);
+    }
+
+    /// URLs the next update or launch is likely to download from, to connect to them ahead of time
+    virtual QList<QUrl> likelyDownloadUrls() const
+    {
+        return QList<QUrl>();
+    }
+
     /// returns a valid launcher (task container)
     virtual shared_qobject_ptr<LaunchTask> createLaunchTask(
             AuthSessionPtr account, QuickPlayTargetPtr quickPlayTarget) = 0;
@@ -273,6 +292,7 @@ protected: /* data */
     SettingsObjectPtr m_settings;
     // InstanceFlags m_flags;
     bool m_isRunning = false;
+    int m_updating = 0;
     shared_qobject_ptr<LaunchTask> m_launchProcess;
     QDateTime m_timeStarted;
 
@@ -0,0 +1,214 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "ContentStore.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QDebug>
+
+#include "net/ChecksumValidator.h"
+
+namespace {
+// 2000-01-01T00:00:00Z, the timestamp of everything committed to the store
+const qint64 storeTimestamp = 946684800;
+}
+
+ContentStore::ContentStore(const QString &root) : m_root(QDir(root).absolutePath())
+{
+}
+
+QString ContentStore::algorithmName(QCryptographicHash::Algorithm algorithm)
+{
+    switch(algorithm)
+    {
+        case QCryptographicHash::Md5:
+            return "md5";
+        case QCryptographicHash::Sha1:
+            return "sha1";
+        case QCryptographicHash::Sha256:
+            return "sha256";
+        case QCryptographicHash::Sha512:
+            return "sha512";
+        default:
+            return QString();
+    }
+}
+
+QString ContentStore::pathFor(QCryptographicHash::Algorithm algorithm, const QByteArray &hash) const
+{
+    auto name = algorithmName(algorithm);
+    if(name.isEmpty() || hash.isEmpty())
+    {
+        return QString();
+    }
+    auto hex = QString::fromLatin1(hash.toHex());
+    return FS::PathCombine(m_root, name, hex.left(2), hex);
+}
+
+QString ContentStore::stagingPath(QCryptographicHash::Algorithm algorithm, const QByteArray &hash) const
+{
+    auto name = algorithmName(algorithm);
+    if(name.isEmpty() || hash.isEmpty())
+    {
+        return QString();
+    }
+    auto folder = FS::PathCombine(m_root, "staging");
+    if(!FS::ensureFolderPathExists(folder))
+    {
+        return QString();
+    }
+    // the file itself only appears once the download has finished
+    QTemporaryDir unique(FS::PathCombine(folder, name + "-" + QString::fromLatin1(hash.toHex()) + ".XXXXXX"));
+    if(!unique.isValid())
+    {
+        qWarning() << "Could not create a staging folder in" << folder;
+        return QString();
+    }
+    unique.setAutoRemove(false);
+    return FS::PathCombine(unique.path(), "download");
+}
+
+QString ContentStore::find(QCryptographicHash::Algorithm algorithm, const QByteArray &hash)
+{
+    auto path = pathFor(algorithm, hash);
+    if(path.isEmpty())
+    {
+        return QString();
+    }
+    QFileInfo info(path);
+    if(!info.isFile())
+    {
+        return QString();
+    }
+    if(info.lastModified().toMSecsSinceEpoch() / 1000 != storeTimestamp)
+    {
+        // somebody wrote to it through a hard link. Let them have it and forget about it
+        qWarning() << "Stored file" << path << "was changed, dropping it from the store";
+        QFile::remove(path);
+        return QString();
+    }
+    return path;
+}
+
+bool ContentStore::commit(const QString &staging, QCryptographicHash::Algorithm algorithm, const QByteArray &hash)
+{
+    auto to = pathFor(algorithm, hash);
+    if(to.isEmpty() || staging.isEmpty() || !QFile::exists(staging))
+    {
+        return false;
+    }
+    if(!FS::setTimestamp(staging, storeTimestamp) || !FS::ensureFilePathExists(to))
+    {
+        qWarning() << "Could not commit" << staging << "to the store";
+        return false;
+    }
+    // never replaces what is there, so nobody placing the stored file sees it go away
+    bool moved = QFile::rename(staging, to);
+    FS::deletePath(QFileInfo(staging).path());
+    if(moved)
+    {
+        return true;
+    }
+    // another install committed the same file meanwhile, either one will do
+    if(!find(algorithm, hash).isEmpty())
+    {
+        return true;
+    }
+    qWarning() << "Could not move" << staging << "to" << to;
+    return false;
+}
+
+QString ContentStore::Batch::keyOf(QCryptographicHash::Algorithm algorithm, const QByteArray &hash)
+{
+    return ContentStore::algorithmName(algorithm) + "-" + QString::fromLatin1(hash.toHex());
+}
+
+Net::Download::Ptr ContentStore::Batch::add(const QUrl &url, QCryptographicHash::Algorithm algorithm, const QByteArray &hash, const QString &target)
+{
+    m_files.append({algorithm, hash, target});
+    auto key = keyOf(algorithm, hash);
+    if(m_queued.contains(key) || !m_store->find(algorithm, hash).isEmpty())
+    {
+        return nullptr;
+    }
+    auto staging = m_store->stagingPath(algorithm, hash);
+    if(staging.isEmpty())
+    {
+        // nothing to download into, place() reports the target as failed
+        return nullptr;
+    }
+    m_queued.insert(key, staging);
+    qDebug() << "Will download" << url << "into the store for" << target;
+    auto dl = Net::Download::makeFile(url, staging);
+    dl->addValidator(new Net::ChecksumValidator(algorithm, hash));
+    return dl;
+}
+
+QStringList ContentStore::Batch::place()
+{
+    QStringList failed;
+    for(auto & file: m_files)
+    {
+        auto staging = m_queued.value(keyOf(file.algorithm, file.hash));
+        if(!staging.isEmpty() && m_store->find(file.algorithm, file.hash).isEmpty())
+        {
+            m_store->commit(staging, file.algorithm, file.hash);
+        }
+        if(!m_store->materialize(file.algorithm, file.hash, file.target))
+        {
+            failed.append(file.target);
+        }
+    }
+    qDebug() << "Placed" << m_files.size() - failed.size() << "stored files," << m_queued.size() << "of them were downloaded";
+    // whatever didn't make it into the store
+    for(auto & staging: m_queued)
+    {
+        FS::deletePath(QFileInfo(staging).path());
+    }
+    m_files.clear();
+    m_queued.clear();
+    return failed;
+}
+
+bool ContentStore::materialize(QCryptographicHash::Algorithm algorithm, const QByteArray &hash, const QString &target)
+{
+    auto stored = find(algorithm, hash);
+    if(stored.isEmpty())
+    {
+        return false;
+    }
+    if(QFileInfo::exists(target) && !QFile::remove(target))
+    {
+        qWarning() << "Could not replace" << target << "with the stored file";
+        return false;
+    }
+    auto result = FS::cloneFile(stored, target, m_allowHardlinks);
+    switch(result)
+    {
+        case FS::CloneResult::Failed:
+            qWarning() << "Could not place stored file" << stored << "at" << target;
+            return false;
+        case FS::CloneResult::Copied:
+            // the copy keeps our timestamp, give it its own
+            FS::updateTimestamp(target);
+            return true;
+        default:
+            return true;
+    }
+}
@@ -0,0 +1,104 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+#include <QUrl>
+#include <memory>
+
+#include "FileSystem.h"
+#include "net/Download.h"
+
+/*
+ * Files shared by all instances, stored under their hash.
+ *
+ * Modpack installers look files up here before downloading them, download the missing ones
+ * into the store and then place them in the instance as clones or hard links of the stored
+ * file, so a mod used by ten instances is downloaded and stored once.
+ *
+ * Stored files get a fixed timestamp when they are committed. A file changed in place through a
+ * hard link gets a new one, and is no longer trusted by the store.
+ */
+class ContentStore
+{
+public: /* types */
+    using Ptr = std::shared_ptr<ContentStore>;
+
+    // the stored files an installer wants, and the downloads of the ones the store doesn't have yet
+    class Batch
+    {
+    public:
+        explicit Batch(Ptr store) : m_store(store) {};
+        // want the file with the hash at target. Returns the download that brings it into the store, if it is needed
+        Net::Download::Ptr add(const QUrl &url, QCryptographicHash::Algorithm algorithm, const QByteArray &hash, const QString &target);
+        // commit what was downloaded and place all the files. Returns the targets that could not be placed
+        QStringList place();
+        bool isEmpty() const
+        {
+            return m_files.isEmpty();
+        }
+
+    private:
+        struct Placement
+        {
+            QCryptographicHash::Algorithm algorithm;
+            QByteArray hash;
+            QString target;
+        };
+        static QString keyOf(QCryptographicHash::Algorithm algorithm, const QByteArray &hash);
+
+        Ptr m_store;
+        QList<Placement> m_files;
+        // staging paths of the downloads, by algorithm and hash
+        QHash<QString, QString> m_queued;
+    };
+
+public: /* con/des */
+    explicit ContentStore(const QString &root);
+
+public: /* methods */
+    // the stored file with the hash, empty if there is none
+    QString find(QCryptographicHash::Algorithm algorithm, const QByteArray &hash);
+
+    // where to download a file with the hash to before it is committed, empty if there is no room for it.
+    // Every call gives a new folder to download into, so installs running at the same time don't write over each other
+    QString stagingPath(QCryptographicHash::Algorithm algorithm, const QByteArray &hash) const;
+    // move a downloaded and verified file from its staging path into the store
+    bool commit(const QString &staging, QCryptographicHash::Algorithm algorithm, const QByteArray &hash);
+
+    // place the stored file with the hash at target, sharing its data if possible
+    bool materialize(QCryptographicHash::Algorithm algorithm, const QByteArray &hash, const QString &target);
+
+    // hard links share changes made to the instance copy with the store, clones and copies don't
+    void setAllowHardlinks(bool allow)
+    {
+        m_allowHardlinks = allow;
+    }
+
+    static QString algorithmName(QCryptographicHash::Algorithm algorithm);
+
+private: /* methods */
+    QString pathFor(QCryptographicHash::Algorithm algorithm, const QByteArray &hash) const;
+
+private: /* data */
+    QString m_root;
+    bool m_allowHardlinks = true;
+};
@@ -0,0 +1,130 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QCryptographicHash>
+#include <QFileInfo>
+
+#include "ContentStore.h"
+#include "FileSystem.h"
+
+class ContentStoreTest : public QObject
+{
+    Q_OBJECT
+
+    QByteArray sha1(const QByteArray &data)
+    {
+        return QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+    }
+
+    // what a finished download leaves in the staging file
+    void stage(ContentStore &store, const QByteArray &data)
+    {
+        auto staging = store.stagingPath(QCryptographicHash::Sha1, sha1(data));
+        QVERIFY(!staging.isEmpty());
+        FS::write(staging, data);
+        QVERIFY(store.commit(staging, QCryptographicHash::Sha1, sha1(data)));
+        QVERIFY(!QFileInfo::exists(QFileInfo(staging).path()));
+    }
+
+private
+slots:
+    void test_findAndCommit()
+    {
+        QTemporaryDir dir;
+        ContentStore store(FS::PathCombine(dir.path(), "store"));
+        QByteArray data = "stored mod";
+        QVERIFY(store.find(QCryptographicHash::Sha1, sha1(data)).isEmpty());
+        stage(store, data);
+        auto found = store.find(QCryptographicHash::Sha1, sha1(data));
+        QVERIFY(!found.isEmpty());
+        QCOMPARE(FS::read(found), data);
+        // the algorithm is part of the name
+        QVERIFY(store.find(QCryptographicHash::Md5, sha1(data)).isEmpty());
+    }
+
+    void test_uniqueStaging()
+    {
+        QTemporaryDir dir;
+        ContentStore store(FS::PathCombine(dir.path(), "store"));
+        QByteArray data = "stored mod";
+        auto first = store.stagingPath(QCryptographicHash::Sha1, sha1(data));
+        auto second = store.stagingPath(QCryptographicHash::Sha1, sha1(data));
+        QVERIFY(!first.isEmpty());
+        QVERIFY(first != second);
+    }
+
+    void test_commitExisting()
+    {
+        QTemporaryDir dir;
+        ContentStore store(FS::PathCombine(dir.path(), "store"));
+        QByteArray data = "stored mod";
+        stage(store, data);
+        auto found = store.find(QCryptographicHash::Sha1, sha1(data));
+        // two installs downloaded the same file, the second commit keeps the first file
+        stage(store, data);
+        QCOMPARE(store.find(QCryptographicHash::Sha1, sha1(data)), found);
+    }
+
+    void test_materialize()
+    {
+        QTemporaryDir dir;
+        ContentStore store(FS::PathCombine(dir.path(), "store"));
+        store.setAllowHardlinks(false);
+        QByteArray data = "stored mod";
+        stage(store, data);
+        auto target = FS::PathCombine(dir.path(), "instance", "mods", "mod.jar");
+        FS::write(target, "old version");
+        QVERIFY(store.materialize(QCryptographicHash::Sha1, sha1(data), target));
+        QCOMPARE(FS::read(target), data);
+        // without hard links, changing the placed file leaves the store alone
+        FS::write(target, "changed");
+        QCOMPARE(FS::read(store.find(QCryptographicHash::Sha1, sha1(data))), data);
+
+        QVERIFY(!store.materialize(QCryptographicHash::Sha1, sha1("missing"), target));
+    }
+
+    void test_tampered()
+    {
+        QTemporaryDir dir;
+        ContentStore store(FS::PathCombine(dir.path(), "store"));
+        QByteArray data = "stored mod";
+        stage(store, data);
+        auto found = store.find(QCryptographicHash::Sha1, sha1(data));
+        // what writing through a hard link does to it
+        QVERIFY(FS::updateTimestamp(found));
+        QVERIFY(store.find(QCryptographicHash::Sha1, sha1(data)).isEmpty());
+        QVERIFY(!QFile::exists(found));
+    }
+
+    void test_batch()
+    {
+        QTemporaryDir dir;
+        auto store = std::make_shared<ContentStore>(FS::PathCombine(dir.path(), "store"));
+        store->setAllowHardlinks(false);
+        QByteArray stored = "already stored";
+        QByteArray fresh = "downloaded";
+        stage(*store, stored);
+
+        ContentStore::Batch batch(store);
+        auto instance = FS::PathCombine(dir.path(), "instance");
+        QVERIFY(!batch.add(QUrl("https://example.com/stored.jar"), QCryptographicHash::Sha1, sha1(stored), FS::PathCombine(instance, "a.jar")));
+        auto dl = batch.add(QUrl("https://example.com/fresh.jar"), QCryptographicHash::Sha1, sha1(fresh), FS::PathCombine(instance, "b.jar"));
+        QVERIFY(dl);
+        // the same file twice is downloaded once, the same hash of another algorithm isn't the same file
+        QVERIFY(!batch.add(QUrl("https://example.com/fresh.jar"), QCryptographicHash::Sha1, sha1(fresh), FS::PathCombine(instance, "c.jar")));
+        QVERIFY(batch.add(QUrl("https://example.com/other.jar"), QCryptographicHash::Sha256, sha1(fresh), FS::PathCombine(instance, "d.jar")));
+        FS::write(dl->getTargetFilepath(), fresh);
+
+        auto failed = batch.place();
+        QCOMPARE(failed, QStringList({FS::PathCombine(instance, "d.jar")}));
+        QCOMPARE(FS::read(FS::PathCombine(instance, "a.jar")), stored);
+        QCOMPARE(FS::read(FS::PathCombine(instance, "b.jar")), fresh);
+        QCOMPARE(FS::read(FS::PathCombine(instance, "c.jar")), fresh);
+        QVERIFY(batch.isEmpty());
+        // nothing is left in staging
+        QVERIFY(QDir(FS::PathCombine(dir.path(), "store", "staging")).entryList(QDir::AllEntries | QDir::NoDotAndDotDot).isEmpty());
+    }
+};
+
+QTEST_GUILESS_MAIN(ContentStoreTest)
+
+#include "ContentStore_test.moc"
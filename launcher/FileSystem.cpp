@@ -22,7 +22,18 @@
     #include <shlguid.h>
     #include <shlobj.h>
 #else
+    #include <stdio.h>
     #include <utime.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+    #include <sys/ioctl.h>
+    #include <sys/stat.h>
+#endif
+
+#if defined Q_OS_LINUX
+    #include <linux/fs.h>
+#elif defined Q_OS_MACOS
+    #include <sys/clonefile.h>
 #endif
 
 namespace FS {
@@ -87,6 +98,125 @@ bool updateTimestamp(const QString& filename)
 #endif
 }
 
+bool setTimestamp(const QString& filename, qint64 secsSinceEpoch)
+{
+#ifdef Q_OS_WIN32
+    std::wstring filename_utf_16 = filename.toStdWString();
+    struct __utimbuf64 times;
+    times.actime = secsSinceEpoch;
+    times.modtime = secsSinceEpoch;
+    return (_wutime64(filename_utf_16.c_str(), &times) == 0);
+#else
+    QByteArray filenameBA = QFile::encodeName(filename);
+    struct utimbuf times;
+    times.actime = secsSinceEpoch;
+    times.modtime = secsSinceEpoch;
+    return (utime(filenameBA.data(), &times) == 0);
+#endif
+}
+
+namespace {
+bool reflink(const QString &src, const QString &dst)
+{
+#if defined Q_OS_LINUX && defined FICLONE
+    QByteArray srcBA = QFile::encodeName(src);
+    QByteArray dstBA = QFile::encodeName(dst);
+    int in = ::open(srcBA.data(), O_RDONLY);
+    if(in < 0)
+    {
+        return false;
+    }
+    int out = ::open(dstBA.data(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if(out < 0)
+    {
+        ::close(in);
+        return false;
+    }
+    bool ok = ::ioctl(out, FICLONE, in) == 0;
+    ::close(in);
+    ::close(out);
+    if(!ok)
+    {
+        ::unlink(dstBA.data());
+    }
+    return ok;
+#elif defined Q_OS_MACOS
+    return clonefile(QFile::encodeName(src).data(), QFile::encodeName(dst).data(), 0) == 0;
+#else
+    Q_UNUSED(src);
+    Q_UNUSED(dst);
+    return false;
+#endif
+}
+
+bool hardlink(const QString &src, const QString &dst)
+{
+#if defined Q_OS_WIN32
+    std::wstring srcW = QDir::toNativeSeparators(src).toStdWString();
+    std::wstring dstW = QDir::toNativeSeparators(dst).toStdWString();
+    return CreateHardLinkW(dstW.c_str(), srcW.c_str(), nullptr);
+#else
+    return ::link(QFile::encodeName(src).data(), QFile::encodeName(dst).data()) == 0;
+#endif
+}
+}
+
+CloneResult cloneFile(const QString &src, const QString &dst, bool allowHardlink)
+{
+    if(!ensureFilePathExists(dst))
+    {
+        return CloneResult::Failed;
+    }
+    if(reflink(src, dst))
+    {
+        return CloneResult::Reflinked;
+    }
+    if(allowHardlink && hardlink(src, dst))
+    {
+        return CloneResult::Hardlinked;
+    }
+    if(QFile::copy(src, dst))
+    {
+        return CloneResult::Copied;
+    }
+    return CloneResult::Failed;
+}
+
+bool renameOver(const QString &src, const QString &dst)
+{
+#if defined Q_OS_WIN32
+    std::wstring srcW = QDir::toNativeSeparators(src).toStdWString();
+    std::wstring dstW = QDir::toNativeSeparators(dst).toStdWString();
+    return MoveFileExW(srcW.c_str(), dstW.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    return ::rename(QFile::encodeName(src).data(), QFile::encodeName(dst).data()) == 0;
+#endif
+}
+
+int linkCount(const QString &path)
+{
+#if defined Q_OS_WIN32
+    std::wstring pathW = QDir::toNativeSeparators(path).toStdWString();
+    HANDLE handle = CreateFileW(pathW.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(handle == INVALID_HANDLE_VALUE)
+    {
+        return 0;
+    }
+    BY_HANDLE_FILE_INFORMATION info;
+    int count = GetFileInformationByHandle(handle, &info) ? int(info.nNumberOfLinks) : 0;
+    CloseHandle(handle);
+    return count;
+#else
+    struct stat st;
+    if(::stat(QFile::encodeName(path).data(), &st) != 0)
+    {
+        return 0;
+    }
+    return int(st.st_nlink);
+#endif
+}
+
 bool ensureFilePathExists(QString filenamepath)
 {
     QFileInfo a(filenamepath);
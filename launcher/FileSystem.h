@@ -32,6 +32,11 @@ QByteArray read(const QString &filename);
  */
 bool updateTimestamp(const QString & filename);
 
+/**
+ * Set the last changed timestamp of an existing file, in seconds since the epoch
+ */
+bool setTimestamp(const QString & filename, qint64 secsSinceEpoch);
+
 /**
  * Creates all the folders in a path for the specified path
  * last segment of the path is treated as a file name and is ignored!
@@ -77,6 +82,34 @@ private:
     QDir m_dst;
 };
 
+enum class CloneResult
+{
+    Failed,
+    // copy-on-write clone, the files share the data until one of them changes
+    Reflinked,
+    // the same file under two names, changing one changes the other
+    Hardlinked,
+    Copied
+};
+
+/**
+ * Make dst a file with the contents of src, sharing the data on disk if the file system can do it.
+ * Tries a copy-on-write clone, then a hard link (if allowed), then a plain copy.
+ * dst must not exist, missing folders are created.
+ */
+CloneResult cloneFile(const QString &src, const QString &dst, bool allowHardlink = true);
+
+/**
+ * Move src to dst in one step, replacing dst if it exists. Nobody ever sees dst missing or half written.
+ * Both have to be on the same file system.
+ */
+bool renameOver(const QString &src, const QString &dst);
+
+/**
+ * Number of names the file is known by on disk (hard links), 0 if it can't be determined.
+ */
+int linkCount(const QString &path);
+
 /**
  * Delete a folder recursively
  */
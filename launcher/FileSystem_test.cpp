@@ -112,6 +112,69 @@ slots:
         f();
     }
 
+    void test_cloneFile()
+    {
+        QTemporaryDir tempDir;
+        tempDir.setAutoRemove(true);
+        auto src = FS::PathCombine(tempDir.path(), "source.jar");
+        FS::write(src, "stored contents");
+
+        // without hard links, the clone never changes the source
+        auto cloned = FS::PathCombine(tempDir.path(), "a", "b", "clone.jar");
+        auto result = FS::cloneFile(src, cloned, false);
+        QVERIFY(result == FS::CloneResult::Reflinked || result == FS::CloneResult::Copied);
+        QCOMPARE(FS::read(cloned), QByteArray("stored contents"));
+        FS::write(cloned, "changed");
+        QCOMPARE(FS::read(src), QByteArray("stored contents"));
+
+        auto linked = FS::PathCombine(tempDir.path(), "linked.jar");
+        QVERIFY(FS::cloneFile(src, linked) != FS::CloneResult::Failed);
+        QCOMPARE(FS::read(linked), QByteArray("stored contents"));
+
+        // the target must not exist
+        QCOMPARE(FS::cloneFile(src, linked, false), FS::CloneResult::Failed);
+    }
+
+    void test_renameOver()
+    {
+        QTemporaryDir tempDir;
+        tempDir.setAutoRemove(true);
+        auto target = FS::PathCombine(tempDir.path(), "target.jar");
+        auto partial = target + ".part";
+        FS::write(partial, "new");
+        QVERIFY(FS::renameOver(partial, target));
+        QCOMPARE(FS::read(target), QByteArray("new"));
+
+        FS::write(partial, "newer");
+        QVERIFY(FS::renameOver(partial, target));
+        QCOMPARE(FS::read(target), QByteArray("newer"));
+        QVERIFY(!QFile::exists(partial));
+    }
+
+    void test_linkCount()
+    {
+        QTemporaryDir tempDir;
+        tempDir.setAutoRemove(true);
+        auto src = FS::PathCombine(tempDir.path(), "source.jar");
+        FS::write(src, "stored contents");
+        QCOMPARE(FS::linkCount(src), 1);
+        if(FS::cloneFile(src, FS::PathCombine(tempDir.path(), "linked.jar")) == FS::CloneResult::Hardlinked)
+        {
+            QCOMPARE(FS::linkCount(src), 2);
+        }
+        QCOMPARE(FS::linkCount(FS::PathCombine(tempDir.path(), "missing.jar")), 0);
+    }
+
+    void test_setTimestamp()
+    {
+        QTemporaryDir tempDir;
+        tempDir.setAutoRemove(true);
+        auto file = FS::PathCombine(tempDir.path(), "file");
+        FS::write(file, "x");
+        QVERIFY(FS::setTimestamp(file, 946684800));
+        QCOMPARE(QFileInfo(file).lastModified().toMSecsSinceEpoch(), qint64(946684800) * 1000);
+    }
+
     void test_getDesktop()
     {
         QCOMPARE(FS::getDesktopDir(), QStandardPaths::writableLocation(QStandardPaths::DesktopLocation));
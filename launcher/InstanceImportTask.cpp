@@ -387,6 +387,7 @@ void InstanceImportTask::processCurseForge()
         auto results = m_modIdResolver->getResults();
         int downloadCount = 0;
         m_filesNetJob = new NetJob(tr("Mod download"), APPLICATION->network());
+        m_storedFiles.reset(new ContentStore::Batch(APPLICATION->contentStore()));
         for(auto result: results.files)
         {
             if(result.url.isEmpty())
@@ -413,6 +414,16 @@ void InstanceImportTask::processCurseForge()
             case CurseForge::File::Type::Mod:
             {
 
+                if(!result.sha1.isEmpty())
+                {
+                    auto dl = m_storedFiles->add(result.url, QCryptographicHash::Sha1, result.sha1, path);
+                    if(dl)
+                    {
+                        m_filesNetJob->addNetAction(dl);
+                        downloadCount++;
+                    }
+                    break;
+                }
                 qDebug() << "Will download" << result.url << "to" << path;
                 auto dl = Net::Download::makeFile(result.url, path);
                 m_filesNetJob->addNetAction(dl);
@@ -435,7 +446,7 @@ void InstanceImportTask::processCurseForge()
         connect(m_filesNetJob.get(), &NetJob::succeeded, this, [&]()
         {
             m_filesNetJob.reset();
-            emitSucceeded();
+            placeStoredFiles();
         }
         );
         connect(m_filesNetJob.get(), &NetJob::failed, [&](QString reason)
@@ -452,7 +463,7 @@ void InstanceImportTask::processCurseForge()
             m_filesNetJob->start();
         } else {
             m_filesNetJob.reset();
-            emitSucceeded();
+            placeStoredFiles();
         }
     }
     );
@@ -559,6 +570,22 @@ bool mergeOverrides(const QString &fromDir, const QString &toDir) {
 
 }
 
+void InstanceImportTask::placeStoredFiles()
+{
+    if(m_storedFiles)
+    {
+        setStatus(tr("Placing stored files..."));
+        auto failed = m_storedFiles->place();
+        m_storedFiles.reset();
+        if(!failed.isEmpty())
+        {
+            emitFailed(tr("Could not place these files in the instance:\n%1").arg(failed.join("\n")));
+            return;
+        }
+    }
+    emitSucceeded();
+}
+
 void InstanceImportTask::processModrinth() {
     std::vector<Modrinth::File> files;
     QString minecraftVersion, fabricVersion, quiltVersion, forgeVersion, neoforgeVersion;
@@ -623,6 +650,7 @@ void InstanceImportTask::processModrinth() {
                 }
                 file.hash = QByteArray::fromHex(hash.toLatin1());
                 file.hashAlgorithm = hashAlgorithm;
+                file.sha1 = QByteArray::fromHex(Json::ensureString(hashes, "sha1").toLatin1());
                 // Do not use requireUrl, which uses StrictMode, instead use QUrl's default TolerantMode (as Modrinth seems to incorrectly handle spaces)
                 file.download = Json::requireValueString(Json::ensureArray(obj, "downloads").first(), "Download URL for " + file.path);
                 if (!file.download.isValid())
@@ -730,18 +758,27 @@ void InstanceImportTask::processModrinth() {
     instance.saveNow();
 
     m_filesNetJob = new NetJob(tr("Mod download"), APPLICATION->network());
+    m_storedFiles.reset(new ContentStore::Batch(APPLICATION->contentStore()));
     for (auto &file : files)
     {
         auto path = FS::PathCombine(m_stagingPath, ".minecraft", file.path);
-        qDebug() << "Will download" << file.download << "to" << path;
-        auto dl = Net::Download::makeFile(file.download, path);
-        dl->addValidator(new Net::ChecksumValidator(file.hashAlgorithm, file.hash));
+        // other platforms know their files by SHA-1, store them under that so they can share them
+        bool bySha1 = !file.sha1.isEmpty();
+        auto dl = m_storedFiles->add(file.download, bySha1 ? QCryptographicHash::Sha1 : file.hashAlgorithm, bySha1 ? file.sha1 : file.hash, path);
+        if(!dl)
+        {
+            continue;
+        }
+        if(bySha1 && file.hashAlgorithm != QCryptographicHash::Sha1)
+        {
+            dl->addValidator(new Net::ChecksumValidator(file.hashAlgorithm, file.hash));
+        }
         m_filesNetJob->addNetAction(dl);
     }
     connect(m_filesNetJob.get(), &NetJob::succeeded, this, [&]()
     {
         m_filesNetJob.reset();
-        emitSucceeded();
+        placeStoredFiles();
     });
     connect(m_filesNetJob.get(), &NetJob::failed, [&](const QString &reason)
     {
@@ -22,6 +22,7 @@
 #include <QFutureWatcher>
 #include "settings/SettingsObject.h"
 #include "QObjectPtr.h"
+#include "ContentStore.h"
 
 #include <nonstd/optional>
 
@@ -47,6 +48,8 @@ private:
     void processTechnic();
     void processCurseForge();
     void processModrinth();
+    // put the files of the stored batch into the instance and finish
+    void placeStoredFiles();
 
 private slots:
     void downloadSucceeded();
@@ -57,6 +60,7 @@ private slots:
 
 private: /* data */
     NetJob::Ptr m_filesNetJob;
+    std::unique_ptr<ContentStore::Batch> m_storedFiles;
     shared_qobject_ptr<CurseForge::FileResolvingTask> m_modIdResolver;
     QUrl m_sourceUrl;
     QString m_addonId;
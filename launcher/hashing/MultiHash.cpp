@@ -0,0 +1,192 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MultiHash.h"
+#include "Sha.h"
+
+#include <QFile>
+
+namespace Hashing {
+bool fromQt(QCryptographicHash::Algorithm qtAlgorithm, Algorithm &algorithm)
+{
+    switch(qtAlgorithm)
+    {
+        case QCryptographicHash::Md5:
+            algorithm = Algorithm::Md5;
+            return true;
+        case QCryptographicHash::Sha1:
+            algorithm = Algorithm::Sha1;
+            return true;
+        case QCryptographicHash::Sha256:
+            algorithm = Algorithm::Sha256;
+            return true;
+        case QCryptographicHash::Sha512:
+            algorithm = Algorithm::Sha512;
+            return true;
+        default:
+            return false;
+    }
+}
+
+MultiHash::MultiHash(Algorithms algorithms) : m_algorithms(algorithms)
+{
+    if(algorithms & Algorithm::Md5)
+    {
+        m_md5.reset(new QCryptographicHash(QCryptographicHash::Md5));
+    }
+    if(algorithms & Algorithm::Sha1)
+    {
+        m_sha1.reset(new Sha1());
+    }
+    if(algorithms & Algorithm::Sha256)
+    {
+        m_sha256.reset(new Sha256());
+    }
+    if(algorithms & Algorithm::Sha512)
+    {
+        m_sha512.reset(new QCryptographicHash(QCryptographicHash::Sha512));
+    }
+}
+
+MultiHash::~MultiHash() = default;
+
+void MultiHash::reset()
+{
+    if(m_md5)
+    {
+        m_md5->reset();
+    }
+    if(m_sha1)
+    {
+        m_sha1->reset();
+    }
+    if(m_sha256)
+    {
+        m_sha256->reset();
+    }
+    if(m_sha512)
+    {
+        m_sha512->reset();
+    }
+    m_finished = false;
+}
+
+void MultiHash::addData(const char *data, qint64 length)
+{
+    if(m_finished || length <= 0)
+    {
+        return;
+    }
+    auto bytes = reinterpret_cast<const uint8_t *>(data);
+    if(m_md5)
+    {
+        m_md5->addData(data, int(length));
+    }
+    if(m_sha1)
+    {
+        m_sha1->addData(bytes, length);
+    }
+    if(m_sha256)
+    {
+        m_sha256->addData(bytes, length);
+    }
+    if(m_sha512)
+    {
+        m_sha512->addData(data, int(length));
+    }
+}
+
+void MultiHash::addData(const QByteArray &data)
+{
+    addData(data.constData(), data.size());
+}
+
+bool MultiHash::addFile(const QString &path)
+{
+    QFile input(path);
+    if(!input.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    QByteArray buffer(1024 * 1024, Qt::Uninitialized);
+    qint64 read;
+    while((read = input.read(buffer.data(), buffer.size())) > 0)
+    {
+        addData(buffer.constData(), read);
+    }
+    return read == 0;
+}
+
+void MultiHash::finish()
+{
+    if(m_finished)
+    {
+        return;
+    }
+    m_finished = true;
+    if(m_md5)
+    {
+        m_md5Result = m_md5->result();
+    }
+    if(m_sha1)
+    {
+        m_sha1Result.resize(Sha1::digestSize);
+        m_sha1->result(reinterpret_cast<uint8_t *>(m_sha1Result.data()));
+    }
+    if(m_sha256)
+    {
+        m_sha256Result.resize(Sha256::digestSize);
+        m_sha256->result(reinterpret_cast<uint8_t *>(m_sha256Result.data()));
+    }
+    if(m_sha512)
+    {
+        m_sha512Result = m_sha512->result();
+    }
+}
+
+QByteArray MultiHash::result(Algorithm algorithm)
+{
+    finish();
+    switch(algorithm)
+    {
+        case Algorithm::Md5:
+            return m_md5Result;
+        case Algorithm::Sha1:
+            return m_sha1Result;
+        case Algorithm::Sha256:
+            return m_sha256Result;
+        case Algorithm::Sha512:
+            return m_sha512Result;
+    }
+    return QByteArray();
+}
+
+QByteArray MultiHash::hash(Algorithm algorithm, const QByteArray &data)
+{
+    MultiHash hasher(algorithm);
+    hasher.addData(data);
+    return hasher.result(algorithm);
+}
+
+QByteArray MultiHash::hashFile(Algorithm algorithm, const QString &path)
+{
+    MultiHash hasher(algorithm);
+    if(!hasher.addFile(path))
+    {
+        return QByteArray();
+    }
+    return hasher.result(algorithm);
+}
+}
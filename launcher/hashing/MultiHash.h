@@ -0,0 +1,88 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QFlags>
+#include <QString>
+#include <memory>
+
+namespace Hashing {
+class Sha1;
+class Sha256;
+
+enum class Algorithm
+{
+    Md5 = 0x1,
+    Sha1 = 0x2,
+    Sha256 = 0x4,
+    Sha512 = 0x8
+};
+Q_DECLARE_FLAGS(Algorithms, Algorithm)
+
+// the same algorithm as Qt knows it, false for the ones we don't do
+bool fromQt(QCryptographicHash::Algorithm qtAlgorithm, Algorithm &algorithm);
+
+/*
+ * Computes any number of digests over the same data in one pass, so a file only has to be read
+ * once no matter how many hashes we need of it.
+ *
+ * SHA-1 and SHA-256 use the SHA extensions of the CPU if there are any, the rest goes through
+ * QCryptographicHash.
+ */
+class MultiHash
+{
+public:
+    explicit MultiHash(Algorithms algorithms);
+    ~MultiHash();
+
+    void reset();
+    void addData(const char *data, qint64 length);
+    void addData(const QByteArray &data);
+    // reads the whole file into the hashes, false if it could not be read
+    bool addFile(const QString &path);
+
+    // finishes all the hashes on first use, only reset() makes the object usable for new data again
+    QByteArray result(Algorithm algorithm);
+
+    Algorithms algorithms() const
+    {
+        return m_algorithms;
+    }
+
+    static QByteArray hash(Algorithm algorithm, const QByteArray &data);
+    // empty if the file can't be read
+    static QByteArray hashFile(Algorithm algorithm, const QString &path);
+
+private:
+    void finish();
+
+private:
+    Algorithms m_algorithms;
+    bool m_finished = false;
+    std::unique_ptr<QCryptographicHash> m_md5;
+    std::unique_ptr<Sha1> m_sha1;
+    std::unique_ptr<Sha256> m_sha256;
+    std::unique_ptr<QCryptographicHash> m_sha512;
+    QByteArray m_md5Result;
+    QByteArray m_sha1Result;
+    QByteArray m_sha256Result;
+    QByteArray m_sha512Result;
+};
+}
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(Hashing::Algorithms)
@@ -0,0 +1,113 @@
+#include <QTest>
+#include <QCryptographicHash>
+#include <functional>
+#include <random>
+
+#include "hashing/MultiHash.h"
+#include "hashing/Sha.h"
+
+/*
+ * Compares the hashing engine with QCryptographicHash, for a 64 MiB buffer fed in 1 MiB chunks
+ * like the file readers do. The combined row is what hashing a download for every index that
+ * might ask for it costs, once with a pass per digest and once in a single pass.
+ *
+ * Built as MultiHash_benchmark, ctest doesn't run it.
+ */
+class MultiHashBenchmark : public QObject
+{
+    Q_OBJECT
+
+    QByteArray m_data;
+
+    void feed(const std::function<void(const char *, int)> &add)
+    {
+        const int chunk = 1024 * 1024;
+        for(int offset = 0; offset < m_data.size(); offset += chunk)
+        {
+            add(m_data.constData() + offset, qMin(chunk, m_data.size() - offset));
+        }
+    }
+
+private
+slots:
+    void initTestCase()
+    {
+        std::mt19937 eng(42);
+        m_data.resize(64 * 1024 * 1024);
+        for(int i = 0; i < m_data.size(); i++)
+        {
+            m_data[i] = char(eng());
+        }
+        qDebug() << "SHA extensions:" << Hashing::hardwareSha();
+    }
+
+    void bench_qt_data()
+    {
+        QTest::addColumn<int>("algorithm");
+        QTest::newRow("md5") << int(QCryptographicHash::Md5);
+        QTest::newRow("sha1") << int(QCryptographicHash::Sha1);
+        QTest::newRow("sha256") << int(QCryptographicHash::Sha256);
+        QTest::newRow("sha512") << int(QCryptographicHash::Sha512);
+    }
+    void bench_qt()
+    {
+        QFETCH(int, algorithm);
+        QBENCHMARK
+        {
+            QCryptographicHash hash(QCryptographicHash::Algorithm(algorithm));
+            feed([&](const char *data, int length) { hash.addData(data, length); });
+            hash.result();
+        }
+    }
+
+    void bench_engine_data()
+    {
+        QTest::addColumn<int>("algorithm");
+        QTest::addColumn<bool>("hardware");
+        QTest::newRow("md5") << int(Hashing::Algorithm::Md5) << true;
+        QTest::newRow("sha1") << int(Hashing::Algorithm::Sha1) << true;
+        QTest::newRow("sha1 portable") << int(Hashing::Algorithm::Sha1) << false;
+        QTest::newRow("sha256") << int(Hashing::Algorithm::Sha256) << true;
+        QTest::newRow("sha256 portable") << int(Hashing::Algorithm::Sha256) << false;
+        QTest::newRow("sha512") << int(Hashing::Algorithm::Sha512) << true;
+    }
+    void bench_engine()
+    {
+        QFETCH(int, algorithm);
+        QFETCH(bool, hardware);
+        Hashing::setHardwareShaEnabled(hardware);
+        QBENCHMARK
+        {
+            Hashing::MultiHash hash(Hashing::Algorithm(algorithm));
+            feed([&](const char *data, int length) { hash.addData(data, length); });
+            hash.result(Hashing::Algorithm(algorithm));
+        }
+        Hashing::setHardwareShaEnabled(true);
+    }
+
+    void bench_combined_qt()
+    {
+        QBENCHMARK
+        {
+            for(auto algorithm : {QCryptographicHash::Md5, QCryptographicHash::Sha1, QCryptographicHash::Sha256})
+            {
+                QCryptographicHash hash(algorithm);
+                feed([&](const char *data, int length) { hash.addData(data, length); });
+                hash.result();
+            }
+        }
+    }
+    void bench_combined_engine()
+    {
+        QBENCHMARK
+        {
+            Hashing::MultiHash hash(Hashing::Algorithm::Md5 | Hashing::Algorithm::Sha1 | Hashing::Algorithm::Sha256);
+            feed([&](const char *data, int length) { hash.addData(data, length); });
+            hash.result(Hashing::Algorithm::Sha1);
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(MultiHashBenchmark)
+
+#include "MultiHash_benchmark.moc"
@@ -0,0 +1,112 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QFile>
+#include "TestUtil.h"
+
+#include "hashing/MultiHash.h"
+#include "hashing/Sha.h"
+#include <random>
+
+class MultiHashTest : public QObject
+{
+    Q_OBJECT
+
+    QByteArray randomData(int size)
+    {
+        std::mt19937 eng(size);
+        QByteArray data(size, Qt::Uninitialized);
+        for(int i = 0; i < size; i++)
+        {
+            data[i] = char(eng());
+        }
+        return data;
+    }
+
+    void compareAll(const QByteArray &data, int chunk)
+    {
+        Hashing::MultiHash hasher(Hashing::Algorithm::Md5 | Hashing::Algorithm::Sha1 | Hashing::Algorithm::Sha256 | Hashing::Algorithm::Sha512);
+        for(int offset = 0; offset < data.size(); offset += chunk)
+        {
+            hasher.addData(data.constData() + offset, qMin(chunk, data.size() - offset));
+        }
+        QCOMPARE(hasher.result(Hashing::Algorithm::Md5), QCryptographicHash::hash(data, QCryptographicHash::Md5));
+        QCOMPARE(hasher.result(Hashing::Algorithm::Sha1), QCryptographicHash::hash(data, QCryptographicHash::Sha1));
+        QCOMPARE(hasher.result(Hashing::Algorithm::Sha256), QCryptographicHash::hash(data, QCryptographicHash::Sha256));
+        QCOMPARE(hasher.result(Hashing::Algorithm::Sha512), QCryptographicHash::hash(data, QCryptographicHash::Sha512));
+    }
+
+private
+slots:
+    void cleanup()
+    {
+        Hashing::setHardwareShaEnabled(true);
+    }
+
+    void test_matchesQt_data()
+    {
+        QTest::addColumn<bool>("hardware");
+        QTest::addColumn<int>("size");
+        QTest::addColumn<int>("chunk");
+        // around the block and padding boundaries, fed whole and in odd chunks
+        for(bool hardware : {true, false})
+        {
+            for(int size : {0, 1, 55, 56, 63, 64, 65, 119, 120, 128, 1000, 1024 * 1024 + 7})
+            {
+                for(int chunk : {1 << 30, 1, 7, 64, 100})
+                {
+                    if(size > 100000 && chunk < 64)
+                    {
+                        continue;
+                    }
+                    auto name = QString("%1 %2 bytes in %3").arg(hardware ? "hardware" : "portable").arg(size).arg(chunk);
+                    QTest::newRow(name.toUtf8().constData()) << hardware << size << chunk;
+                }
+            }
+        }
+    }
+    void test_matchesQt()
+    {
+        QFETCH(bool, hardware);
+        QFETCH(int, size);
+        QFETCH(int, chunk);
+        Hashing::setHardwareShaEnabled(hardware);
+        compareAll(randomData(size), chunk);
+    }
+
+    void test_knownVectors()
+    {
+        for(bool hardware : {true, false})
+        {
+            Hashing::setHardwareShaEnabled(hardware);
+            QCOMPARE(Hashing::MultiHash::hash(Hashing::Algorithm::Sha1, "abc").toHex(), QByteArray("a9993e364706816aba3e25717850c26c9cd0d89d"));
+            QCOMPARE(Hashing::MultiHash::hash(Hashing::Algorithm::Sha256, "").toHex(),
+                     QByteArray("e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"));
+            QCOMPARE(Hashing::MultiHash::hash(Hashing::Algorithm::Sha256, "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq").toHex(),
+                     QByteArray("248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"));
+        }
+    }
+
+    void test_file()
+    {
+        QTemporaryDir dir;
+        auto data = randomData(3 * 1024 * 1024 + 11);
+        auto path = dir.filePath("file");
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(data);
+        file.close();
+
+        Hashing::MultiHash hasher(Hashing::Algorithm::Sha1 | Hashing::Algorithm::Sha512);
+        QVERIFY(hasher.addFile(path));
+        QCOMPARE(hasher.result(Hashing::Algorithm::Sha1), QCryptographicHash::hash(data, QCryptographicHash::Sha1));
+        QCOMPARE(hasher.result(Hashing::Algorithm::Sha512), QCryptographicHash::hash(data, QCryptographicHash::Sha512));
+        // not asked for
+        QVERIFY(hasher.result(Hashing::Algorithm::Md5).isEmpty());
+
+        QVERIFY(Hashing::MultiHash::hashFile(Hashing::Algorithm::Sha1, dir.filePath("missing")).isEmpty());
+    }
+};
+
+QTEST_GUILESS_MAIN(MultiHashTest)
+
+#include "MultiHash_test.moc"
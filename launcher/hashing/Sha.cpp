@@ -0,0 +1,503 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Sha.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define HASHING_X86 1
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define HASHING_TARGET_SHA
+    #else
+        #include <cpuid.h>
+        #define HASHING_TARGET_SHA __attribute__((target("sha,sse4.1,ssse3")))
+    #endif
+#elif (defined(__aarch64__) || defined(_M_ARM64)) && (defined(__ARM_FEATURE_SHA2) || defined(__ARM_FEATURE_CRYPTO))
+    #define HASHING_ARM 1
+    #include <arm_neon.h>
+#endif
+
+namespace Hashing {
+namespace {
+const uint32_t sha256K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+inline uint32_t rol(uint32_t x, int n)
+{
+    return (x << n) | (x >> (32 - n));
+}
+
+inline uint32_t ror(uint32_t x, int n)
+{
+    return (x >> n) | (x << (32 - n));
+}
+
+inline uint32_t loadBigEndian(const uint8_t *p)
+{
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+void sha1Portable(uint32_t state[5], const uint8_t *data, size_t blocks)
+{
+    uint32_t w[80];
+    while(blocks--)
+    {
+        for(int i = 0; i < 16; i++)
+        {
+            w[i] = loadBigEndian(data + i * 4);
+        }
+        for(int i = 16; i < 80; i++)
+        {
+            w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+        for(int i = 0; i < 80; i++)
+        {
+            uint32_t f, k;
+            if(i < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5a827999;
+            }
+            else if(i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ed9eba1;
+            }
+            else if(i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8f1bbcdc;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xca62c1d6;
+            }
+            uint32_t t = rol(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rol(b, 30);
+            b = a;
+            a = t;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        data += 64;
+    }
+}
+
+void sha256Portable(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    uint32_t w[64];
+    while(blocks--)
+    {
+        for(int i = 0; i < 16; i++)
+        {
+            w[i] = loadBigEndian(data + i * 4);
+        }
+        for(int i = 16; i < 64; i++)
+        {
+            uint32_t s0 = ror(w[i - 15], 7) ^ ror(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = ror(w[i - 2], 17) ^ ror(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for(int i = 0; i < 64; i++)
+        {
+            uint32_t s1 = ror(e, 6) ^ ror(e, 11) ^ ror(e, 25);
+            uint32_t ch = (e & f) ^ (~e & g);
+            uint32_t t1 = h + s1 + ch + sha256K[i] + w[i];
+            uint32_t s0 = ror(a, 2) ^ ror(a, 13) ^ ror(a, 22);
+            uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+            uint32_t t2 = s0 + maj;
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a;
+        state[1] += b;
+        state[2] += c;
+        state[3] += d;
+        state[4] += e;
+        state[5] += f;
+        state[6] += g;
+        state[7] += h;
+        data += 64;
+    }
+}
+
+#if defined(HASHING_X86)
+bool detectSha()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7)
+    {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool sse41 = info[2] & (1 << 19);
+    bool ssse3 = info[2] & (1 << 9);
+    __cpuidex(info, 7, 0);
+    bool sha = info[1] & (1 << 29);
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        return false;
+    }
+    bool sse41 = ecx & (1 << 19);
+    bool ssse3 = ecx & (1 << 9);
+    if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+    {
+        return false;
+    }
+    bool sha = ebx & (1 << 29);
+#endif
+    return sha && sse41 && ssse3;
+}
+
+// one group of four rounds, the round function has to be an immediate
+template <int Function>
+HASHING_TARGET_SHA inline void sha1Rounds(__m128i &abcd, __m128i &e, __m128i &previous, __m128i w)
+{
+    e = _mm_sha1nexte_epu32(previous, w);
+    previous = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, e, Function);
+}
+
+// the next four words of the schedule, from the last sixteen
+HASHING_TARGET_SHA inline void sha1Schedule(__m128i w[4], int g)
+{
+    w[g % 4] = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(w[g % 4], w[(g + 1) % 4]), w[(g + 2) % 4]), w[(g + 3) % 4]);
+}
+
+HASHING_TARGET_SHA void sha1Hardware(uint32_t state[5], const uint8_t *data, size_t blocks)
+{
+    const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+    __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0x1B);
+    __m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+    while(blocks--)
+    {
+        __m128i abcdSaved = abcd;
+        __m128i eSaved = e0;
+        __m128i w[4];
+        for(int i = 0; i < 4; i++)
+        {
+            w[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + i * 16)), mask);
+        }
+        __m128i e = _mm_add_epi32(e0, w[0]);
+        __m128i previous = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+        int g = 1;
+        for(; g < 5; g++)
+        {
+            if(g >= 4)
+            {
+                sha1Schedule(w, g);
+            }
+            sha1Rounds<0>(abcd, e, previous, w[g % 4]);
+        }
+        for(; g < 10; g++)
+        {
+            sha1Schedule(w, g);
+            sha1Rounds<1>(abcd, e, previous, w[g % 4]);
+        }
+        for(; g < 15; g++)
+        {
+            sha1Schedule(w, g);
+            sha1Rounds<2>(abcd, e, previous, w[g % 4]);
+        }
+        for(; g < 20; g++)
+        {
+            sha1Schedule(w, g);
+            sha1Rounds<3>(abcd, e, previous, w[g % 4]);
+        }
+        e0 = _mm_sha1nexte_epu32(previous, eSaved);
+        abcd = _mm_add_epi32(abcd, abcdSaved);
+        data += 64;
+    }
+    _mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = _mm_extract_epi32(e0, 3);
+}
+
+HASHING_TARGET_SHA void sha256Hardware(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B);
+    // the instructions want the state as ABEF and CDGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+    while(blocks--)
+    {
+        __m128i state0Saved = state0;
+        __m128i state1Saved = state1;
+        __m128i w[4];
+        for(int i = 0; i < 4; i++)
+        {
+            w[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + i * 16)), mask);
+        }
+        for(int g = 0; g < 16; g++)
+        {
+            auto &current = w[g % 4];
+            if(g >= 4)
+            {
+                __m128i last = w[(g + 3) % 4];
+                current = _mm_add_epi32(_mm_sha256msg1_epu32(current, w[(g + 1) % 4]), _mm_alignr_epi8(last, w[(g + 2) % 4], 4));
+                current = _mm_sha256msg2_epu32(current, last);
+            }
+            __m128i message = _mm_add_epi32(current, _mm_loadu_si128((const __m128i *)&sha256K[g * 4]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, message);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(message, 0x0E));
+        }
+        state0 = _mm_add_epi32(state0, state0Saved);
+        state1 = _mm_add_epi32(state1, state1Saved);
+        data += 64;
+    }
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    _mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, state1, 0xF0));
+    _mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+#elif defined(HASHING_ARM)
+bool detectSha()
+{
+    return true;
+}
+
+void sha1Hardware(uint32_t state[5], const uint8_t *data, size_t blocks)
+{
+    const uint32_t k[4] = {0x5a827999, 0x6ed9eba1, 0x8f1bbcdc, 0xca62c1d6};
+    uint32x4_t abcd = vld1q_u32(state);
+    uint32_t e0 = state[4];
+    while(blocks--)
+    {
+        uint32x4_t abcdSaved = abcd;
+        uint32_t eSaved = e0;
+        uint32x4_t w[4];
+        for(int i = 0; i < 4; i++)
+        {
+            w[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + i * 16)));
+        }
+        uint32_t e = e0;
+        for(int g = 0; g < 20; g++)
+        {
+            auto &current = w[g % 4];
+            if(g >= 4)
+            {
+                current = vsha1su1q_u32(vsha1su0q_u32(current, w[(g + 1) % 4], w[(g + 2) % 4]), w[(g + 3) % 4]);
+            }
+            uint32x4_t message = vaddq_u32(current, vdupq_n_u32(k[g / 5]));
+            uint32_t next = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+            switch(g / 5)
+            {
+                case 0:
+                    abcd = vsha1cq_u32(abcd, e, message);
+                    break;
+                case 2:
+                    abcd = vsha1mq_u32(abcd, e, message);
+                    break;
+                default:
+                    abcd = vsha1pq_u32(abcd, e, message);
+                    break;
+            }
+            e = next;
+        }
+        e0 = e + eSaved;
+        abcd = vaddq_u32(abcd, abcdSaved);
+        data += 64;
+    }
+    vst1q_u32(state, abcd);
+    state[4] = e0;
+}
+
+void sha256Hardware(uint32_t state[8], const uint8_t *data, size_t blocks)
+{
+    uint32x4_t state0 = vld1q_u32(&state[0]);
+    uint32x4_t state1 = vld1q_u32(&state[4]);
+    while(blocks--)
+    {
+        uint32x4_t state0Saved = state0;
+        uint32x4_t state1Saved = state1;
+        uint32x4_t w[4];
+        for(int i = 0; i < 4; i++)
+        {
+            w[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + i * 16)));
+        }
+        for(int g = 0; g < 16; g++)
+        {
+            auto &current = w[g % 4];
+            if(g >= 4)
+            {
+                current = vsha256su1q_u32(vsha256su0q_u32(current, w[(g + 1) % 4]), w[(g + 2) % 4], w[(g + 3) % 4]);
+            }
+            uint32x4_t message = vaddq_u32(current, vld1q_u32(&sha256K[g * 4]));
+            uint32x4_t previous = state0;
+            state0 = vsha256hq_u32(state0, state1, message);
+            state1 = vsha256h2q_u32(state1, previous, message);
+        }
+        state0 = vaddq_u32(state0, state0Saved);
+        state1 = vaddq_u32(state1, state1Saved);
+        data += 64;
+    }
+    vst1q_u32(&state[0], state0);
+    vst1q_u32(&state[4], state1);
+}
+#endif
+
+#if defined(HASHING_X86) || defined(HASHING_ARM)
+const bool hasSha = detectSha();
+bool useSha = hasSha;
+#else
+const bool hasSha = false;
+bool useSha = false;
+#endif
+}
+
+bool hardwareSha()
+{
+    return useSha;
+}
+
+void setHardwareShaEnabled(bool enabled)
+{
+    useSha = enabled && hasSha;
+}
+
+template <>
+void ShaBase<5, 20>::compress(const uint8_t *blocks, size_t count)
+{
+#if defined(HASHING_X86) || defined(HASHING_ARM)
+    if(useSha)
+    {
+        sha1Hardware(m_state, blocks, count);
+        return;
+    }
+#endif
+    sha1Portable(m_state, blocks, count);
+}
+
+template <>
+void ShaBase<8, 32>::compress(const uint8_t *blocks, size_t count)
+{
+#if defined(HASHING_X86) || defined(HASHING_ARM)
+    if(useSha)
+    {
+        sha256Hardware(m_state, blocks, count);
+        return;
+    }
+#endif
+    sha256Portable(m_state, blocks, count);
+}
+
+template <int StateWords, int DigestBytes>
+void ShaBase<StateWords, DigestBytes>::addData(const uint8_t *data, size_t length)
+{
+    m_length += length;
+    if(m_buffered)
+    {
+        size_t take = std::min(length, 64 - m_buffered);
+        memcpy(m_buffer + m_buffered, data, take);
+        m_buffered += take;
+        data += take;
+        length -= take;
+        if(m_buffered < 64)
+        {
+            return;
+        }
+        compress(m_buffer, 1);
+        m_buffered = 0;
+    }
+    if(length >= 64)
+    {
+        compress(data, length / 64);
+        data += length - length % 64;
+        length %= 64;
+    }
+    memcpy(m_buffer, data, length);
+    m_buffered = length;
+}
+
+template <int StateWords, int DigestBytes>
+void ShaBase<StateWords, DigestBytes>::result(uint8_t *out)
+{
+    uint64_t bits = m_length * 8;
+    m_buffer[m_buffered++] = 0x80;
+    if(m_buffered > 56)
+    {
+        memset(m_buffer + m_buffered, 0, 64 - m_buffered);
+        compress(m_buffer, 1);
+        m_buffered = 0;
+    }
+    memset(m_buffer + m_buffered, 0, 56 - m_buffered);
+    for(int i = 0; i < 8; i++)
+    {
+        m_buffer[56 + i] = uint8_t(bits >> (56 - i * 8));
+    }
+    compress(m_buffer, 1);
+    for(int i = 0; i < DigestBytes / 4; i++)
+    {
+        out[i * 4] = uint8_t(m_state[i] >> 24);
+        out[i * 4 + 1] = uint8_t(m_state[i] >> 16);
+        out[i * 4 + 2] = uint8_t(m_state[i] >> 8);
+        out[i * 4 + 3] = uint8_t(m_state[i]);
+    }
+}
+
+template class ShaBase<5, 20>;
+template class ShaBase<8, 32>;
+
+void Sha1::reset()
+{
+    const uint32_t initial[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+    memcpy(m_state, initial, sizeof(initial));
+    m_length = 0;
+    m_buffered = 0;
+}
+
+void Sha256::reset()
+{
+    const uint32_t initial[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    memcpy(m_state, initial, sizeof(initial));
+    m_length = 0;
+    m_buffered = 0;
+}
+}
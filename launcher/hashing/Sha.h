@@ -0,0 +1,71 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Hashing {
+/*
+ * SHA-1 and SHA-256, using the SHA extensions of the CPU when it has them.
+ *
+ * x86 CPUs are checked at runtime. On ARM the extensions are used when the compiler targets
+ * them (Apple Silicon does by default).
+ */
+template <int StateWords, int DigestBytes>
+class ShaBase
+{
+public:
+    static const int digestSize = DigestBytes;
+
+    void addData(const uint8_t *data, size_t length);
+    // the digest, after which the object has to be reset to be used again
+    void result(uint8_t *out);
+
+protected:
+    void compress(const uint8_t *blocks, size_t count);
+
+    uint32_t m_state[StateWords];
+    uint64_t m_length = 0;
+    uint8_t m_buffer[64];
+    size_t m_buffered = 0;
+};
+
+class Sha1 : public ShaBase<5, 20>
+{
+public:
+    Sha1()
+    {
+        reset();
+    }
+    void reset();
+};
+
+class Sha256 : public ShaBase<8, 32>
+{
+public:
+    Sha256()
+    {
+        reset();
+    }
+    void reset();
+};
+
+// whether the CPU does SHA-1 and SHA-256 in hardware, for logs and benchmarks
+bool hardwareSha();
+// force the portable code, for testing it on CPUs with the extensions
+void setHardwareShaEnabled(bool enabled);
+}
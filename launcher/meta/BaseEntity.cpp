@@ -118,6 +118,7 @@ void Meta::BaseEntity::load(Net::Mode loadType)
         return;
     }
     m_updateTask = new NetJob(QObject::tr("Download of meta file %1").arg(localFilename()), APPLICATION->network());
+    m_updateTask->setPriority(Net::Priority::Interactive);
     auto url = this->url();
     auto entry = APPLICATION->metacache()->resolveEntry("meta", localFilename());
     entry->setStale(true);
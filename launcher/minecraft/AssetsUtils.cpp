@@ -20,13 +20,24 @@
 #include <QJsonParseError>
 #include <QJsonDocument>
 #include <QJsonObject>
-#include <QVariant>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QMutex>
+#include <QHash>
+#include <QSet>
+#include <QtConcurrentMap>
+#include <QtConcurrentFilter>
+#include <QDateTime>
 #include <QDebug>
+#include <algorithm>
+#include <cstring>
 
 #include "AssetsUtils.h"
 #include "FileSystem.h"
 #include "net/Download.h"
 #include "net/ChecksumValidator.h"
+#include "hashing/MultiHash.h"
+#include "VerifiedObjects.h"
 #include "BuildConfig.h"
 
 #include "Application.h"
@@ -51,58 +62,181 @@ QSet<QString> collectPathsFromDir(QString dirPath)
         if(info.isFile())
         {
             out.insert(value);
-            qDebug() << value;
         }
     }
     return out;
 }
-}
 
+const quint32 MANIFEST_MAGIC = 0x41534D46; // "ASMF"
+const quint32 MANIFEST_VERSION = 1;
 
-namespace AssetsUtils
+// what reconstructAssets placed in a target folder
+struct ReconstructManifest
 {
+    QByteArray indexHash;
+    // false if some objects were missing, so the folder has to be looked at again
+    bool complete = false;
+    // relative path to the raw hash of the object placed there
+    QHash<QString, QByteArray> files;
+};
+
+bool readManifest(const QString &path, ReconstructManifest &manifest)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != MANIFEST_MAGIC || version != MANIFEST_VERSION)
+    {
+        return false;
+    }
+    in >> manifest.indexHash >> manifest.complete >> manifest.files;
+    return in.status() == QDataStream::Ok;
+}
 
-/*
- * Returns true on success, with index populated
- * index is undefined otherwise
- */
-bool loadAssetsIndexJson(const QString &assetsId, const QString &path, AssetsIndex& index)
+void writeManifest(const QString &path, const ReconstructManifest &manifest)
 {
-    /*
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_0);
+        out << MANIFEST_MAGIC << MANIFEST_VERSION << manifest.indexHash << manifest.complete << manifest.files;
+    }
+    if (!FS::ensureFilePathExists(path))
+    {
+        qWarning() << "Could not create folder for" << path;
+        return;
+    }
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly) || out.write(data) != data.size() || !out.commit())
     {
-      "objects": {
-        "icons/icon_16x16.png": {
-          "hash": "bdf48ef6b5d0d23bbb02e17d04865216179f510a",
-          "size": 3665
-        },
-        ...
+        qWarning() << "Could not write" << path << ":" << out.errorString();
+    }
+}
+
+// removes the file, and the folders it leaves empty up to the root
+void removeWithEmptyParents(const QString &root, const QString &file)
+{
+    QFile::remove(file);
+    QString rootPath = QDir(root).absolutePath();
+    QString current = QFileInfo(file).absolutePath();
+    while (current.startsWith(rootPath + "/"))
+    {
+        QFileInfo info(current);
+        if (!info.dir().rmdir(info.fileName()))
+        {
+            break;
         }
-      }
+        current = info.absolutePath();
     }
-    */
+}
+}
 
-    QFile file(path);
 
-    // Try to open the file and fail if we can't.
-    // TODO: We should probably report this error to the user.
-    if (!file.open(QIODevice::ReadOnly))
+namespace AssetsUtils
+{
+
+namespace {
+const quint32 INDEX_CACHE_MAGIC = 0x41534958; // "ASIX"
+const quint32 INDEX_CACHE_VERSION = 1;
+
+struct CachedIndex
+{
+    QString path;
+    qint64 fileSize = -1;
+    qint64 modified = -1;
+    QByteArray sourceHash;
+    AssetsIndex index;
+};
+
+QMutex indexCacheLock;
+QHash<QString, CachedIndex> indexCache;
+
+struct ParsedChunk
+{
+    QVector<AssetsIndex::Entry> entries;
+    QByteArray paths;
+    bool valid = true;
+};
+
+bool parseHash(const QString &hex, quint8 *out)
+{
+    if(hex.size() != 40)
     {
-        qCritical() << "Failed to read assets index file" << path;
         return false;
     }
-    index.id = assetsId;
+    // fromHex skips what isn't hex, so anything odd comes out short
+    auto raw = QByteArray::fromHex(hex.toLatin1());
+    if(raw.size() != 20)
+    {
+        return false;
+    }
+    memcpy(out, raw.constData(), 20);
+    return true;
+}
 
-    // Read the file and close it.
-    QByteArray jsonData = file.readAll();
-    file.close();
+ParsedChunk parseObjects(const QJsonObject &objects, int from, int to)
+{
+    ParsedChunk chunk;
+    chunk.entries.reserve(to - from);
+    auto iter = objects.constBegin() + from;
+    for(int i = from; i < to; i++, ++iter)
+    {
+        auto object = iter.value().toObject();
+        AssetsIndex::Entry entry;
+        if(!parseHash(object.value("hash").toString(), entry.hash))
+        {
+            qCritical() << "Invalid hash for asset" << iter.key();
+            chunk.valid = false;
+            return chunk;
+        }
+        entry.size = object.value("size").toDouble();
+        auto path = iter.key().toUtf8();
+        entry.pathOffset = chunk.paths.size();
+        entry.pathLength = path.size();
+        chunk.paths.append(path);
+        chunk.entries.append(entry);
+    }
+    return chunk;
+}
+
+int comparePath(const QByteArray &paths, const AssetsIndex::Entry &entry, const char *path, quint32 length)
+{
+    int result = memcmp(paths.constData() + entry.pathOffset, path, qMin(entry.pathLength, length));
+    if(result != 0)
+    {
+        return result;
+    }
+    return entry.pathLength < length ? -1 : (entry.pathLength > length ? 1 : 0);
+}
 
+/*
+{
+  "objects": {
+    "icons/icon_16x16.png": {
+      "hash": "bdf48ef6b5d0d23bbb02e17d04865216179f510a",
+      "size": 3665
+    },
+    ...
+    }
+  }
+}
+*/
+bool parseIndex(const QString &path, const QByteArray &jsonData, AssetsIndex &index)
+{
     QJsonParseError parseError;
     QJsonDocument jsonDoc = QJsonDocument::fromJson(jsonData, &parseError);
 
     // Fail if the JSON is invalid.
     if (parseError.error != QJsonParseError::NoError)
     {
-        qCritical() << "Failed to parse assets index file:" << parseError.errorString()
+        qCritical() << "Failed to parse assets index file" << path << ":" << parseError.errorString()
                      << "at offset " << QString::number(parseError.offset);
         return false;
     }
@@ -115,53 +249,277 @@ bool loadAssetsIndexJson(const QString &assetsId, const QString &path, AssetsInd
     }
 
     QJsonObject root = jsonDoc.object();
+    index.isVirtual = root.value("virtual").toBool(false);
+    index.mapToResources = root.value("map_to_resources").toBool(false);
+
+    // big indexes are converted in chunks, on all cores
+    const QJsonObject objects = root.value("objects").toObject();
+    const int chunkSize = 1024;
+    QList<QPair<int, int>> ranges;
+    for(int from = 0; from < objects.size(); from += chunkSize)
+    {
+        ranges.append(qMakePair(from, qMin(from + chunkSize, objects.size())));
+    }
+    std::function<ParsedChunk(const QPair<int, int> &)> parseRange = [&objects](const QPair<int, int> &range)
+    {
+        return parseObjects(objects, range.first, range.second);
+    };
+    QList<ParsedChunk> chunks;
+    if(ranges.size() > 1)
+    {
+        chunks = QtConcurrent::blockingMapped<QList<ParsedChunk>>(ranges, parseRange);
+    }
+    else if(ranges.size() == 1)
+    {
+        chunks.append(parseRange(ranges.first()));
+    }
 
-    QJsonValue isVirtual = root.value("virtual");
-    if (!isVirtual.isUndefined())
+    index.entries.clear();
+    index.entries.reserve(objects.size());
+    index.paths.clear();
+    for(auto &chunk: chunks)
     {
-        index.isVirtual = isVirtual.toBool(false);
+        if(!chunk.valid)
+        {
+            return false;
+        }
+        quint32 base = index.paths.size();
+        index.paths.append(chunk.paths);
+        for(auto entry: chunk.entries)
+        {
+            entry.pathOffset += base;
+            index.entries.append(entry);
+        }
     }
+    const QByteArray &paths = index.paths;
+    std::sort(index.entries.begin(), index.entries.end(), [&paths](const AssetsIndex::Entry &a, const AssetsIndex::Entry &b)
+    {
+        return comparePath(paths, a, paths.constData() + b.pathOffset, b.pathLength) < 0;
+    });
+    return true;
+}
 
-    QJsonValue mapToResources = root.value("map_to_resources");
-    if (!mapToResources.isUndefined())
+QString binaryIndexPath(const QString &indexPath, const QString &assetsId)
+{
+    return FS::PathCombine(QFileInfo(indexPath).absolutePath(), "parsed", assetsId + ".bin");
+}
+
+bool readBinaryIndex(const QString &path, const QByteArray &sourceHash, AssetsIndex &index)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QByteArray hash;
+    in >> magic >> version >> hash;
+    if (in.status() != QDataStream::Ok || magic != INDEX_CACHE_MAGIC || version != INDEX_CACHE_VERSION || hash != sourceHash)
+    {
+        return false;
+    }
+    bool isVirtual = false;
+    bool mapToResources = false;
+    QByteArray paths;
+    quint32 count = 0;
+    in >> isVirtual >> mapToResources >> paths >> count;
+    // every path has at least one byte, so this also catches garbage counts
+    if (in.status() != QDataStream::Ok || count > quint32(paths.size()))
+    {
+        return false;
+    }
+    QVector<AssetsIndex::Entry> entries(count);
+    for (auto &entry: entries)
+    {
+        in >> entry.pathOffset >> entry.pathLength >> entry.size;
+        if (in.readRawData(reinterpret_cast<char *>(entry.hash), 20) != 20)
+        {
+            return false;
+        }
+        if (quint64(entry.pathOffset) + entry.pathLength > quint64(paths.size()))
+        {
+            return false;
+        }
+    }
+    if (in.status() != QDataStream::Ok)
     {
-        index.mapToResources = mapToResources.toBool(false);
+        return false;
     }
+    index.isVirtual = isVirtual;
+    index.mapToResources = mapToResources;
+    index.paths = paths;
+    index.entries = entries;
+    return true;
+}
 
-    QJsonValue objects = root.value("objects");
-    QVariantMap map = objects.toVariant().toMap();
+void writeBinaryIndex(const QString &path, const QByteArray &sourceHash, const AssetsIndex &index)
+{
+    QByteArray data;
+    {
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_0);
+        out << INDEX_CACHE_MAGIC << INDEX_CACHE_VERSION << sourceHash;
+        out << index.isVirtual << index.mapToResources << index.paths << quint32(index.entries.size());
+        for (auto &entry: index.entries)
+        {
+            out << entry.pathOffset << entry.pathLength << entry.size;
+            out.writeRawData(reinterpret_cast<const char *>(entry.hash), 20);
+        }
+    }
+    if (!FS::ensureFilePathExists(path))
+    {
+        qWarning() << "Could not create folder for" << path;
+        return;
+    }
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly) || out.write(data) != data.size() || !out.commit())
+    {
+        qWarning() << "Could not write" << path << ":" << out.errorString();
+    }
+}
+}
 
-    for (QVariantMap::const_iterator iter = map.begin(); iter != map.end(); ++iter)
+/*
+ * Returns true on success, with index populated
+ * index is undefined otherwise
+ */
+bool loadAssetsIndexJson(const QString &assetsId, const QString &path, AssetsIndex& index)
+{
+    QFileInfo info(path);
+    auto absolutePath = info.absoluteFilePath();
+    qint64 modified = info.lastModified().toMSecsSinceEpoch();
     {
-        // qDebug() << iter.key();
+        QMutexLocker locker(&indexCacheLock);
+        auto iter = indexCache.constFind(assetsId);
+        if (iter != indexCache.constEnd() && info.isFile() && iter->path == absolutePath && iter->fileSize == info.size() && iter->modified == modified)
+        {
+            index = iter->index;
+            return true;
+        }
+    }
 
-        QVariant variant = iter.value();
-        QVariantMap nested_objects = variant.toMap();
+    QFile file(path);
 
-        AssetObject object;
+    // Try to open the file and fail if we can't.
+    // TODO: We should probably report this error to the user.
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qCritical() << "Failed to read assets index file" << path;
+        return false;
+    }
 
-        for (QVariantMap::const_iterator nested_iter = nested_objects.begin();
-             nested_iter != nested_objects.end(); ++nested_iter)
-        {
-            // qDebug() << nested_iter.key() << nested_iter.value().toString();
-            QString key = nested_iter.key();
-            QVariant value = nested_iter.value();
+    // Read the file and close it.
+    QByteArray jsonData = file.readAll();
+    file.close();
 
-            if (key == "hash")
-            {
-                object.hash = value.toString();
-            }
-            else if (key == "size")
-            {
-                object.size = value.toDouble();
-            }
+    // the file changed on disk or wasn't loaded yet, but it may still be what we have
+    auto sourceHash = Hashing::MultiHash::hash(Hashing::Algorithm::Sha1, jsonData);
+    bool loaded = false;
+    {
+        QMutexLocker locker(&indexCacheLock);
+        auto iter = indexCache.constFind(assetsId);
+        if (iter != indexCache.constEnd() && iter->sourceHash == sourceHash)
+        {
+            index = iter->index;
+            loaded = true;
         }
-
-        index.objects.insert(iter.key(), object);
     }
+    auto binaryPath = binaryIndexPath(path, assetsId);
+    if (!loaded && !readBinaryIndex(binaryPath, sourceHash, index))
+    {
+        if (!parseIndex(path, jsonData, index))
+        {
+            return false;
+        }
+        writeBinaryIndex(binaryPath, sourceHash, index);
+    }
+    index.id = assetsId;
+    index.sourceHash = sourceHash;
+
+    CachedIndex cached;
+    cached.path = absolutePath;
+    cached.fileSize = info.size();
+    cached.modified = modified;
+    cached.sourceHash = sourceHash;
+    cached.index = index;
+    QMutexLocker locker(&indexCacheLock);
+    indexCache[assetsId] = cached;
+    return true;
+}
 
+void clearIndexCache()
+{
+    QMutexLocker locker(&indexCacheLock);
+    indexCache.clear();
+}
+
+VerifiedObjects &verifiedObjects()
+{
+    static VerifiedObjects objects("assets/verified_objects.dat");
+    return objects;
+}
+
+namespace {
+bool objectIsGood(const AssetsIndex::Entry &entry, CheckMode mode)
+{
+    auto &verified = verifiedObjects();
+    QByteArray hash(reinterpret_cast<const char *>(entry.hash), 20);
+    auto hex = QString::fromLatin1(hash.toHex());
+    auto path = FS::PathCombine("assets/objects", hex.left(2), hex);
+    QFileInfo info(path);
+    if (!info.isFile() || info.size() != entry.size)
+    {
+        verified.remove(hash);
+        return false;
+    }
+    qint64 modified = info.lastModified().toMSecsSinceEpoch();
+    VerifiedObjects::Record record;
+    bool unchanged = verified.lookup(hash, record) && record.size == entry.size && record.modified == modified;
+    if (unchanged && mode == CheckMode::Size)
+    {
+        return true;
+    }
+    record.size = entry.size;
+    record.modified = modified;
+    record.verifiedAt = 0;
+    if (mode == CheckMode::Full)
+    {
+        if (Hashing::MultiHash::hashFile(Hashing::Algorithm::Sha1, path) != hash)
+        {
+            qWarning() << "Asset object" << path << "is corrupted";
+            verified.remove(hash);
+            return false;
+        }
+        record.verifiedAt = QDateTime::currentMSecsSinceEpoch();
+    }
+    verified.insert(hash, record);
     return true;
 }
+}
+
+QFuture<int> checkObjects(const AssetsIndex &index, CheckMode mode)
+{
+    // many paths can share an object, it only has to be looked at once
+    QVector<int> positions;
+    QSet<QByteArray> seen;
+    for (int i = 0; i < index.count(); i++)
+    {
+        QByteArray hash(reinterpret_cast<const char *>(index.entries[i].hash), 20);
+        if (!seen.contains(hash))
+        {
+            seen.insert(hash);
+            positions.append(i);
+        }
+    }
+    std::function<bool(int)> needsDownload = [index, mode](int position)
+    {
+        return !objectIsGood(index.entries[position], mode);
+    };
+    return QtConcurrent::filtered(positions, needsDownload);
+}
 
 // FIXME: ugly code duplication
 QDir getAssetsDir(const QString &assetsId, const QString &resourcesFolder)
@@ -201,7 +559,7 @@ QDir getAssetsDir(const QString &assetsId, const QString &resourcesFolder)
 }
 
 // FIXME: ugly code duplication
-bool reconstructAssets(QString assetsId, QString resourcesFolder)
+bool reconstructAssets(QString assetsId, QString resourcesFolder, bool allowHardlinks, bool force)
 {
     QDir assetsDir = QDir("assets/");
     QDir indexDir = QDir(FS::PathCombine(assetsDir.path(), "indexes"));
@@ -233,76 +591,163 @@ bool reconstructAssets(QString assetsId, QString resourcesFolder)
     {
         targetPath = virtualRoot.path();
         removeLeftovers = true;
-        qDebug() << "Reconstructing virtual assets folder at" << targetPath;
     }
     else if(index.mapToResources)
     {
         targetPath = resourcesFolder;
-        qDebug() << "Reconstructing resources folder at" << targetPath;
     }
 
-    if (!targetPath.isNull())
+    if (targetPath.isNull())
     {
-        auto presentFiles = collectPathsFromDir(targetPath);
-        for (QString map : index.objects.keys())
-        {
-            AssetObject asset_object = index.objects.value(map);
-            QString target_path = FS::PathCombine(targetPath, map);
-            QFile target(target_path);
+        return true;
+    }
 
-            QString tlk = asset_object.hash.left(2);
+    // the manifest sits next to the folder, so the game never sees it
+    QString manifestPath = QDir::cleanPath(targetPath) + ".manifest";
+    ReconstructManifest previous;
+    bool havePrevious = readManifest(manifestPath, previous);
+    if (!force && havePrevious && previous.complete && previous.indexHash == index.sourceHash && QFileInfo(targetPath).isDir())
+    {
+        qDebug() << "Assets in" << targetPath << "are up to date";
+        return true;
+    }
+    qDebug() << "Reconstructing assets in" << targetPath;
+
+    ReconstructManifest manifest;
+    manifest.indexHash = index.sourceHash;
+    manifest.complete = true;
+    QSet<QString> wanted;
+    int kept = 0;
+    int placed[4] = {0, 0, 0, 0};
+    for (int i = 0; i < index.count(); i++)
+    {
+        QString map = index.path(i);
+        QByteArray hash(reinterpret_cast<const char *>(index.entries[i].hash), 20);
+        QString hex = QString::fromLatin1(hash.toHex());
+        QString target_path = FS::PathCombine(targetPath, map);
+        wanted.insert(target_path);
+
+        QString original_path = FS::PathCombine(objectDir.path(), hex.left(2), hex);
+        QFileInfo original(original_path);
+        if (!original.isFile())
+        {
+            manifest.complete = false;
+            continue;
+        }
 
-            QString original_path = FS::PathCombine(objectDir.path(), tlk, asset_object.hash);
-            QFile original(original_path);
-            if (!original.exists())
+        QFileInfo target(target_path);
+        auto previousHash = previous.files.value(map);
+        bool changed = !previousHash.isEmpty() && previousHash != hash;
+        if (target.exists())
+        {
+            if (!changed && target.size() == original.size())
+            {
+                manifest.files.insert(map, hash);
+                kept++;
                 continue;
-
-            presentFiles.remove(target_path);
-
-            if (!target.exists())
+            }
+            // a file we didn't put in the resources folder is left alone
+            if (previousHash.isEmpty() && !removeLeftovers)
             {
-                QFileInfo info(target_path);
-                QDir target_dir = info.dir();
-
-                qDebug() << target_dir.path();
-                FS::ensureFolderPathExists(target_dir.path());
-
-                bool couldCopy = original.copy(target_path);
-                qDebug() << " Copying" << original_path << "to" << target_path << QString::number(couldCopy);
+                continue;
             }
+            QFile::remove(target_path);
         }
 
-        // TODO: Write last used time to virtualRoot/.lastused
-        if(removeLeftovers)
+        auto result = FS::cloneFile(original_path, target_path, allowHardlinks);
+        if (result == FS::CloneResult::Failed)
         {
-            for(auto & file: presentFiles)
-            {
-                qDebug() << "Would remove" << file;
-            }
+            qWarning() << "Failed to place asset" << original_path << "at" << target_path;
+            manifest.complete = false;
+            continue;
         }
+        placed[int(result)]++;
+        manifest.files.insert(map, hash);
     }
+
+    // what we placed before and isn't in the index any more. Virtual folders are ours, so anything there goes
+    QSet<QString> present;
+    if (removeLeftovers && (!havePrevious || force))
+    {
+        present = collectPathsFromDir(targetPath);
+    }
+    else
+    {
+        for (auto iter = previous.files.constBegin(); iter != previous.files.constEnd(); ++iter)
+        {
+            present.insert(FS::PathCombine(targetPath, iter.key()));
+        }
+    }
+    int removed = 0;
+    for (auto &file: present)
+    {
+        if (!wanted.contains(file))
+        {
+            removeWithEmptyParents(targetPath, file);
+            removed++;
+        }
+    }
+
+    writeManifest(manifestPath, manifest);
+    qDebug() << "Assets in" << targetPath << ":" << kept << "kept," << placed[int(FS::CloneResult::Reflinked)] << "reflinked,"
+             << placed[int(FS::CloneResult::Hardlinked)] << "hardlinked," << placed[int(FS::CloneResult::Copied)] << "copied,"
+             << removed << "removed" << (manifest.complete ? "" : "(incomplete)");
     return true;
 }
 
 }
 
+QString AssetsIndex::path(int i) const
+{
+    auto &entry = entries[i];
+    return QString::fromUtf8(paths.constData() + entry.pathOffset, entry.pathLength);
+}
+
+AssetObject AssetsIndex::object(int i) const
+{
+    auto &entry = entries[i];
+    AssetObject result;
+    result.hash = QString::fromLatin1(QByteArray::fromRawData(reinterpret_cast<const char *>(entry.hash), 20).toHex());
+    result.size = entry.size;
+    return result;
+}
+
+int AssetsIndex::indexOf(const QString &path) const
+{
+    auto key = path.toUtf8();
+    auto iter = std::lower_bound(entries.begin(), entries.end(), key, [this](const Entry &entry, const QByteArray &wanted)
+    {
+        return AssetsUtils::comparePath(paths, entry, wanted.constData(), wanted.size()) < 0;
+    });
+    if(iter == entries.end() || AssetsUtils::comparePath(paths, *iter, key.constData(), key.size()) != 0)
+    {
+        return -1;
+    }
+    return iter - entries.begin();
+}
+
 NetAction::Ptr AssetObject::getDownloadAction()
 {
     QFileInfo objectFile(getLocalPath());
     if ((!objectFile.isFile()) || (objectFile.size() != size))
     {
-        auto objectDL = Net::Download::makeFile(getUrl(), objectFile.filePath());
-        if(hash.size())
-        {
-            auto rawHash = QByteArray::fromHex(hash.toLatin1());
-            objectDL->addValidator(new Net::ChecksumValidator(QCryptographicHash::Sha1, rawHash));
-        }
-        objectDL->m_total_progress = size;
-        return objectDL;
+        return makeDownloadAction();
     }
     return nullptr;
 }
 
+NetAction::Ptr AssetObject::makeDownloadAction()
+{
+    auto objectDL = Net::Download::makeFile(getUrl(), getLocalPath());
+    if(hash.size())
+    {
+        auto rawHash = QByteArray::fromHex(hash.toLatin1());
+        objectDL->addValidator(new Net::ChecksumValidator(QCryptographicHash::Sha1, rawHash));
+    }
+    objectDL->setExpectedSize(size);
+    return objectDL;
+}
+
 QString AssetObject::getLocalPath()
 {
     return "assets/objects/" + getRelPath();
@@ -318,18 +763,53 @@ QString AssetObject::getRelPath()
     return hash.left(2) + "/" + hash;
 }
 
-NetJob::Ptr AssetsIndex::getDownloadJob()
+namespace {
+// makes the downloads only when the job gets to them
+class AssetObjectSource : public Net::ActionSource
 {
-    auto job = new NetJob(QObject::tr("Assets for %1").arg(id), APPLICATION->network());
-    for (auto &object : objects.values())
+public:
+    AssetObjectSource(const AssetsIndex &index, const QList<int> &positions) : m_index(index), m_positions(positions)
     {
-        auto dl = object.getDownloadAction();
-        if(dl)
+        for(auto position: m_positions)
         {
-            job->addNetAction(dl);
+            m_remainingBytes += m_index.entries[position].size;
         }
     }
-    if(job->size())
-        return job;
-    return nullptr;
+    NetAction::Ptr next() override
+    {
+        if(m_next >= m_positions.size())
+        {
+            return nullptr;
+        }
+        auto object = m_index.object(m_positions[m_next++]);
+        m_remainingBytes -= object.size;
+        return object.makeDownloadAction();
+    }
+    int remainingCount() const override
+    {
+        return m_positions.size() - m_next;
+    }
+    qint64 remainingBytes() const override
+    {
+        return m_remainingBytes;
+    }
+
+private:
+    AssetsIndex m_index;
+    QList<int> m_positions;
+    int m_next = 0;
+    qint64 m_remainingBytes = 0;
+};
+}
+
+NetJob::Ptr AssetsIndex::getDownloadJob(const QList<int> &positions)
+{
+    if(positions.isEmpty())
+    {
+        return nullptr;
+    }
+    auto job = new NetJob(QObject::tr("Assets for %1").arg(id), APPLICATION->network());
+    job->setPriority(Net::Priority::Interactive);
+    job->addActionSource(std::make_shared<AssetObjectSource>(*this, positions));
+    return job;
 }
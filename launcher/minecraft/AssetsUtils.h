@@ -17,15 +17,21 @@
 
 #include <QString>
 #include <QMap>
+#include <QVector>
+#include <QFuture>
 #include "net/NetAction.h"
 #include "net/NetJob.h"
 
+class VerifiedObjects;
+
 struct AssetObject
 {
     QString getRelPath();
     QUrl getUrl();
     QString getLocalPath();
+    // a download if the object is missing or has the wrong size
     NetAction::Ptr getDownloadAction();
+    NetAction::Ptr makeDownloadAction();
 
     QString hash;
     qint64 size;
@@ -33,10 +39,37 @@ struct AssetObject
 
 struct AssetsIndex
 {
-    NetJob::Ptr getDownloadJob();
+    // one object of the index, its path lives in AssetsIndex::paths as UTF-8
+    struct Entry
+    {
+        quint32 pathOffset = 0;
+        quint32 pathLength = 0;
+        qint64 size = 0;
+        quint8 hash[20];
+    };
+
+    // downloads the objects at the given positions, nullptr if there are none
+    NetJob::Ptr getDownloadJob(const QList<int> &positions);
+
+    int count() const
+    {
+        return entries.size();
+    }
+    bool isEmpty() const
+    {
+        return entries.isEmpty();
+    }
+    QString path(int i) const;
+    AssetObject object(int i) const;
+    // -1 if the index has no object at the path
+    int indexOf(const QString &path) const;
 
     QString id;
-    QMap<QString, AssetObject> objects;
+    // SHA-1 of the index file
+    QByteArray sourceHash;
+    // sorted by path. Both are implicitly shared, so copies of an index are cheap
+    QVector<Entry> entries;
+    QByteArray paths;
     bool isVirtual = false;
     bool mapToResources = false;
 };
@@ -44,10 +77,37 @@ struct AssetsIndex
 /// FIXME: this is absolutely horrendous. REDO!!!!
 namespace AssetsUtils
 {
+/*
+ * Loads the index at most once per launcher run: parsed indexes are kept in memory by id, and on
+ * disk in a binary form keyed by the hash of the JSON file.
+ */
 bool loadAssetsIndexJson(const QString &id, const QString &file, AssetsIndex& index);
 
+/// Forget the indexes kept in memory, the ones on disk stay
+void clearIndexCache();
+
+enum class CheckMode
+{
+    // objects with the recorded size and time are trusted, the rest only has its size checked
+    Size,
+    // hash every object, whatever was recorded about it
+    Full
+};
+
+/// What is known about the files in assets/objects
+VerifiedObjects &verifiedObjects();
+
+/// Check the objects of the index on the thread pool. The results are the positions of the objects that need downloading
+QFuture<int> checkObjects(const AssetsIndex &index, CheckMode mode);
+
 QDir getAssetsDir(const QString &assetsId, const QString &resourcesFolder);
 
-/// Reconstruct a virtual assets folder for the given assets ID and return the folder
-bool reconstructAssets(QString assetsId, QString resourcesFolder);
+/*
+ * Reconstruct a virtual assets folder or the resources folder for the given assets ID.
+ *
+ * Objects are reflinked or hardlinked where the filesystem allows it, and what was placed is
+ * remembered in a manifest next to the folder. With an unchanged index the folder is trusted,
+ * unless force is set.
+ */
+bool reconstructAssets(QString assetsId, QString resourcesFolder, bool allowHardlinks = true, bool force = false);
 }
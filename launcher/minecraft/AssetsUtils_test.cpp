@@ -0,0 +1,253 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "TestUtil.h"
+
+#include "minecraft/AssetsUtils.h"
+#include "minecraft/VerifiedObjects.h"
+#include "FileSystem.h"
+
+class AssetsUtilsTest : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir m_dir;
+
+    QString writeIndex(const QString &id, int count, bool isVirtual)
+    {
+        QJsonObject objects;
+        for(int i = 0; i < count; i++)
+        {
+            QJsonObject object;
+            object.insert("hash", QString::fromLatin1(QCryptographicHash::hash(QByteArray::number(i), QCryptographicHash::Sha1).toHex()));
+            object.insert("size", i * 10);
+            objects.insert(QString("minecraft/sounds/%1/sound_%2.ogg").arg(i % 7).arg(i), object);
+        }
+        QJsonObject root;
+        root.insert("objects", objects);
+        if(isVirtual)
+        {
+            root.insert("virtual", true);
+        }
+        auto path = FS::PathCombine(m_dir.path(), "indexes", id + ".json");
+        FS::write(path, QJsonDocument(root).toJson());
+        return path;
+    }
+
+    void checkIndex(const AssetsIndex &index, int count)
+    {
+        QCOMPARE(index.count(), count);
+        for(int i = 0; i < count; i++)
+        {
+            auto path = QString("minecraft/sounds/%1/sound_%2.ogg").arg(i % 7).arg(i);
+            int position = index.indexOf(path);
+            QVERIFY(position >= 0);
+            QCOMPARE(index.path(position), path);
+            QCOMPARE(index.object(position).hash, QString::fromLatin1(QCryptographicHash::hash(QByteArray::number(i), QCryptographicHash::Sha1).toHex()));
+            QCOMPARE(index.object(position).size, qint64(i * 10));
+        }
+        for(int i = 1; i < count; i++)
+        {
+            QVERIFY(index.path(i - 1) < index.path(i));
+        }
+        QCOMPARE(index.indexOf("minecraft/missing.ogg"), -1);
+    }
+
+private
+slots:
+    void cleanup()
+    {
+        AssetsUtils::clearIndexCache();
+    }
+
+    void test_parse_data()
+    {
+        QTest::addColumn<int>("count");
+        QTest::newRow("empty") << 0;
+        QTest::newRow("small") << 10;
+        // big enough to be parsed in chunks
+        QTest::newRow("chunked") << 5000;
+    }
+    void test_parse()
+    {
+        QFETCH(int, count);
+        auto path = writeIndex("parse", count, true);
+        AssetsIndex index;
+        QVERIFY(AssetsUtils::loadAssetsIndexJson("parse", path, index));
+        QCOMPARE(index.id, QString("parse"));
+        QVERIFY(index.isVirtual);
+        QVERIFY(!index.mapToResources);
+        checkIndex(index, count);
+    }
+
+    void test_binaryCache()
+    {
+        auto path = writeIndex("cached", 100, false);
+        AssetsIndex first;
+        QVERIFY(AssetsUtils::loadAssetsIndexJson("cached", path, first));
+        auto binaryPath = FS::PathCombine(m_dir.path(), "indexes", "parsed", "cached.bin");
+        QVERIFY(QFile::exists(binaryPath));
+
+        // with nothing in memory, the binary form is used
+        AssetsUtils::clearIndexCache();
+        AssetsIndex second;
+        QVERIFY(AssetsUtils::loadAssetsIndexJson("cached", path, second));
+        checkIndex(second, 100);
+
+        // a changed index doesn't match the binary form any more
+        AssetsUtils::clearIndexCache();
+        writeIndex("cached", 50, false);
+        AssetsIndex third;
+        QVERIFY(AssetsUtils::loadAssetsIndexJson("cached", path, third));
+        checkIndex(third, 50);
+
+        // and a broken binary form is parsed over
+        AssetsUtils::clearIndexCache();
+        FS::write(binaryPath, "garbage");
+        AssetsIndex fourth;
+        QVERIFY(AssetsUtils::loadAssetsIndexJson("cached", path, fourth));
+        checkIndex(fourth, 50);
+    }
+
+    void test_checkObjects()
+    {
+        auto previous = QDir::currentPath();
+        QDir::setCurrent(m_dir.path());
+
+        QJsonObject objects;
+        QList<QByteArray> hashes;
+        for(int i = 0; i < 6; i++)
+        {
+            auto content = QByteArray("object ") + QByteArray::number(i);
+            auto hex = QCryptographicHash::hash(content, QCryptographicHash::Sha1).toHex();
+            QJsonObject object;
+            object.insert("hash", QString::fromLatin1(hex));
+            object.insert("size", content.size());
+            objects.insert(QString("object_%1").arg(i), object);
+            // the last one isn't there at all
+            if(i < 5)
+            {
+                FS::write(FS::PathCombine("assets/objects", hex.left(2), hex), content);
+            }
+            hashes.append(hex);
+        }
+        QJsonObject root;
+        root.insert("objects", objects);
+        FS::write("indexes/check.json", QJsonDocument(root).toJson());
+        AssetsIndex index;
+        QVERIFY(AssetsUtils::loadAssetsIndexJson("check", "indexes/check.json", index));
+
+        // one has the wrong size, one the wrong content
+        auto objectPath = [&](int i)
+        {
+            return FS::PathCombine("assets/objects", hashes[i].left(2), hashes[i]);
+        };
+        FS::write(objectPath(1), "way too long for object 1");
+        FS::write(objectPath(2), "object X");
+
+        auto check = [&](AssetsUtils::CheckMode mode)
+        {
+            auto future = AssetsUtils::checkObjects(index, mode);
+            future.waitForFinished();
+            QStringList paths;
+            for(auto position: future.results())
+            {
+                paths.append(index.path(position));
+            }
+            paths.sort();
+            return paths;
+        };
+        QCOMPARE(check(AssetsUtils::CheckMode::Size), QStringList({"object_1", "object_5"}));
+        QCOMPARE(check(AssetsUtils::CheckMode::Full), QStringList({"object_1", "object_2", "object_5"}));
+
+        VerifiedObjects::Record record;
+        QVERIFY(AssetsUtils::verifiedObjects().lookup(QByteArray::fromHex(hashes[0]), record));
+        QVERIFY(record.verifiedAt > 0);
+        QVERIFY(!AssetsUtils::verifiedObjects().lookup(QByteArray::fromHex(hashes[2]), record));
+        QVERIFY(AssetsUtils::verifiedObjects().save());
+        QVERIFY(QFile::exists("assets/verified_objects.dat"));
+
+        // the records survive a reload
+        VerifiedObjects reloaded("assets/verified_objects.dat");
+        QCOMPARE(reloaded.count(), AssetsUtils::verifiedObjects().count());
+        QVERIFY(reloaded.lookup(QByteArray::fromHex(hashes[0]), record));
+        QVERIFY(record.verifiedAt > 0);
+
+        QDir::setCurrent(previous);
+    }
+
+    void test_reconstruct()
+    {
+        auto previous = QDir::currentPath();
+        QTemporaryDir root;
+        QDir::setCurrent(root.path());
+
+        auto writeVirtualIndex = [](const QStringList &names)
+        {
+            QJsonObject objects;
+            for(auto &name: names)
+            {
+                auto content = name.toUtf8();
+                auto hex = QCryptographicHash::hash(content, QCryptographicHash::Sha1).toHex();
+                QJsonObject object;
+                object.insert("hash", QString::fromLatin1(hex));
+                object.insert("size", content.size());
+                objects.insert(name, object);
+                FS::write(FS::PathCombine("assets/objects", hex.left(2), hex), content);
+            }
+            QJsonObject root;
+            root.insert("objects", objects);
+            root.insert("virtual", true);
+            FS::write("assets/indexes/legacy.json", QJsonDocument(root).toJson());
+        };
+        auto read = [](const QString &path)
+        {
+            QFile file(FS::PathCombine("assets/virtual/legacy", path));
+            if(!file.open(QIODevice::ReadOnly))
+            {
+                return QByteArray();
+            }
+            return file.readAll();
+        };
+
+        writeVirtualIndex({"sounds/a.ogg", "sounds/b.ogg", "lang/en_US.lang"});
+        FS::write("assets/virtual/legacy/stray.txt", "not in the index");
+        QVERIFY(AssetsUtils::reconstructAssets("legacy", "resources", false));
+        QCOMPARE(read("sounds/a.ogg"), QByteArray("sounds/a.ogg"));
+        QCOMPARE(read("lang/en_US.lang"), QByteArray("lang/en_US.lang"));
+        QVERIFY(!QFile::exists("assets/virtual/legacy/stray.txt"));
+        QVERIFY(QFile::exists("assets/virtual/legacy.manifest"));
+
+        // an unchanged index is trusted, unless forced
+        QFile::remove("assets/virtual/legacy/sounds/b.ogg");
+        QVERIFY(AssetsUtils::reconstructAssets("legacy", "resources", false));
+        QVERIFY(!QFile::exists("assets/virtual/legacy/sounds/b.ogg"));
+        QVERIFY(AssetsUtils::reconstructAssets("legacy", "resources", false, true));
+        QCOMPARE(read("sounds/b.ogg"), QByteArray("sounds/b.ogg"));
+
+        // a new index places the new objects and prunes the old ones, with their empty folders
+        writeVirtualIndex({"sounds/a.ogg", "music/c.ogg"});
+        QVERIFY(AssetsUtils::reconstructAssets("legacy", "resources", true));
+        QCOMPARE(read("music/c.ogg"), QByteArray("music/c.ogg"));
+        QVERIFY(!QFile::exists("assets/virtual/legacy/sounds/b.ogg"));
+        QVERIFY(!QFile::exists("assets/virtual/legacy/lang"));
+
+        QDir::setCurrent(previous);
+    }
+
+    void test_invalid()
+    {
+        auto path = FS::PathCombine(m_dir.path(), "indexes", "invalid.json");
+        FS::write(path, "{\"objects\": {\"a\": {\"hash\": \"nothex\", \"size\": 1}}}");
+        AssetsIndex index;
+        QVERIFY(!AssetsUtils::loadAssetsIndexJson("invalid", path, index));
+        FS::write(path, "{\"objects\":");
+        QVERIFY(!AssetsUtils::loadAssetsIndexJson("invalid", path, index));
+    }
+};
+
+QTEST_GUILESS_MAIN(AssetsUtilsTest)
+
+#include "AssetsUtils_test.moc"
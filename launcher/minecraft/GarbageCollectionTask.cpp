@@ -0,0 +1,519 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GarbageCollectionTask.h"
+
+#include "InstanceList.h"
+#include "FileSystem.h"
+#include "minecraft/MinecraftInstance.h"
+#include "minecraft/PackProfile.h"
+#include "minecraft/AssetsUtils.h"
+#include "minecraft/VerifiedObjects.h"
+#include "minecraft/OpSys.h"
+#include "net/HttpMetaCache.h"
+#include "Application.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QtConcurrentRun>
+#include <QDebug>
+
+namespace {
+// pack downloads not touched for this long are only a cache of what was installed
+const int downloadMaxAgeDays = 30;
+// partial downloads nobody came back for this long are given up
+const int partialMaxAgeDays = 7;
+
+QString prettySize(qint64 bytes)
+{
+    if(bytes >= 1024LL * 1024 * 1024)
+    {
+        return GarbageCollectionTask::tr("%1 GiB").arg(bytes / (1024.0 * 1024.0 * 1024.0), 0, 'f', 1);
+    }
+    if(bytes >= 1024 * 1024)
+    {
+        return GarbageCollectionTask::tr("%1 MiB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+    return GarbageCollectionTask::tr("%1 KiB").arg(bytes / 1024);
+}
+
+void addFile(GarbageCollectionTask::Area &area, const QFileInfo &info)
+{
+    area.files.append(info.absoluteFilePath());
+    area.bytes += info.size();
+}
+
+// all the files below the folder
+void addFolder(GarbageCollectionTask::Area &area, const QString &path)
+{
+    QDirIterator iter(path, QDir::Files | QDir::Hidden | QDir::System, QDirIterator::Subdirectories);
+    while(iter.hasNext())
+    {
+        iter.next();
+        addFile(area, iter.fileInfo());
+    }
+}
+}
+
+qint64 GarbageCollectionTask::Report::bytes() const
+{
+    qint64 total = 0;
+    for(auto &area: areas)
+    {
+        total += area.bytes;
+    }
+    return total;
+}
+
+int GarbageCollectionTask::Report::files() const
+{
+    int total = 0;
+    for(auto &area: areas)
+    {
+        total += area.files.size();
+    }
+    return total;
+}
+
+QString GarbageCollectionTask::Report::summary() const
+{
+    QStringList lines;
+    lines.append(tr("%1 files no instance uses any more, %2 in total:").arg(files()).arg(prettySize(bytes())));
+    for(auto &area: areas)
+    {
+        if(!area.files.isEmpty())
+        {
+            lines.append(tr("  %1: %2 files, %3").arg(area.name).arg(area.files.size()).arg(prettySize(area.bytes)));
+        }
+    }
+    for(auto &reason: skipped)
+    {
+        lines.append(reason);
+    }
+    return lines.join('\n');
+}
+
+GarbageCollectionTask::GarbageCollectionTask(std::shared_ptr<InstanceList> instances, bool dryRun)
+    : m_instances(instances), m_dryRun(dryRun)
+{
+    connect(&m_sweepWatcher, &QFutureWatcher<Report>::finished, this, &GarbageCollectionTask::sweepFinished);
+}
+
+GarbageCollectionTask::~GarbageCollectionTask()
+{
+    m_sweepWatcher.waitForFinished();
+}
+
+const QStringList &GarbageCollectionTask::downloadCacheBases()
+{
+    static const QStringList bases = {
+        "general",
+        "ATLauncherPacks",
+        "FTBPacks",
+        "ModpacksCHPacks",
+        "TechnicPacks",
+        "CurseForgePacks",
+        "FlamePacks",
+        "ModrinthPacks"
+    };
+    return bases;
+}
+
+bool GarbageCollectionTask::checkIdle()
+{
+    for(int i = 0; i < m_instances->count(); i++)
+    {
+        auto instance = m_instances->at(i);
+        if(instance->isRunning() || instance->isUpdating())
+        {
+            emitFailed(tr("%1 is running or being updated, so nothing was removed. Try again when it is done.").arg(instance->name()));
+            return false;
+        }
+    }
+    return true;
+}
+
+void GarbageCollectionTask::executeTask()
+{
+    if(!checkIdle())
+    {
+        return;
+    }
+    m_pending.clear();
+    for(int i = 0; i < m_instances->count(); i++)
+    {
+        m_pending.append(m_instances->at(i));
+    }
+    m_total = m_pending.size();
+    m_roots = Roots();
+    resolveNextInstance();
+}
+
+void GarbageCollectionTask::resolveNextInstance()
+{
+    while(!m_pending.isEmpty())
+    {
+        m_current = m_pending.takeFirst();
+        setProgress(m_total - m_pending.size(), m_total + 1);
+        // other kinds of instances don't use the shared folders
+        if(!std::dynamic_pointer_cast<MinecraftInstance>(m_current))
+        {
+            continue;
+        }
+        setStatus(tr("Looking at %1...").arg(m_current->name()));
+        m_loadTask = m_current->createUpdateTask(Net::Mode::Offline);
+        // queued, so instances that need no work don't pile up on the stack
+        connect(m_loadTask.get(), &Task::succeeded, this, &GarbageCollectionTask::instanceResolved, Qt::QueuedConnection);
+        connect(m_loadTask.get(), &Task::failed, this, &GarbageCollectionTask::instanceFailed, Qt::QueuedConnection);
+        m_loadTask->start();
+        return;
+    }
+
+    // an instance may have started while we were looking
+    if(!checkIdle())
+    {
+        return;
+    }
+    setStatus(tr("Looking for unused files..."));
+    auto metacache = APPLICATION->metacache();
+    QStringList bases = downloadCacheBases();
+    bases.append("libraries");
+    for(auto &base: bases)
+    {
+        auto &files = m_roots.cachedFiles[base];
+        for(auto &path: metacache->getEntryPaths(base))
+        {
+            files.insert(QFileInfo(path).absoluteFilePath());
+        }
+    }
+    m_roots.now = QDateTime::currentDateTime();
+    auto roots = m_roots;
+    bool dryRun = m_dryRun;
+    m_sweepWatcher.setFuture(QtConcurrent::run(QThreadPool::globalInstance(), [roots, dryRun]()
+    {
+        return sweep(roots, dryRun);
+    }));
+}
+
+void GarbageCollectionTask::instanceResolved()
+{
+    auto instance = std::dynamic_pointer_cast<MinecraftInstance>(m_current);
+    auto profile = instance->getPackProfile()->getProfile();
+    if(!profile)
+    {
+        instanceFailed(tr("its components don't apply"));
+        return;
+    }
+    QStringList jars, natives, natives32, natives64;
+    auto collect = [&](const LibraryPtr &library)
+    {
+        if(library)
+        {
+            library->getApplicableFiles(currentSystem, jars, natives, natives32, natives64, instance->getLocalLibraryPath());
+        }
+    };
+    for(auto &library: profile->getLibraries())
+    {
+        collect(library);
+    }
+    for(auto &library: profile->getNativeLibraries())
+    {
+        collect(library);
+    }
+    for(auto &library: profile->getMavenFiles())
+    {
+        collect(library);
+    }
+    // jar mods are applied to the main jar, so it is needed either way
+    collect(profile->getMainJar());
+    for(auto list: {&jars, &natives, &natives32, &natives64})
+    {
+        for(auto &path: *list)
+        {
+            m_roots.liveFiles.insert(QFileInfo(path).absoluteFilePath());
+        }
+    }
+    if(!instance->getNativeJars().isEmpty())
+    {
+        m_roots.liveFiles.insert(instance->getNativePath());
+    }
+    auto assets = profile->getMinecraftAssets();
+    if(assets)
+    {
+        m_roots.liveAssetIds.insert(assets->id);
+    }
+    m_loadTask.reset();
+    resolveNextInstance();
+}
+
+void GarbageCollectionTask::instanceFailed(QString reason)
+{
+    m_loadTask.reset();
+    emitFailed(tr("Couldn't resolve the components of %1, so nothing was removed: %2").arg(m_current->name(), reason));
+}
+
+GarbageCollectionTask::Report GarbageCollectionTask::sweep(const Roots &roots, bool dryRun)
+{
+    Report report;
+    auto &liveFiles = roots.liveFiles;
+    auto &liveAssetIds = roots.liveAssetIds;
+
+    // installers and users put their own files in there too, only what we downloaded is ours to remove
+    Area libraries;
+    libraries.name = "libraries";
+    for(auto &path: roots.cachedFiles.value("libraries"))
+    {
+        QFileInfo info(path);
+        if(info.isFile() && !liveFiles.contains(path))
+        {
+            addFile(libraries, info);
+        }
+    }
+
+    Area indexes;
+    indexes.name = "assets/indexes";
+    for(auto &info: QDir("assets/indexes").entryInfoList({"*.json"}, QDir::Files))
+    {
+        if(!liveAssetIds.contains(info.completeBaseName()))
+        {
+            addFile(indexes, info);
+        }
+    }
+    for(auto &info: QDir("assets/indexes/parsed").entryInfoList({"*.bin"}, QDir::Files))
+    {
+        if(!liveAssetIds.contains(info.completeBaseName()))
+        {
+            addFile(indexes, info);
+        }
+    }
+
+    Area virtualFolders;
+    virtualFolders.name = "assets/virtual";
+    QStringList deadFolders;
+    for(auto &info: QDir("assets/virtual").entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot))
+    {
+        QString id = info.isDir() ? info.fileName() : info.completeBaseName();
+        if(liveAssetIds.contains(id))
+        {
+            continue;
+        }
+        if(info.isDir())
+        {
+            addFolder(virtualFolders, info.absoluteFilePath());
+            deadFolders.append(info.absoluteFilePath());
+        }
+        else if(info.suffix() == "manifest")
+        {
+            addFile(virtualFolders, info);
+        }
+    }
+
+    // objects are only collected if we know everything the live indexes need
+    Area objects;
+    objects.name = "assets/objects";
+    QSet<QByteArray> liveObjects;
+    bool objectsKnown = true;
+    for(auto &id: liveAssetIds)
+    {
+        AssetsIndex index;
+        auto indexPath = FS::PathCombine("assets/indexes", id + ".json");
+        if(!QFile::exists(indexPath) || !AssetsUtils::loadAssetsIndexJson(id, indexPath, index))
+        {
+            report.skipped.append(tr("Asset objects were not looked at, the index %1 is missing or broken.").arg(id));
+            objectsKnown = false;
+            break;
+        }
+        for(auto &entry: index.entries)
+        {
+            liveObjects.insert(QByteArray(reinterpret_cast<const char *>(entry.hash), 20));
+        }
+    }
+    QList<QByteArray> deadObjects;
+    if(objectsKnown)
+    {
+        QDirIterator objectIter(QDir("assets/objects").absolutePath(), QDir::Files, QDirIterator::Subdirectories);
+        while(objectIter.hasNext())
+        {
+            objectIter.next();
+            auto name = objectIter.fileName();
+            // leave alone what isn't an object
+            auto hash = QByteArray::fromHex(name.toLatin1());
+            if(name.size() != 40 || hash.size() != 20)
+            {
+                continue;
+            }
+            if(!liveObjects.contains(hash))
+            {
+                addFile(objects, objectIter.fileInfo());
+                deadObjects.append(hash);
+            }
+        }
+    }
+
+    // only complete folders, the ones still being extracted have a suffix
+    Area natives;
+    natives.name = "natives";
+    for(auto &info: QDir("natives").entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        if(info.fileName().size() != 40 || liveFiles.contains(info.absoluteFilePath()))
+        {
+            continue;
+        }
+        addFolder(natives, info.absoluteFilePath());
+        deadFolders.append(info.absoluteFilePath());
+    }
+
+    Area downloads;
+    downloads.name = "downloads";
+    auto oldDownloads = roots.now.addDays(-downloadMaxAgeDays);
+    for(auto &base: downloadCacheBases())
+    {
+        for(auto &path: roots.cachedFiles.value(base))
+        {
+            QFileInfo info(path);
+            if(info.isFile() && info.lastModified() < oldDownloads)
+            {
+                addFile(downloads, info);
+            }
+        }
+    }
+
+    // stored files are placed in instances as hard links, the ones only the store links to are unused.
+    // Clones and copies don't need the stored file either. Files committed just now may not be placed yet
+    Area stored;
+    stored.name = "store";
+    auto recent = roots.now.addDays(-1);
+    auto staging = QDir("store/staging").absolutePath();
+    // left behind by installs that didn't finish
+    for(auto &info: QDir(staging).entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot))
+    {
+        if(info.lastModified() >= recent)
+        {
+            continue;
+        }
+        if(info.isDir())
+        {
+            addFolder(stored, info.absoluteFilePath());
+            deadFolders.append(info.absoluteFilePath());
+        }
+        else
+        {
+            addFile(stored, info);
+        }
+    }
+    QDirIterator storeIter(QDir("store").absolutePath(), QDir::Files | QDir::Hidden | QDir::System, QDirIterator::Subdirectories);
+    while(storeIter.hasNext())
+    {
+        storeIter.next();
+        auto info = storeIter.fileInfo();
+        if(info.absoluteFilePath().startsWith(staging + '/'))
+        {
+            continue;
+        }
+        if(info.metadataChangeTime() < recent && FS::linkCount(info.absoluteFilePath()) == 1)
+        {
+            addFile(stored, info);
+        }
+    }
+
+    // aborted downloads keep what they got so they can be resumed
+    Area partial;
+    partial.name = "unfinished downloads";
+    auto oldPartial = roots.now.addDays(-partialMaxAgeDays);
+    for(auto folder: {"libraries", "assets", "cache"})
+    {
+        QDirIterator partialIter(QDir(folder).absolutePath(), {"*.part", "*.part.resume"}, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+        while(partialIter.hasNext())
+        {
+            partialIter.next();
+            if(partialIter.fileInfo().lastModified() < oldPartial)
+            {
+                addFile(partial, partialIter.fileInfo());
+            }
+        }
+    }
+
+    report.areas = {libraries, objects, indexes, virtualFolders, natives, downloads, stored, partial};
+    if(dryRun)
+    {
+        return report;
+    }
+
+    int failed = 0;
+    for(auto &area: report.areas)
+    {
+        for(auto &file: area.files)
+        {
+            if(!QFile::remove(file))
+            {
+                failed++;
+            }
+        }
+    }
+    for(auto &folder: deadFolders)
+    {
+        FS::deletePath(folder);
+    }
+    for(auto &hash: deadObjects)
+    {
+        AssetsUtils::verifiedObjects().remove(hash);
+    }
+    AssetsUtils::verifiedObjects().save();
+    if(failed)
+    {
+        report.skipped.append(tr("%1 files could not be removed.").arg(failed));
+    }
+    return report;
+}
+
+void GarbageCollectionTask::sweepFinished()
+{
+    m_report = m_sweepWatcher.result();
+    setProgress(m_total + 1, m_total + 1);
+    qDebug() << "Garbage collection" << (m_dryRun ? "(dry run):" : ":") << m_report.files() << "files," << m_report.bytes() << "bytes";
+    for(auto &reason: m_report.skipped)
+    {
+        qDebug() << reason;
+    }
+    if(!m_dryRun)
+    {
+        // the metacache would otherwise think it still has the files
+        auto metacache = APPLICATION->metacache();
+        QMap<QString, QStringList> bases = {
+            {"libraries", {"libraries"}},
+            {"assets/objects", {"asset_objects"}},
+            {"assets/indexes", {"asset_indexes"}},
+            {"downloads", downloadCacheBases()}
+        };
+        for(auto &area: m_report.areas)
+        {
+            for(auto &base: bases.value(area.name))
+            {
+                QDir root(metacache->getBasePath(base));
+                for(auto &file: area.files)
+                {
+                    auto entry = metacache->getEntry(base, root.relativeFilePath(file));
+                    if(entry)
+                    {
+                        metacache->evictEntry(entry);
+                    }
+                }
+            }
+        }
+    }
+    emitSucceeded();
+}
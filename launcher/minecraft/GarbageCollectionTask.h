@@ -0,0 +1,111 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tasks/Task.h"
+#include "BaseInstance.h"
+
+#include <QDateTime>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <memory>
+
+class InstanceList;
+
+/*
+ * Finds the files in the shared folders that no instance uses any more: libraries, asset objects,
+ * asset indexes, virtual asset folders, extracted natives, old pack downloads, stored files no
+ * instance links to and partial downloads nobody resumed. Without dry run they are removed, along with their metacache entries.
+ *
+ * What is live comes from the resolved launch profile and the asset index of every instance. The
+ * instances are resolved one per event loop iteration, and the folders are walked on the thread
+ * pool. If any instance can't be resolved, or one is running or being updated, nothing is removed.
+ *
+ * Only files the launcher put there are collected: libraries and downloads need a metacache entry,
+ * so installer outputs, unfinished downloads and files placed by hand are left alone.
+ */
+class GarbageCollectionTask : public Task
+{
+    Q_OBJECT
+public:
+    struct Area
+    {
+        QString name;
+        // absolute paths
+        QStringList files;
+        qint64 bytes = 0;
+    };
+    // what the sweep needs to know, gathered on the main thread
+    struct Roots
+    {
+        // absolute paths of files, and of the natives folders in use
+        QSet<QString> liveFiles;
+        QSet<QString> liveAssetIds;
+        // absolute paths of the files with metacache entries, by base
+        QHash<QString, QSet<QString>> cachedFiles;
+        // downloads and stored files changed shortly before this are left alone
+        QDateTime now = QDateTime::currentDateTime();
+    };
+    struct Report
+    {
+        QList<Area> areas;
+        // what was left alone, and why
+        QStringList skipped;
+
+        qint64 bytes() const;
+        int files() const;
+        QString summary() const;
+    };
+
+    GarbageCollectionTask(std::shared_ptr<InstanceList> instances, bool dryRun);
+    virtual ~GarbageCollectionTask();
+
+    const Report &report() const
+    {
+        return m_report;
+    }
+
+    /// Walk the shared folders below the current directory, removing what isn't live unless dryRun is set.
+    static Report sweep(const Roots &roots, bool dryRun);
+
+    /// The metacache bases of downloads only needed while installing, collected once they are old
+    static const QStringList &downloadCacheBases();
+
+protected:
+    void executeTask() override;
+
+private slots:
+    void resolveNextInstance();
+    void instanceResolved();
+    void instanceFailed(QString reason);
+    void sweepFinished();
+
+private:
+    // fails the task if an instance is using the shared folders right now
+    bool checkIdle();
+
+    std::shared_ptr<InstanceList> m_instances;
+    bool m_dryRun = true;
+    QList<InstancePtr> m_pending;
+    int m_total = 0;
+    InstancePtr m_current;
+    Task::Ptr m_loadTask;
+    Roots m_roots;
+    Report m_report;
+    QFutureWatcher<Report> m_sweepWatcher;
+};
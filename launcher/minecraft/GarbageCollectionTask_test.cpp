@@ -0,0 +1,212 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "TestUtil.h"
+
+#include "minecraft/GarbageCollectionTask.h"
+#include "minecraft/AssetsUtils.h"
+#include "FileSystem.h"
+
+class GarbageCollectionTaskTest : public QObject
+{
+    Q_OBJECT
+
+    QString m_previous;
+    QTemporaryDir m_dir;
+
+    QByteArray addObject(const QByteArray &content)
+    {
+        auto hex = QCryptographicHash::hash(content, QCryptographicHash::Sha1).toHex();
+        FS::write(FS::PathCombine("assets/objects", hex.left(2), hex), content);
+        return hex;
+    }
+
+    void addIndex(const QString &id, const QList<QByteArray> &contents)
+    {
+        QJsonObject objects;
+        for(auto &content: contents)
+        {
+            QJsonObject object;
+            object.insert("hash", QString::fromLatin1(addObject(content)));
+            object.insert("size", content.size());
+            objects.insert(QString::fromUtf8(content), object);
+        }
+        QJsonObject root;
+        root.insert("objects", objects);
+        FS::write(FS::PathCombine("assets/indexes", id + ".json"), QJsonDocument(root).toJson());
+    }
+
+    QString absolute(const QString &path)
+    {
+        return QFileInfo(path).absoluteFilePath();
+    }
+
+    // the used and old libraries came from the metacache, the rest of libraries/ didn't
+    GarbageCollectionTask::Roots roots(const QSet<QString> &liveAssetIds = {"live"})
+    {
+        GarbageCollectionTask::Roots roots;
+        roots.liveFiles = {absolute("libraries/com/example/used/1.0/used-1.0.jar")};
+        roots.liveAssetIds = liveAssetIds;
+        roots.cachedFiles["libraries"] = {
+            absolute("libraries/com/example/used/1.0/used-1.0.jar"),
+            absolute("libraries/com/example/old/1.0/old-1.0.jar")
+        };
+        return roots;
+    }
+
+    QSet<QString> names(const GarbageCollectionTask::Area &area)
+    {
+        QSet<QString> out;
+        QDir root(QDir::currentPath());
+        for(auto &file: area.files)
+        {
+            out.insert(root.relativeFilePath(file));
+        }
+        return out;
+    }
+
+private
+slots:
+    void init()
+    {
+        m_previous = QDir::currentPath();
+        QDir::setCurrent(m_dir.path());
+        FS::write("libraries/com/example/used/1.0/used-1.0.jar", "used");
+        FS::write("libraries/com/example/old/1.0/old-1.0.jar", "old library");
+        FS::write("libraries/net/example/processed/1.0/processed-1.0.jar", "installer output");
+        FS::write("libraries/com/example/new/1.0/new-1.0.jar.part", "downloading");
+        addIndex("live", {"shared", "only live"});
+        addIndex("dead", {"shared", "only dead"});
+        FS::write("assets/objects/README", "not an object");
+        FS::write("assets/virtual/dead/sounds/a.ogg", "a");
+        FS::write("assets/virtual/dead.manifest", "manifest");
+        FS::write("assets/virtual/live/sounds/a.ogg", "a");
+    }
+    void cleanup()
+    {
+        AssetsUtils::clearIndexCache();
+        QDir::setCurrent(m_previous);
+        FS::deletePath(m_dir.path());
+        QDir().mkpath(m_dir.path());
+    }
+
+    void test_dryRun()
+    {
+        auto report = GarbageCollectionTask::sweep(roots(), true);
+        QCOMPARE(report.areas.size(), 8);
+        QCOMPARE(names(report.areas[0]), QSet<QString>({"libraries/com/example/old/1.0/old-1.0.jar"}));
+        auto deadObject = QString::fromLatin1(QCryptographicHash::hash("only dead", QCryptographicHash::Sha1).toHex());
+        QCOMPARE(names(report.areas[1]), QSet<QString>({FS::PathCombine("assets/objects", deadObject.left(2), deadObject)}));
+        QCOMPARE(names(report.areas[2]), QSet<QString>({"assets/indexes/dead.json"}));
+        QCOMPARE(names(report.areas[3]), QSet<QString>({"assets/virtual/dead/sounds/a.ogg", "assets/virtual/dead.manifest"}));
+        QCOMPARE(report.bytes(), qint64(QByteArray("old library").size() + QByteArray("only dead").size() + QFileInfo("assets/indexes/dead.json").size() + 1 + 8));
+        QVERIFY(report.skipped.isEmpty());
+        // nothing went away
+        QVERIFY(QFile::exists("libraries/com/example/old/1.0/old-1.0.jar"));
+        QVERIFY(QFile::exists("assets/virtual/dead/sounds/a.ogg"));
+    }
+
+    void test_remove()
+    {
+        auto report = GarbageCollectionTask::sweep(roots(), false);
+        QCOMPARE(report.files(), 5);
+        QVERIFY(!QFile::exists("libraries/com/example/old/1.0/old-1.0.jar"));
+        QVERIFY(QFile::exists("libraries/com/example/used/1.0/used-1.0.jar"));
+        // not downloaded by us
+        QVERIFY(QFile::exists("libraries/net/example/processed/1.0/processed-1.0.jar"));
+        QVERIFY(QFile::exists("libraries/com/example/new/1.0/new-1.0.jar.part"));
+        QVERIFY(!QFile::exists("assets/indexes/dead.json"));
+        QVERIFY(!QFileInfo::exists("assets/virtual/dead"));
+        QVERIFY(QFile::exists("assets/virtual/live/sounds/a.ogg"));
+        QVERIFY(QFile::exists("assets/objects/README"));
+
+        // everything left is live
+        QCOMPARE(GarbageCollectionTask::sweep(roots(), true).files(), 0);
+    }
+
+    void test_missingIndex()
+    {
+        // without the index, the objects it may need are left alone
+        auto report = GarbageCollectionTask::sweep(roots({"live", "gone"}), true);
+        QVERIFY(report.areas[1].files.isEmpty());
+        QCOMPARE(report.skipped.size(), 1);
+        QCOMPARE(report.areas[0].files.size(), 1);
+    }
+
+    void test_natives()
+    {
+        QString live = "natives/" + QString(40, 'a');
+        QString dead = "natives/" + QString(40, 'b');
+        QString extracting = dead + ".x1Y2z3";
+        FS::write(live + "/liblwjgl.so", "live");
+        FS::write(dead + "/liblwjgl.so", "dead");
+        FS::write(extracting + "/liblwjgl.so", "in progress");
+        auto liveRoots = roots();
+        liveRoots.liveFiles.insert(absolute(live));
+        auto report = GarbageCollectionTask::sweep(liveRoots, true);
+        QCOMPARE(names(report.areas[4]), QSet<QString>({dead + "/liblwjgl.so"}));
+
+        GarbageCollectionTask::sweep(liveRoots, false);
+        QVERIFY(!QFileInfo::exists(dead));
+        QVERIFY(QFile::exists(live + "/liblwjgl.so"));
+        QVERIFY(QFile::exists(extracting + "/liblwjgl.so"));
+    }
+
+    void test_downloads()
+    {
+        FS::write("cache/ATLauncherPacks/old.zip", "old pack");
+        FS::write("cache/ATLauncherPacks/new.zip", "new pack");
+        FS::write("cache/ATLauncherPacks/unknown.zip", "not ours");
+        auto oldRoots = roots();
+        oldRoots.cachedFiles["ATLauncherPacks"] = {absolute("cache/ATLauncherPacks/old.zip"), absolute("cache/ATLauncherPacks/new.zip")};
+        QVERIFY(FS::setTimestamp("cache/ATLauncherPacks/old.zip", QDateTime::currentSecsSinceEpoch() - 60 * 24 * 3600));
+        auto report = GarbageCollectionTask::sweep(oldRoots, true);
+        QCOMPARE(names(report.areas[5]), QSet<QString>({"cache/ATLauncherPacks/old.zip"}));
+    }
+
+    void test_store()
+    {
+        QString used = "store/sha1/aa/" + QString(40, 'a');
+        QString unused = "store/sha1/bb/" + QString(40, 'b');
+        QString staging = "store/staging/sha1-" + QString(40, 'c') + ".x1Y2z3/download.part";
+        FS::write(used, "used");
+        FS::write(unused, "unused");
+        FS::write(staging, "abandoned");
+        bool linked = FS::cloneFile(used, "instances/a/mods/used.jar") == FS::CloneResult::Hardlinked;
+
+        // just committed, an install may still be placing them
+        QVERIFY(GarbageCollectionTask::sweep(roots(), true).areas[6].files.isEmpty());
+
+        auto later = roots();
+        later.now = QDateTime::currentDateTime().addDays(2);
+        QSet<QString> expected = {unused, staging};
+        if(!linked)
+        {
+            // without hard links, the instance has its own copy
+            expected.insert(used);
+        }
+        QCOMPARE(names(GarbageCollectionTask::sweep(later, true).areas[6]), expected);
+    }
+
+    void test_unfinished()
+    {
+        QString object = "assets/objects/ab/" + QString(40, 'a') + ".part";
+        FS::write(object, "half");
+        FS::write(object + ".resume", "\"etag\"\n\n");
+        // in init, new-1.0.jar.part is fresh
+        auto report = GarbageCollectionTask::sweep(roots(), true);
+        QVERIFY(report.areas[7].files.isEmpty());
+
+        auto later = roots();
+        later.now = QDateTime::currentDateTime().addDays(8);
+        report = GarbageCollectionTask::sweep(later, true);
+        QCOMPARE(names(report.areas[7]), QSet<QString>({object, object + ".resume", "libraries/com/example/new/1.0/new-1.0.jar.part"}));
+    }
+};
+
+QTEST_GUILESS_MAIN(GarbageCollectionTaskTest)
+
+#include "GarbageCollectionTask_test.moc"
@@ -0,0 +1,223 @@
+#include "LaunchFingerprint.h"
+
+#include "minecraft/MinecraftInstance.h"
+#include "minecraft/PackProfile.h"
+#include "FileSystem.h"
+#include "Exception.h"
+#include "BuildConfig.h"
+
+#include "Application.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+
+namespace {
+QString fingerprintPath(const QString &instanceRoot)
+{
+    return FS::PathCombine(instanceRoot, ".launch_fingerprint");
+}
+}
+
+LaunchFingerprint::LaunchFingerprint() : m_hash(Hashing::Algorithm::Sha1)
+{
+}
+
+void LaunchFingerprint::addData(const QString &data)
+{
+    // keep the pieces apart, "ab" + "c" is not "a" + "bc"
+    m_hash.addData(data.toUtf8());
+    m_hash.addData(QByteArray(1, '\0'));
+}
+
+void LaunchFingerprint::addFileContents(const QString &path)
+{
+    addData(path);
+    auto hash = Hashing::MultiHash::hashFile(Hashing::Algorithm::Sha1, path);
+    addData(hash.isEmpty() ? QString("missing") : QString::fromLatin1(hash.toHex()));
+}
+
+void LaunchFingerprint::addFileStat(const QString &path)
+{
+    addData(path);
+    QFileInfo info(path);
+    if (!info.isFile())
+    {
+        addData("missing");
+        return;
+    }
+    addData(QString::number(info.size()));
+    addData(QString::number(info.lastModified().toMSecsSinceEpoch()));
+}
+
+QByteArray LaunchFingerprint::result()
+{
+    return m_hash.result(Hashing::Algorithm::Sha1);
+}
+
+LaunchFingerprint::Inputs LaunchFingerprint::inputsOf(MinecraftInstance *inst)
+{
+    Inputs inputs;
+    inputs.instanceRoot = inst->instanceRoot();
+    inputs.profile = inst->getPackProfile()->getProfile();
+    inputs.librariesBase = APPLICATION->metacache()->getBasePath("libraries");
+    inputs.localLibraryPath = inst->getLocalLibraryPath();
+    inputs.jarModsDir = inst->jarModsDir();
+    inputs.libDir = inst->libDir();
+    inputs.gameRoot = inst->gameRoot();
+    return inputs;
+}
+
+QByteArray LaunchFingerprint::compute(MinecraftInstance *inst)
+{
+    return compute(inputsOf(inst));
+}
+
+QByteArray LaunchFingerprint::compute(const Inputs &inputs)
+{
+    auto profile = inputs.profile;
+    if (!profile)
+    {
+        return QByteArray();
+    }
+
+    LaunchFingerprint fingerprint;
+    // a different launcher may check different things
+    fingerprint.addData(BuildConfig.printableVersionString());
+
+    // the component files
+    fingerprint.addFileContents(FS::PathCombine(inputs.instanceRoot, "mmc-pack.json"));
+    QDir patches(FS::PathCombine(inputs.instanceRoot, "patches"));
+    for (auto &entry : patches.entryInfoList({"*.json"}, QDir::Files, QDir::Name))
+    {
+        fingerprint.addFileContents(entry.absoluteFilePath());
+    }
+
+    // the files of the profile they resolve to
+    auto base = inputs.librariesBase;
+    bool alwaysStale = false;
+    auto addPool = [&](const QList<LibraryPtr> &pool, const QString &overridePath)
+    {
+        for (auto lib : pool)
+        {
+            if (!lib)
+            {
+                fingerprint.addData("null");
+                continue;
+            }
+            alwaysStale |= lib->isAlwaysStale();
+            fingerprint.addData(lib->rawName().serialize());
+            if (lib->isLocal())
+            {
+                QStringList jar, native, native32, native64;
+                lib->getApplicableFiles(currentSystem, jar, native, native32, native64, overridePath);
+                for (auto &path : jar + native + native32 + native64)
+                {
+                    fingerprint.addFileStat(path);
+                }
+                continue;
+            }
+            auto checksums = lib->getCachedChecksums(currentSystem);
+            auto storage = checksums.keys();
+            storage.sort();
+            for (auto &path : storage)
+            {
+                fingerprint.addData(checksums[path]);
+                fingerprint.addFileStat(FS::PathCombine(base, path));
+            }
+        }
+    };
+    QList<LibraryPtr> libraries;
+    libraries.append(profile->getLibraries());
+    libraries.append(profile->getNativeLibraries());
+    libraries.append(profile->getMavenFiles());
+    libraries.append(profile->getMainJar());
+    addPool(libraries, inputs.localLibraryPath);
+    addPool(profile->getJarMods(), inputs.jarModsDir);
+    if (alwaysStale)
+    {
+        // those are looked at on every launch, on purpose
+        return QByteArray();
+    }
+
+    auto assets = profile->getMinecraftAssets();
+    if (assets)
+    {
+        fingerprint.addData(assets->id);
+        fingerprint.addData(assets->sha1);
+        fingerprint.addFileStat(FS::PathCombine("assets/indexes", assets->id + ".json"));
+    }
+
+    if (profile->hasTrait("legacyFML"))
+    {
+        QDir libDir(inputs.libDir);
+        for (auto &entry : libDir.entryInfoList(QDir::Files, QDir::Name))
+        {
+            fingerprint.addFileStat(entry.absoluteFilePath());
+        }
+    }
+    fingerprint.addData(QDir(inputs.gameRoot).exists() ? "game folder" : "no game folder");
+    return fingerprint.result();
+}
+
+bool LaunchFingerprint::upToDate(const Inputs &inputs)
+{
+    auto fingerprint = compute(inputs);
+    return !fingerprint.isEmpty() && fingerprint == stored(inputs.instanceRoot);
+}
+
+QByteArray LaunchFingerprint::stored(MinecraftInstance *inst)
+{
+    return stored(inst->instanceRoot());
+}
+
+QByteArray LaunchFingerprint::stored(const QString &instanceRoot)
+{
+    auto path = fingerprintPath(instanceRoot);
+    if (!QFileInfo(path).isFile())
+    {
+        return QByteArray();
+    }
+    try
+    {
+        return FS::read(path);
+    }
+    catch (const Exception &e)
+    {
+        qWarning() << "Couldn't read the launch fingerprint:" << e.cause();
+        return QByteArray();
+    }
+}
+
+void LaunchFingerprint::store(MinecraftInstance *inst, const QByteArray &fingerprint)
+{
+    store(inst->instanceRoot(), fingerprint);
+}
+
+void LaunchFingerprint::store(const QString &instanceRoot, const QByteArray &fingerprint)
+{
+    if (fingerprint.isEmpty())
+    {
+        clear(instanceRoot);
+        return;
+    }
+    try
+    {
+        FS::write(fingerprintPath(instanceRoot), fingerprint);
+    }
+    catch (const Exception &e)
+    {
+        qWarning() << "Couldn't write the launch fingerprint:" << e.cause();
+    }
+}
+
+void LaunchFingerprint::clear(MinecraftInstance *inst)
+{
+    clear(inst->instanceRoot());
+}
+
+void LaunchFingerprint::clear(const QString &instanceRoot)
+{
+    QFile::remove(fingerprintPath(instanceRoot));
+}
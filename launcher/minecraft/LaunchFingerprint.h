@@ -0,0 +1,67 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <memory>
+
+#include "hashing/MultiHash.h"
+
+class MinecraftInstance;
+class LaunchProfile;
+
+/*
+ * Digest of everything the update before a launch looks at: the component files of the instance, the profile they
+ * resolve to and the size and modification time of the files that profile needs.
+ *
+ * A successful update stores it in the instance. When a launch computes the same digest, nothing the update would
+ * check has changed and the update can be skipped.
+ */
+class LaunchFingerprint
+{
+public:
+    /// Where the things the fingerprint looks at are
+    struct Inputs
+    {
+        QString instanceRoot;
+        std::shared_ptr<LaunchProfile> profile;
+        /// the "libraries" base of the metacache
+        QString librariesBase;
+        QString localLibraryPath;
+        QString jarModsDir;
+        QString libDir;
+        QString gameRoot;
+    };
+
+    LaunchFingerprint();
+
+    void addData(const QString &data);
+
+    /// Hash the whole file, for the small ones that describe the instance
+    void addFileContents(const QString &path);
+
+    /// Only look at the size and modification time of the file
+    void addFileStat(const QString &path);
+
+    QByteArray result();
+
+    /// The inputs of the instance. The pack profile has to be loaded.
+    static Inputs inputsOf(MinecraftInstance *inst);
+
+    /// The fingerprint of the instance as it is now, empty if it can't have one
+    static QByteArray compute(const Inputs &inputs);
+    static QByteArray compute(MinecraftInstance *inst);
+
+    /// True when the instance has a fingerprint and it is the one the last successful update stored
+    static bool upToDate(const Inputs &inputs);
+
+    /// The fingerprint stored by the last successful update, empty if there is none
+    static QByteArray stored(const QString &instanceRoot);
+    static QByteArray stored(MinecraftInstance *inst);
+    static void store(const QString &instanceRoot, const QByteArray &fingerprint);
+    static void store(MinecraftInstance *inst, const QByteArray &fingerprint);
+    static void clear(const QString &instanceRoot);
+    static void clear(MinecraftInstance *inst);
+
+private:
+    Hashing::MultiHash m_hash;
+};
@@ -0,0 +1,265 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QDateTime>
+#include <QFile>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include "TestUtil.h"
+
+#include "minecraft/LaunchFingerprint.h"
+#include "minecraft/LaunchProfile.h"
+#include "minecraft/OneSixVersionFormat.h"
+#include "minecraft/VersionFile.h"
+#include "FileSystem.h"
+
+class LaunchFingerprintTest : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir m_dir;
+
+    QString path(const QString &name)
+    {
+        return FS::PathCombine(m_dir.path(), name);
+    }
+
+    QByteArray statOf(const QString &file)
+    {
+        LaunchFingerprint fingerprint;
+        fingerprint.addFileStat(file);
+        return fingerprint.result();
+    }
+
+    QByteArray contentsOf(const QString &file)
+    {
+        LaunchFingerprint fingerprint;
+        fingerprint.addFileContents(file);
+        return fingerprint.result();
+    }
+
+    QJsonObject artifact(const QString &storage)
+    {
+        QJsonObject out;
+        out.insert("path", storage);
+        out.insert("sha1", "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+        out.insert("size", 0);
+        out.insert("url", "https://libraries.minecraft.net/" + storage);
+        return out;
+    }
+
+    // writes the version file of the instance, with one library and one native library, and resolves it
+    std::shared_ptr<LaunchProfile> writeVersion(const QString &libraryVersion, const QString &nativesVersion, const QString &name = "Minecraft")
+    {
+        QJsonObject library;
+        library.insert("name", "com.example:library:" + libraryVersion);
+        QJsonObject libraryDownloads;
+        libraryDownloads.insert("artifact", artifact(QString("com/example/library/%1/library-%1.jar").arg(libraryVersion)));
+        library.insert("downloads", libraryDownloads);
+
+        QJsonObject natives;
+        natives.insert("name", "com.example:natives:" + nativesVersion);
+        QJsonObject classifiers;
+        QJsonObject systems;
+        for (QString system : {"freebsd", "linux", "osx", "windows"})
+        {
+            systems.insert(system, "natives-" + system);
+            classifiers.insert("natives-" + system, artifact(QString("com/example/natives/%1/natives-%1-natives-%2.jar").arg(nativesVersion, system)));
+        }
+        natives.insert("natives", systems);
+        QJsonObject nativesDownloads;
+        nativesDownloads.insert("classifiers", classifiers);
+        natives.insert("downloads", nativesDownloads);
+
+        QJsonObject root;
+        root.insert("formatVersion", 1);
+        root.insert("uid", "net.minecraft");
+        root.insert("version", "1.0");
+        root.insert("name", name);
+        root.insert("libraries", QJsonArray{library, natives});
+        QJsonDocument doc(root);
+        FS::write(path("instance/patches/net.minecraft.json"), doc.toJson());
+
+        auto file = OneSixVersionFormat::versionFileFromJson(doc, "net.minecraft.json", false);
+        auto profile = std::make_shared<LaunchProfile>();
+        file->applyTo(profile.get());
+        return profile;
+    }
+
+    LaunchFingerprint::Inputs inputs(std::shared_ptr<LaunchProfile> profile)
+    {
+        LaunchFingerprint::Inputs out;
+        out.instanceRoot = path("instance");
+        out.profile = profile;
+        out.librariesBase = path("libraries");
+        out.localLibraryPath = path("instance/libraries");
+        out.jarModsDir = path("instance/jarmods");
+        out.libDir = path("instance/lib");
+        out.gameRoot = path("instance/.minecraft");
+        return out;
+    }
+
+    // where the metacache keeps the files of the library for this system
+    QStringList filesOf(const LibraryPtr &library)
+    {
+        QStringList out;
+        for (auto &storage : library->getCachedStorage(currentSystem))
+        {
+            out.append(FS::PathCombine(path("libraries"), storage));
+        }
+        return out;
+    }
+
+    void writeFiles(const QStringList &files, const QByteArray &content)
+    {
+        for (auto &file : files)
+        {
+            FS::write(file, content);
+        }
+    }
+
+private
+slots:
+    void init()
+    {
+        QDir(path("instance")).removeRecursively();
+        QDir(path("libraries")).removeRecursively();
+        FS::write(path("instance/mmc-pack.json"), "{}");
+    }
+
+    void test_separatesData()
+    {
+        LaunchFingerprint first;
+        first.addData("ab");
+        first.addData("c");
+        LaunchFingerprint second;
+        second.addData("a");
+        second.addData("bc");
+        QVERIFY(first.result() != second.result());
+        QCOMPARE(first.result().size(), 20);
+    }
+
+    void test_stat()
+    {
+        auto file = path("library.jar");
+        auto missing = statOf(file);
+        FS::write(file, "library");
+        auto written = statOf(file);
+        QVERIFY(written != missing);
+        QCOMPARE(statOf(file), written);
+
+        QFile touched(file);
+        QVERIFY(touched.open(QIODevice::ReadWrite));
+        QVERIFY(touched.setFileTime(QDateTime::currentDateTime().addDays(-1), QFileDevice::FileModificationTime));
+        touched.close();
+        QVERIFY(statOf(file) != written);
+    }
+
+    void test_contents()
+    {
+        auto file = path("mmc-pack.json");
+        FS::write(file, "{}");
+        auto before = contentsOf(file);
+        FS::write(file, "[]");
+        QVERIFY(contentsOf(file) != before);
+        FS::write(file, "{}");
+        QCOMPARE(contentsOf(file), before);
+        QFile::remove(file);
+        QVERIFY(contentsOf(file) != before);
+    }
+
+    void test_versionFile()
+    {
+        auto profile = writeVersion("1.0", "1.0");
+        auto before = LaunchFingerprint::compute(inputs(profile));
+        QVERIFY(!before.isEmpty());
+        QCOMPARE(LaunchFingerprint::compute(inputs(profile)), before);
+
+        // the same profile out of a different file
+        writeVersion("1.0", "1.0", "Changed");
+        auto renamed = LaunchFingerprint::compute(inputs(profile));
+        QVERIFY(renamed != before);
+
+        // a different profile
+        auto updated = writeVersion("1.1", "1.0", "Changed");
+        QVERIFY(LaunchFingerprint::compute(inputs(updated)) != renamed);
+
+        writeVersion("1.0", "1.0");
+        QCOMPARE(LaunchFingerprint::compute(inputs(profile)), before);
+    }
+
+    void test_library()
+    {
+        auto profile = writeVersion("1.0", "1.0");
+        QCOMPARE(profile->getLibraries().size(), 1);
+        auto files = filesOf(profile->getLibraries().first());
+        QCOMPARE(files.size(), 1);
+        auto missing = LaunchFingerprint::compute(inputs(profile));
+
+        writeFiles(files, "library");
+        auto written = LaunchFingerprint::compute(inputs(profile));
+        QVERIFY(written != missing);
+        QCOMPARE(LaunchFingerprint::compute(inputs(profile)), written);
+
+        writeFiles(files, "a different library");
+        QVERIFY(LaunchFingerprint::compute(inputs(profile)) != written);
+    }
+
+    void test_natives()
+    {
+        auto profile = writeVersion("1.0", "1.0");
+        QCOMPARE(profile->getNativeLibraries().size(), 1);
+        auto files = filesOf(profile->getNativeLibraries().first());
+        if (files.isEmpty())
+        {
+            QSKIP("The test natives are not made for this system");
+        }
+        auto missing = LaunchFingerprint::compute(inputs(profile));
+
+        writeFiles(files, "natives");
+        auto written = LaunchFingerprint::compute(inputs(profile));
+        QVERIFY(written != missing);
+
+        writeFiles(files, "different natives");
+        QVERIFY(LaunchFingerprint::compute(inputs(profile)) != written);
+    }
+
+    // what MinecraftUpdate goes by before it runs its steps
+    void test_updateSkipped()
+    {
+        auto profile = writeVersion("1.0", "1.0");
+        auto libraries = filesOf(profile->getLibraries().first());
+        writeFiles(libraries, "library");
+
+        // nothing stored yet, the update runs
+        QVERIFY(!LaunchFingerprint::upToDate(inputs(profile)));
+
+        // a successful update stores the fingerprint, the next launch skips it
+        LaunchFingerprint::store(path("instance"), LaunchFingerprint::compute(inputs(profile)));
+        QVERIFY(LaunchFingerprint::upToDate(inputs(profile)));
+
+        // a library that changed on disk makes it run again
+        writeFiles(libraries, "a different library");
+        QVERIFY(!LaunchFingerprint::upToDate(inputs(profile)));
+        LaunchFingerprint::store(path("instance"), LaunchFingerprint::compute(inputs(profile)));
+        QVERIFY(LaunchFingerprint::upToDate(inputs(profile)));
+
+        // so does a changed version file
+        auto updated = writeVersion("1.1", "1.0");
+        QVERIFY(!LaunchFingerprint::upToDate(inputs(updated)));
+
+        // an update that starts drops the stored one, until it succeeds
+        LaunchFingerprint::store(path("instance"), LaunchFingerprint::compute(inputs(updated)));
+        QVERIFY(LaunchFingerprint::upToDate(inputs(updated)));
+        LaunchFingerprint::clear(path("instance"));
+        QVERIFY(!LaunchFingerprint::upToDate(inputs(updated)));
+
+        // nothing to compare without a profile
+        QVERIFY(!LaunchFingerprint::upToDate(inputs(nullptr)));
+    }
+};
+
+QTEST_GUILESS_MAIN(LaunchFingerprintTest)
+
+#include "LaunchFingerprint_test.moc"
@@ -44,66 +44,8 @@ void Library::getApplicableFiles(OpSys system, QStringList& jar, QStringList& na
     }
 }
 
-QList<NetAction::Ptr> Library::getDownloads(
-    OpSys system,
-    class HttpMetaCache* cache,
-    QStringList& failedLocalFiles,
-    const QString & overridePath
-) const
+void Library::forEachArtifact(OpSys system, const ArtifactVisitor &visit) const
 {
-    QList<NetAction::Ptr> out;
-    bool stale = isAlwaysStale();
-    bool local = isLocal();
-
-    auto check_local_file = [&](QString storage)
-    {
-        QFileInfo fileinfo(storage);
-        QString fileName = fileinfo.fileName();
-        auto fullPath = FS::PathCombine(overridePath, fileName);
-        QFileInfo localFileInfo(fullPath);
-        if(!localFileInfo.exists())
-        {
-            failedLocalFiles.append(localFileInfo.filePath());
-            return false;
-        }
-        return true;
-    };
-
-    auto add_download = [&](QString storage, QString url, QString sha1)
-    {
-        if(local)
-        {
-            return check_local_file(storage);
-        }
-        auto entry = cache->resolveEntry("libraries", storage);
-        if(stale)
-        {
-            entry->setStale(true);
-        }
-        if (!entry->isStale())
-            return true;
-        Net::Download::Options options;
-        if(stale)
-        {
-            options |= Net::Download::Option::AcceptLocalFiles;
-        }
-
-        if(sha1.size())
-        {
-            auto rawSha1 = QByteArray::fromHex(sha1.toLatin1());
-            auto dl = Net::Download::makeCached(url, entry, options);
-            dl->addValidator(new Net::ChecksumValidator(QCryptographicHash::Sha1, rawSha1));
-            qDebug() << "Checksummed Download for:" << rawName().serialize() << "storage:" << storage << "url:" << url;
-            out.append(dl);
-        }
-        else
-        {
-            out.append(Net::Download::makeCached(url, entry, options));
-            qDebug() << "Download for:" << rawName().serialize() << "storage:" << storage << "url:" << url;
-        }
-        return true;
-    };
-
     QString raw_storage = storageSuffix(system);
     if(m_mojangDownloads)
     {
@@ -123,14 +65,14 @@ QList<NetAction::Ptr> Library::getDownloads(
                     {
                         auto cooked_storage = raw_storage;
                         cooked_storage.replace("${arch}", "32");
-                        add_download(cooked_storage, nat32info->url, nat32info->sha1);
+                        visit(cooked_storage, nat32info->url, nat32info->sha1, nat32info->size);
                     }
                     auto nat64info = m_mojangDownloads->getDownloadInfo(nat64Classifier);
                     if(nat64info)
                     {
                         auto cooked_storage = raw_storage;
                         cooked_storage.replace("${arch}", "64");
-                        add_download(cooked_storage, nat64info->url, nat64info->sha1);
+                        visit(cooked_storage, nat64info->url, nat64info->sha1, nat64info->size);
                     }
                 }
                 else
@@ -138,7 +80,7 @@ QList<NetAction::Ptr> Library::getDownloads(
                     auto info = m_mojangDownloads->getDownloadInfo(nativeClassifier);
                     if(info)
                     {
-                        add_download(raw_storage, info->url, info->sha1);
+                        visit(raw_storage, info->url, info->sha1, info->size);
                     }
                 }
             }
@@ -152,7 +94,7 @@ QList<NetAction::Ptr> Library::getDownloads(
             if(m_mojangDownloads->artifact)
             {
                 auto artifact = m_mojangDownloads->artifact;
-                add_download(raw_storage, artifact->url, artifact->sha1);
+                visit(raw_storage, artifact->url, artifact->sha1, artifact->size);
             }
             else
             {
@@ -187,16 +129,139 @@ QList<NetAction::Ptr> Library::getDownloads(
         {
             QString cooked_storage = raw_storage;
             QString cooked_dl = raw_dl;
-            add_download(cooked_storage.replace("${arch}", "32"), cooked_dl.replace("${arch}", "32"), QString());
+            visit(cooked_storage.replace("${arch}", "32"), cooked_dl.replace("${arch}", "32"), QString(), -1);
             cooked_storage = raw_storage;
             cooked_dl = raw_dl;
-            add_download(cooked_storage.replace("${arch}", "64"), cooked_dl.replace("${arch}", "64"), QString());
+            visit(cooked_storage.replace("${arch}", "64"), cooked_dl.replace("${arch}", "64"), QString(), -1);
         }
         else
         {
-            add_download(raw_storage, raw_dl, QString());
+            visit(raw_storage, raw_dl, QString(), -1);
         }
     }
+}
+
+QList<NetAction::Ptr> Library::getDownloads(
+    OpSys system,
+    class HttpMetaCache* cache,
+    QStringList& failedLocalFiles,
+    const QString & overridePath
+) const
+{
+    return getDownloads(system, cache, QHash<QString, MetaEntryPtr>(), failedLocalFiles, overridePath);
+}
+
+QList<NetAction::Ptr> Library::getDownloads(
+    OpSys system,
+    class HttpMetaCache* cache,
+    const QHash<QString, MetaEntryPtr> & resolved,
+    QStringList& failedLocalFiles,
+    const QString & overridePath
+) const
+{
+    QList<NetAction::Ptr> out;
+    bool stale = isAlwaysStale();
+    bool local = isLocal();
+
+    auto check_local_file = [&](QString storage)
+    {
+        QFileInfo fileinfo(storage);
+        QString fileName = fileinfo.fileName();
+        auto fullPath = FS::PathCombine(overridePath, fileName);
+        QFileInfo localFileInfo(fullPath);
+        if(!localFileInfo.exists())
+        {
+            failedLocalFiles.append(localFileInfo.filePath());
+            return false;
+        }
+        return true;
+    };
+
+    auto add_download = [&](QString storage, QString url, QString sha1, qint64 size)
+    {
+        if(local)
+        {
+            return check_local_file(storage);
+        }
+        auto entry = resolved.value(storage);
+        if(!entry)
+        {
+            entry = cache->resolveEntry("libraries", storage);
+        }
+        if(stale)
+        {
+            entry->setStale(true);
+        }
+        if (!entry->isStale())
+            return true;
+        Net::Download::Options options;
+        if(stale)
+        {
+            options |= Net::Download::Option::AcceptLocalFiles;
+        }
+
+        if(sha1.size())
+        {
+            auto rawSha1 = QByteArray::fromHex(sha1.toLatin1());
+            auto dl = Net::Download::makeCached(url, entry, options);
+            dl->addValidator(new Net::ChecksumValidator(QCryptographicHash::Sha1, rawSha1));
+            dl->setExpectedSize(size);
+            qDebug() << "Checksummed Download for:" << rawName().serialize() << "storage:" << storage << "url:" << url;
+            out.append(dl);
+        }
+        else
+        {
+            auto dl = Net::Download::makeCached(url, entry, options);
+            dl->setExpectedSize(size);
+            out.append(dl);
+            qDebug() << "Download for:" << rawName().serialize() << "storage:" << storage << "url:" << url;
+        }
+        return true;
+    };
+
+    forEachArtifact(system, add_download);
+    return out;
+}
+
+QHash<QString, QString> Library::getCachedChecksums(OpSys system) const
+{
+    QHash<QString, QString> out;
+    if(isLocal())
+    {
+        return out;
+    }
+    forEachArtifact(system, [&](const QString &storage, const QString &, const QString &sha1, qint64)
+    {
+        out.insert(storage, sha1);
+    });
+    return out;
+}
+
+QStringList Library::getCachedStorage(OpSys system) const
+{
+    QStringList out;
+    if(isLocal())
+    {
+        return out;
+    }
+    forEachArtifact(system, [&](const QString &storage, const QString &, const QString &, qint64)
+    {
+        out.append(storage);
+    });
+    return out;
+}
+
+QStringList Library::getDownloadUrls(OpSys system) const
+{
+    QStringList out;
+    if(isLocal())
+    {
+        return out;
+    }
+    forEachArtifact(system, [&](const QString &, const QString &url, const QString &, qint64)
+    {
+        out.append(url);
+    });
     return out;
 }
 
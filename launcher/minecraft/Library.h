@@ -5,14 +5,17 @@
 #include <QList>
 #include <QStringList>
 #include <QMap>
+#include <QHash>
 #include <QDir>
 #include <QUrl>
 #include <memory>
+#include <functional>
 
 #include "Rule.h"
 #include "minecraft/OpSys.h"
 #include "GradleSpecifier.h"
 #include "MojangDownloadInfo.h"
+#include "net/HttpMetaCache.h"
 
 class Library;
 class MinecraftInstance;
@@ -155,7 +158,26 @@ public: /* methods */
     QList<NetAction::Ptr> getDownloads(OpSys system, class HttpMetaCache * cache,
                                      QStringList & failedLocalFiles, const QString & overridePath) const;
 
+    // Same, reusing entries that were already resolved, by their path in the "libraries" metacache base.
+    // The files that are not in there are resolved through the cache
+    QList<NetAction::Ptr> getDownloads(OpSys system, class HttpMetaCache * cache, const QHash<QString, MetaEntryPtr> & resolved,
+                                     QStringList & failedLocalFiles, const QString & overridePath) const;
+
+    // Get the paths of the files of this library in the "libraries" metacache base
+    QStringList getCachedStorage(OpSys system) const;
+
+    // Same paths, mapped to the hex SHA-1 the metadata expects for them (empty if it doesn't say)
+    QHash<QString, QString> getCachedChecksums(OpSys system) const;
+
+    // Get the URLs the files of this library are downloaded from, before any rerouting
+    QStringList getDownloadUrls(OpSys system) const;
+
 private: /* methods */
+    using ArtifactVisitor = std::function<void(const QString &storage, const QString &url, const QString &sha1, qint64 size)>;
+
+    /// Call visit for every file of this library that applies to the system
+    void forEachArtifact(OpSys system, const ArtifactVisitor &visit) const;
+
     /// the default storage prefix used by MultiMC
     static QString defaultStoragePrefix();
 
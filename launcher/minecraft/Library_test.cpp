@@ -262,6 +262,57 @@ slots:
         QCOMPARE(dls[0]->m_url, QUrl("https://libraries.minecraft.net/tv/twitch/twitch-platform/5.16/twitch-platform-5.16-natives-windows-32.jar"));
         QCOMPARE(dls[1]->m_url, QUrl("https://libraries.minecraft.net/tv/twitch/twitch-platform/5.16/twitch-platform-5.16-natives-windows-64.jar"));
     }
+    void test_checksums()
+    {
+        auto test = readMojangJson("data/lib-native-arch.json");
+        auto checksums = test->getCachedChecksums(Os_Windows);
+        QCOMPARE(checksums.size(), 2);
+        QCOMPARE(checksums["tv/twitch/twitch-platform/5.16/twitch-platform-5.16-natives-windows-32.jar"], QString("7c6affe439099806a4f552da14c42f9d643d8b23"));
+        QCOMPARE(checksums["tv/twitch/twitch-platform/5.16/twitch-platform-5.16-natives-windows-64.jar"], QString("39d0c3d363735b4785598e0e7fbf8297c706a9f9"));
+        test->setHint("local");
+        QVERIFY(test->getCachedChecksums(Os_Windows).isEmpty());
+    }
+    void test_checksums_legacy()
+    {
+        Library test("test.package:testname:testversion");
+        auto checksums = test.getCachedChecksums(currentSystem);
+        QCOMPARE(checksums.size(), 1);
+        QCOMPARE(checksums["test/package/testname/testversion/testname-testversion.jar"], QString());
+    }
+    void test_cachedStorage()
+    {
+        auto test = readMojangJson("data/lib-native-arch.json");
+        QCOMPARE(test->getCachedStorage(Os_Windows), QStringList({
+            "tv/twitch/twitch-platform/5.16/twitch-platform-5.16-natives-windows-32.jar",
+            "tv/twitch/twitch-platform/5.16/twitch-platform-5.16-natives-windows-64.jar"
+        }));
+        test->setHint("local");
+        QVERIFY(test->getCachedStorage(Os_Windows).isEmpty());
+    }
+    void test_downloadUrls()
+    {
+        auto test = readMojangJson("data/lib-native-arch.json");
+        QCOMPARE(test->getDownloadUrls(Os_Windows), QStringList({
+            "https://libraries.minecraft.net/tv/twitch/twitch-platform/5.16/twitch-platform-5.16-natives-windows-32.jar",
+            "https://libraries.minecraft.net/tv/twitch/twitch-platform/5.16/twitch-platform-5.16-natives-windows-64.jar"
+        }));
+        test->setHint("local");
+        QVERIFY(test->getDownloadUrls(Os_Windows).isEmpty());
+    }
+    void test_resolvedEntries()
+    {
+        Library test("test.package:testname:testversion");
+        auto storage = test.getCachedStorage(currentSystem);
+        QCOMPARE(storage.size(), 1);
+        // resolved earlier and found to be fine, so there is nothing to download
+        auto entry = cache->resolveEntry("libraries", storage[0]);
+        entry->setStale(false);
+        QHash<QString, MetaEntryPtr> resolved;
+        resolved.insert(storage[0], entry);
+        QStringList failedFiles;
+        QVERIFY(test.getDownloads(currentSystem, cache.get(), resolved, failedFiles, QString()).isEmpty());
+        QCOMPARE(test.getDownloads(currentSystem, cache.get(), failedFiles, QString()).size(), 1);
+    }
 private:
     std::unique_ptr<HttpMetaCache> cache;
     QString dataDir;
@@ -51,6 +51,13 @@
 #include "BuildConfig.h"
 #include "minecraft/VersionFilterData.h"
 
+#ifdef major
+    #undef major
+#endif
+#ifdef minor
+    #undef minor
+#endif
+
 #define IBUS "@im=ibus"
 
 // all of this because keeping things compatible with deprecated old settings
@@ -191,10 +198,19 @@ QString MinecraftInstance::binRoot() const
 
 QString MinecraftInstance::getNativePath() const
 {
-    QDir natives_dir(FS::PathCombine(instanceRoot(), "natives/"));
+    QDir natives_dir(NativesCache::folderFor(getNativeJars(), getNativesOptions()));
     return natives_dir.absolutePath();
 }
 
+NativesCache::Options MinecraftInstance::getNativesOptions() const
+{
+    NativesCache::Options options;
+    options.applyJnilibHack = getJavaVersion().major() >= 8;
+    options.nativeOpenAL = settings()->get("UseNativeOpenAL").toBool();
+    options.nativeGLFW = settings()->get("UseNativeGLFW").toBool();
+    return options;
+}
+
 QString MinecraftInstance::getLocalLibraryPath() const
 {
     QDir libraries_dir(FS::PathCombine(instanceRoot(), "libraries/"));
@@ -840,6 +856,43 @@ QString MinecraftInstance::getStatusbarDescription()
     return description;
 }
 
+QList<QUrl> MinecraftInstance::likelyDownloadUrls() const
+{
+    // metadata and assets don't come from the libraries
+    QList<QUrl> urls = {
+        QUrl(BuildConfig.META_URL),
+        QUrl(BuildConfig.RESOURCE_BASE)
+    };
+    auto profile = m_components->getProfile();
+    if (!profile)
+    {
+        return urls;
+    }
+    QList<LibraryPtr> libraries;
+    libraries.append(profile->getLibraries());
+    libraries.append(profile->getNativeLibraries());
+    libraries.append(profile->getMavenFiles());
+    libraries.append(profile->getMainJar());
+    // wherever the loaders keep their files, the scheduler sends these through the router
+    QSet<QString> seen;
+    for (auto & library : libraries)
+    {
+        if (!library)
+        {
+            continue;
+        }
+        for (auto & url : library->getDownloadUrls(currentSystem))
+        {
+            if (!seen.contains(url))
+            {
+                seen.insert(url);
+                urls.append(QUrl(url));
+            }
+        }
+    }
+    return urls;
+}
+
 Task::Ptr MinecraftInstance::createUpdateTask(Net::Mode mode)
 {
     switch (mode)
@@ -849,13 +902,25 @@ Task::Ptr MinecraftInstance::createUpdateTask(Net::Mode mode)
         return Task::Ptr(new MinecraftLoadAndCheck(this));
     }
     case Net::Mode::Online:
+    case Net::Mode::Verify:
     {
-        return Task::Ptr(new MinecraftUpdate(this));
+        return Task::Ptr(new MinecraftUpdate(this, mode));
     }
     }
     return nullptr;
 }
 
+Task::Ptr MinecraftInstance::createLaunchUpdateTask(Net::Mode mode)
+{
+    if(mode != Net::Mode::Online)
+    {
+        return createUpdateTask(mode);
+    }
+    auto update = new MinecraftUpdate(this, mode);
+    update->setUseLaunchFingerprint(true);
+    return Task::Ptr(update);
+}
+
 shared_qobject_ptr<LaunchTask> MinecraftInstance::createLaunchTask(AuthSessionPtr session, QuickPlayTargetPtr quickPlayTarget)
 {
     // FIXME: get rid of shared_from_this ...
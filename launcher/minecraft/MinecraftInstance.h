@@ -5,6 +5,7 @@
 #include <QProcess>
 #include <QDir>
 #include "minecraft/launch/QuickPlayTarget.h"
+#include "minecraft/NativesCache.h"
 
 class ModFolderModel;
 class WorldList;
@@ -60,6 +61,7 @@ public:
 
     // where to put the natives during/before launch
     QString getNativePath() const;
+    NativesCache::Options getNativesOptions() const;
 
     // where the instance-local libraries should be
     QString getLocalLibraryPath() const;
@@ -79,6 +81,8 @@ public:
 
     //////  Launch stuff //////
     Task::Ptr createUpdateTask(Net::Mode mode) override;
+    Task::Ptr createLaunchUpdateTask(Net::Mode mode) override;
+    QList<QUrl> likelyDownloadUrls() const override;
     shared_qobject_ptr<LaunchTask> createLaunchTask(AuthSessionPtr account, QuickPlayTargetPtr quickPlayTarget) override;
     QStringList extraArguments() const override;
     QStringList verboseDescription(AuthSessionPtr session, QuickPlayTargetPtr quickPlayTarget) override;
@@ -30,16 +30,91 @@
 #include "update/LibrariesTask.h"
 #include "update/FMLLibrariesTask.h"
 #include "update/AssetUpdateTask.h"
+#include "update/VerifyLibrariesTask.h"
+#include "LaunchFingerprint.h"
 
 #include <meta/Index.h>
 #include <meta/Version.h>
 
-MinecraftUpdate::MinecraftUpdate(MinecraftInstance *inst, QObject *parent) : Task(parent), m_inst(inst)
+MinecraftUpdate::MinecraftUpdate(MinecraftInstance *inst, Net::Mode mode, QObject *parent) : Task(parent), m_inst(inst), m_mode(mode)
 {
+    connect(this, &Task::finished, this, [this]()
+    {
+        if(m_markedUpdating)
+        {
+            m_markedUpdating = false;
+            m_inst->endUpdate();
+        }
+    });
+}
+
+MinecraftUpdate::~MinecraftUpdate()
+{
+    if(m_markedUpdating)
+    {
+        m_inst->endUpdate();
+    }
+}
+
+void MinecraftUpdate::setUseLaunchFingerprint(bool use)
+{
+    m_useFingerprint = use;
 }
 
 void MinecraftUpdate::executeTask()
 {
+    // keeps the shared folder cleanup away until this is done
+    if(m_mode != Net::Mode::Offline && !m_markedUpdating)
+    {
+        m_markedUpdating = true;
+        m_inst->beginUpdate();
+    }
+    // loading the profile from disk is enough to tell if anything changed since the last update
+    if(m_useFingerprint && m_mode == Net::Mode::Online && !LaunchFingerprint::stored(m_inst).isEmpty())
+    {
+        auto components = m_inst->getPackProfile();
+        if(components->reload(Net::Mode::Offline))
+        {
+            setStatus(tr("Looking for changes since the last update..."));
+            m_loadTask = components->getCurrentTask();
+            if(m_loadTask && !m_loadTask->isFinished())
+            {
+                connect(m_loadTask.get(), &Task::finished, this, &MinecraftUpdate::profileLoaded);
+                return;
+            }
+            profileLoaded();
+            return;
+        }
+    }
+    startUpdate();
+}
+
+void MinecraftUpdate::profileLoaded()
+{
+    bool loaded = !m_loadTask || m_loadTask->wasSuccessful();
+    m_loadTask.reset();
+    if(m_abort)
+    {
+        emitFailed(tr("Aborted by user."));
+        return;
+    }
+    if(loaded)
+    {
+        if(LaunchFingerprint::upToDate(LaunchFingerprint::inputsOf(m_inst)))
+        {
+            qDebug() << m_inst->name() << ": nothing changed since the last update, skipping it";
+            emitSucceeded();
+            return;
+        }
+    }
+    startUpdate();
+}
+
+void MinecraftUpdate::startUpdate()
+{
+    // only a complete update may store a new one
+    LaunchFingerprint::clear(m_inst);
+
     m_tasks.clear();
     // create folders
     {
@@ -61,6 +136,12 @@ void MinecraftUpdate::executeTask()
         }
     }
 
+    // hash the library files that are already there, removing the damaged ones makes the next step get them again
+    if(m_mode == Net::Mode::Verify)
+    {
+        m_tasks.append(std::make_shared<VerifyLibrariesTask>(m_inst));
+    }
+
     // libraries download
     {
         m_tasks.append(std::make_shared<LibrariesTask>(m_inst));
@@ -73,7 +154,8 @@ void MinecraftUpdate::executeTask()
 
     // assets update
     {
-        m_tasks.append(std::make_shared<AssetUpdateTask>(m_inst));
+        auto checkMode = m_mode == Net::Mode::Verify ? AssetsUtils::CheckMode::Full : AssetsUtils::CheckMode::Size;
+        m_tasks.append(std::make_shared<AssetUpdateTask>(m_inst, checkMode));
     }
 
     if(!m_preFailure.isEmpty())
@@ -107,6 +189,7 @@ void MinecraftUpdate::next()
     }
     if(m_currentTask == m_tasks.size())
     {
+        LaunchFingerprint::store(m_inst, LaunchFingerprint::compute(m_inst));
         emitSucceeded();
         return;
     }
@@ -170,6 +253,10 @@ bool MinecraftUpdate::abort()
     if(!m_abort)
     {
         m_abort = true;
+        if(m_currentTask < 0 || m_currentTask >= m_tasks.size())
+        {
+            return true;
+        }
         auto task = m_tasks[m_currentTask];
         if(task->canAbort())
         {
@@ -183,3 +270,13 @@ bool MinecraftUpdate::canAbort() const
 {
     return true;
 }
+
+QStringList MinecraftUpdate::warnings() const
+{
+    auto out = Task::warnings();
+    for(auto task : m_tasks)
+    {
+        out.append(task->warnings());
+    }
+    return out;
+}
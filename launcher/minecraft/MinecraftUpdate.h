@@ -20,6 +20,7 @@
 #include <QUrl>
 
 #include "net/NetJob.h"
+#include "net/Mode.h"
 #include "tasks/Task.h"
 #include "minecraft/VersionFilterData.h"
 #include <quazip.h>
@@ -31,23 +32,35 @@ class MinecraftUpdate : public Task
 {
     Q_OBJECT
 public:
-    explicit MinecraftUpdate(MinecraftInstance *inst, QObject *parent = 0);
-    virtual ~MinecraftUpdate() {};
+    explicit MinecraftUpdate(MinecraftInstance *inst, Net::Mode mode = Net::Mode::Online, QObject *parent = 0);
+    virtual ~MinecraftUpdate();
 
     void executeTask() override;
     bool canAbort() const override;
 
+    /// The warnings of all the subtasks, which is where a verification reports what it found
+    QStringList warnings() const override;
+
+    /// Skip the update when the instance still matches the fingerprint stored by the last successful one
+    void setUseLaunchFingerprint(bool use);
+
 private
 slots:
     bool abort() override;
     void subtaskSucceeded();
     void subtaskFailed(QString error);
+    void profileLoaded();
 
 private:
+    void startUpdate();
     void next();
 
 private:
     MinecraftInstance *m_inst = nullptr;
+    Net::Mode m_mode = Net::Mode::Online;
+    bool m_useFingerprint = false;
+    bool m_markedUpdating = false;
+    Task::Ptr m_loadTask;
     QList<std::shared_ptr<Task>> m_tasks;
     QString m_preFailure;
     int m_currentTask = -1;
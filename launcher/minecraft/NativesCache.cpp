@@ -0,0 +1,173 @@
+#include "NativesCache.h"
+
+#include "hashing/MultiHash.h"
+#include "FileSystem.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTemporaryDir>
+#include <quazip.h>
+#include <JlCompress.h>
+
+namespace NativesCache
+{
+namespace {
+const QString cacheRoot = "natives";
+
+struct JarHash
+{
+    qint64 size = 0;
+    qint64 modified = 0;
+    QByteArray hash;
+};
+
+QMutex jarHashesMutex;
+QHash<QString, JarHash> jarHashes;
+
+// the same jars come up on every launch, only hash them again when they changed
+QByteArray hashJar(const QString &path)
+{
+    QFileInfo info(path);
+    if (!info.isFile())
+    {
+        return QByteArray();
+    }
+    auto absolutePath = info.absoluteFilePath();
+    qint64 modified = info.lastModified().toMSecsSinceEpoch();
+    {
+        QMutexLocker locker(&jarHashesMutex);
+        auto iter = jarHashes.constFind(absolutePath);
+        if (iter != jarHashes.constEnd() && iter->size == info.size() && iter->modified == modified)
+        {
+            return iter->hash;
+        }
+    }
+    JarHash stamp;
+    stamp.size = info.size();
+    stamp.modified = modified;
+    stamp.hash = Hashing::MultiHash::hashFile(Hashing::Algorithm::Sha1, path);
+    QMutexLocker locker(&jarHashesMutex);
+    jarHashes.insert(absolutePath, stamp);
+    return stamp.hash;
+}
+
+QString replaceSuffix(QString target, const QString &suffix, const QString &replacement)
+{
+    if (!target.endsWith(suffix))
+    {
+        return target;
+    }
+    target.resize(target.length() - suffix.length());
+    return target + replacement;
+}
+
+bool unzipNatives(QString source, QString targetFolder, const Options &options)
+{
+    QuaZip zip(source);
+    if(!zip.open(QuaZip::mdUnzip))
+    {
+        return false;
+    }
+    QDir directory(targetFolder);
+    if (!zip.goToFirstFile())
+    {
+        return false;
+    }
+    do
+    {
+        QString name = zip.getCurrentFileName();
+        if (options.nativeGLFW && name.contains("glfw")) {
+            continue;
+        }
+        if (options.nativeOpenAL && name.contains("openal")) {
+            continue;
+        }
+        if(options.applyJnilibHack)
+        {
+            name = replaceSuffix(name, ".jnilib", ".dylib");
+        }
+        QString absFilePath = directory.absoluteFilePath(name);
+        if (!JlCompress::extractFile(&zip, "", absFilePath))
+        {
+            return false;
+        }
+    } while (zip.goToNextFile());
+    zip.close();
+    if(zip.getZipError()!=0)
+    {
+        return false;
+    }
+    return true;
+}
+}
+
+QString folderFor(const QStringList &jars, const Options &options)
+{
+    Hashing::MultiHash key(Hashing::Algorithm::Sha1);
+    key.addData(QByteArray("natives 1"));
+    key.addData(QByteArray(1, options.applyJnilibHack ? 'j' : '-'));
+    key.addData(QByteArray(1, options.nativeOpenAL ? 'a' : '-'));
+    key.addData(QByteArray(1, options.nativeGLFW ? 'g' : '-'));
+    for (auto &jar : jars)
+    {
+        auto hash = hashJar(jar);
+        // a jar that isn't there can't be extracted, but the folder name has to stay unique
+        key.addData(hash.isEmpty() ? QFileInfo(jar).absoluteFilePath().toUtf8() : hash);
+        key.addData(QByteArray(1, '\0'));
+    }
+    return FS::PathCombine(cacheRoot, QString::fromLatin1(key.result(Hashing::Algorithm::Sha1).toHex()));
+}
+
+bool extract(const QStringList &jars, const Options &options, QString &error)
+{
+    auto folder = folderFor(jars, options);
+    // folders only get their name once they are complete
+    if (QFileInfo(folder).isDir())
+    {
+        return true;
+    }
+
+    if (!QDir().mkpath(cacheRoot))
+    {
+        error = QObject::tr("Couldn't create the natives folder '%1'").arg(cacheRoot);
+        return false;
+    }
+    QTemporaryDir staging(folder + ".XXXXXX");
+    if (!staging.isValid())
+    {
+        error = QObject::tr("Couldn't create a temporary folder for the natives in '%1'").arg(cacheRoot);
+        return false;
+    }
+    for (auto &jar : jars)
+    {
+        if (!unzipNatives(jar, staging.path(), options))
+        {
+            error = QObject::tr("Couldn't extract native jar '%1' to destination '%2'").arg(jar, staging.path());
+            return false;
+        }
+    }
+    if (!QDir().rename(staging.path(), folder))
+    {
+        // another launch got there first, which is just as good
+        if (QFileInfo(folder).isDir())
+        {
+            return true;
+        }
+        error = QObject::tr("Couldn't move the extracted natives to '%1'").arg(folder);
+        return false;
+    }
+    qDebug() << "Extracted" << jars.size() << "native jars to" << folder;
+    return true;
+}
+
+void clearHashCache()
+{
+    QMutexLocker locker(&jarHashesMutex);
+    jarHashes.clear();
+}
+}
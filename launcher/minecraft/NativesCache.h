@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+/*
+ * Natives extracted once into a shared folder below "natives/", instead of into every instance on every launch.
+ *
+ * The folder is named after a hash of the native jars and the options they were extracted with, so it never changes
+ * once it is there. It is filled under a temporary name and renamed into place, so a launch either sees a complete
+ * folder or none at all, and several launches can extract the same natives at once.
+ */
+namespace NativesCache
+{
+struct Options
+{
+    // rename .jnilib to .dylib, for Java 8 and newer on macOS
+    bool applyJnilibHack = false;
+    // leave out the bundled libraries, the system ones are used instead
+    bool nativeOpenAL = false;
+    bool nativeGLFW = false;
+};
+
+/// The folder for the natives of the jars, extracted in this order with these options
+QString folderFor(const QStringList &jars, const Options &options);
+
+/// Extract the jars into their folder, unless that already happened. Returns false and sets error on failure
+bool extract(const QStringList &jars, const Options &options, QString &error);
+
+/// Forget the jar hashes kept in memory
+void clearHashCache();
+}
@@ -0,0 +1,94 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QDir>
+#include "TestUtil.h"
+
+#include <quazip.h>
+#include <quazipfile.h>
+
+#include "minecraft/NativesCache.h"
+#include "FileSystem.h"
+
+class NativesCacheTest : public QObject
+{
+    Q_OBJECT
+
+    QString m_previous;
+    QTemporaryDir m_dir;
+
+    void makeJar(const QString &path, const QStringList &names)
+    {
+        QuaZip zip(path);
+        QVERIFY(zip.open(QuaZip::mdCreate));
+        for(auto &name: names)
+        {
+            QuaZipFile file(&zip);
+            QVERIFY(file.open(QIODevice::WriteOnly, QuaZipNewInfo(name)));
+            file.write(name.toUtf8());
+            file.close();
+        }
+        zip.close();
+    }
+
+private
+slots:
+    void init()
+    {
+        m_previous = QDir::currentPath();
+        QDir::setCurrent(m_dir.path());
+        makeJar("lwjgl-natives.jar", {"liblwjgl.jnilib", "libglfw.dylib", "libopenal.dylib"});
+    }
+    void cleanup()
+    {
+        NativesCache::clearHashCache();
+        QDir::setCurrent(m_previous);
+        FS::deletePath(m_dir.path());
+        QDir().mkpath(m_dir.path());
+    }
+
+    void test_folderKey()
+    {
+        NativesCache::Options plain;
+        NativesCache::Options glfw;
+        glfw.nativeGLFW = true;
+        auto first = NativesCache::folderFor({"lwjgl-natives.jar"}, plain);
+        QCOMPARE(NativesCache::folderFor({"lwjgl-natives.jar"}, plain), first);
+        QVERIFY(NativesCache::folderFor({"lwjgl-natives.jar"}, glfw) != first);
+
+        // a different jar gets a different folder
+        QFile::remove("lwjgl-natives.jar");
+        makeJar("lwjgl-natives.jar", {"liblwjgl.jnilib"});
+        QVERIFY(NativesCache::folderFor({"lwjgl-natives.jar"}, plain) != first);
+    }
+
+    void test_extract()
+    {
+        NativesCache::Options options;
+        options.applyJnilibHack = true;
+        options.nativeGLFW = true;
+        QString error;
+        QVERIFY(NativesCache::extract({"lwjgl-natives.jar"}, options, error));
+        auto folder = NativesCache::folderFor({"lwjgl-natives.jar"}, options);
+        QCOMPARE(QDir(folder).entryList(QDir::Files, QDir::Name), QStringList({"liblwjgl.dylib", "libopenal.dylib"}));
+
+        // the second time, the folder is used as it is
+        FS::write(FS::PathCombine(folder, "marker"), "marker");
+        QVERIFY(NativesCache::extract({"lwjgl-natives.jar"}, options, error));
+        QVERIFY(QFile::exists(FS::PathCombine(folder, "marker")));
+        QCOMPARE(QDir("natives").entryList(QDir::Dirs | QDir::NoDotAndDotDot).size(), 1);
+    }
+
+    void test_brokenJar()
+    {
+        FS::write("broken.jar", "not a zip");
+        QString error;
+        QVERIFY(!NativesCache::extract({"lwjgl-natives.jar", "broken.jar"}, NativesCache::Options(), error));
+        QVERIFY(!error.isEmpty());
+        // nothing half done is left behind
+        QCOMPARE(QDir("natives").entryList(QDir::Dirs | QDir::NoDotAndDotDot).size(), 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(NativesCacheTest)
+
+#include "NativesCache_test.moc"
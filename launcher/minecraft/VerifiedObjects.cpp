@@ -0,0 +1,146 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "VerifiedObjects.h"
+#include "FileSystem.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QSaveFile>
+#include <QDebug>
+
+namespace {
+const quint32 VERIFIED_MAGIC = 0x41564F42; // "AVOB"
+const quint32 VERIFIED_VERSION = 1;
+}
+
+VerifiedObjects::VerifiedObjects(const QString &path) : m_path(path)
+{
+}
+
+void VerifiedObjects::load() const
+{
+    if(m_loaded)
+    {
+        return;
+    }
+    m_loaded = true;
+    QFile file(m_path);
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        return;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint32 count = 0;
+    in >> magic >> version >> count;
+    if(in.status() != QDataStream::Ok || magic != VERIFIED_MAGIC || version != VERIFIED_VERSION)
+    {
+        qWarning() << "Ignoring verified objects file" << m_path << "with unknown format";
+        return;
+    }
+    QHash<QByteArray, Record> records;
+    for(quint32 i = 0; i < count; i++)
+    {
+        QByteArray hash;
+        Record record;
+        in >> hash >> record.size >> record.modified >> record.verifiedAt;
+        if(in.status() != QDataStream::Ok)
+        {
+            break;
+        }
+        records.insert(hash, record);
+    }
+    if(records.size() != int(count))
+    {
+        qWarning() << "Verified objects file" << m_path << "is truncated, dropping it";
+        return;
+    }
+    m_records = records;
+}
+
+bool VerifiedObjects::lookup(const QByteArray &hash, Record &record) const
+{
+    QMutexLocker locker(&m_lock);
+    load();
+    auto iter = m_records.constFind(hash);
+    if(iter == m_records.constEnd())
+    {
+        return false;
+    }
+    record = *iter;
+    return true;
+}
+
+void VerifiedObjects::insert(const QByteArray &hash, const Record &record)
+{
+    QMutexLocker locker(&m_lock);
+    load();
+    m_records.insert(hash, record);
+    m_dirty = true;
+}
+
+void VerifiedObjects::remove(const QByteArray &hash)
+{
+    QMutexLocker locker(&m_lock);
+    load();
+    if(m_records.remove(hash))
+    {
+        m_dirty = true;
+    }
+}
+
+int VerifiedObjects::count() const
+{
+    QMutexLocker locker(&m_lock);
+    load();
+    return m_records.size();
+}
+
+bool VerifiedObjects::save()
+{
+    QByteArray data;
+    {
+        QMutexLocker locker(&m_lock);
+        if(!m_dirty)
+        {
+            return true;
+        }
+        QDataStream out(&data, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_0);
+        out << VERIFIED_MAGIC << VERIFIED_VERSION << quint32(m_records.size());
+        for(auto iter = m_records.constBegin(); iter != m_records.constEnd(); ++iter)
+        {
+            out << iter.key() << iter->size << iter->modified << iter->verifiedAt;
+        }
+        m_dirty = false;
+    }
+    if(!FS::ensureFilePathExists(m_path))
+    {
+        qWarning() << "Could not create folder for" << m_path;
+        return false;
+    }
+    QSaveFile out(m_path);
+    if(!out.open(QIODevice::WriteOnly) || out.write(data) != data.size() || !out.commit())
+    {
+        qWarning() << "Could not write" << m_path << ":" << out.errorString();
+        QMutexLocker locker(&m_lock);
+        m_dirty = true;
+        return false;
+    }
+    return true;
+}
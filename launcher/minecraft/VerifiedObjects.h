@@ -0,0 +1,62 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+
+/*
+ * What we know about the objects in a content addressed folder: the size and modification time
+ * each had when it was last looked at, and when its content was last hashed.
+ *
+ * Objects that still have the recorded size and time don't need to be looked at again. All the
+ * methods are safe to call from the worker threads doing the checks.
+ */
+class VerifiedObjects
+{
+public:
+    struct Record
+    {
+        qint64 size = -1;
+        qint64 modified = -1;
+        // milliseconds since epoch, 0 if only the size was checked
+        qint64 verifiedAt = 0;
+    };
+
+    explicit VerifiedObjects(const QString &path);
+
+    // the record for the raw hash, false if there is none
+    bool lookup(const QByteArray &hash, Record &record) const;
+    void insert(const QByteArray &hash, const Record &record);
+    void remove(const QByteArray &hash);
+    int count() const;
+
+    // writes the records out if anything changed since they were last loaded or saved
+    bool save();
+
+private:
+    void load() const;
+
+private:
+    mutable QMutex m_lock;
+    QString m_path;
+    // loaded on first use
+    mutable QHash<QByteArray, Record> m_records;
+    mutable bool m_loaded = false;
+    bool m_dirty = false;
+};
@@ -15,71 +15,12 @@
 
 #include "ExtractNatives.h"
 #include <minecraft/MinecraftInstance.h>
+#include <minecraft/NativesCache.h>
 #include <launch/LaunchTask.h>
 
-#include <quazip.h>
-#include <quazipdir.h>
-#include "MMCZip.h"
 #include "FileSystem.h"
 #include <QDir>
 
-#ifdef major
-    #undef major
-#endif
-#ifdef minor
-    #undef minor
-#endif
-
-static QString replaceSuffix (QString target, const QString &suffix, const QString &replacement)
-{
-    if (!target.endsWith(suffix))
-    {
-        return target;
-    }
-    target.resize(target.length() - suffix.length());
-    return target + replacement;
-}
-
-static bool unzipNatives(QString source, QString targetFolder, bool applyJnilibHack, bool nativeOpenAL, bool nativeGLFW)
-{
-    QuaZip zip(source);
-    if(!zip.open(QuaZip::mdUnzip))
-    {
-        return false;
-    }
-    QDir directory(targetFolder);
-    if (!zip.goToFirstFile())
-    {
-        return false;
-    }
-    do
-    {
-        QString name = zip.getCurrentFileName();
-        auto lowercase = name.toLower();
-        if (nativeGLFW && name.contains("glfw")) {
-            continue;
-        }
-        if (nativeOpenAL && name.contains("openal")) {
-            continue;
-        }
-        if(applyJnilibHack)
-        {
-            name = replaceSuffix(name, ".jnilib", ".dylib");
-        }
-        QString absFilePath = directory.absoluteFilePath(name);
-        if (!JlCompress::extractFile(&zip, "", absFilePath))
-        {
-            return false;
-        }
-    } while (zip.goToNextFile());
-    zip.close();
-    if(zip.getZipError()!=0)
-    {
-        return false;
-    }
-    return true;
-}
-
 void ExtractNatives::executeTask()
 {
     auto instance = m_parent->instance();
@@ -90,27 +31,20 @@ void ExtractNatives::executeTask()
         emitSucceeded();
         return;
     }
-    auto settings = minecraftInstance->settings();
-    bool nativeOpenAL = settings->get("UseNativeOpenAL").toBool();
-    bool nativeGLFW = settings->get("UseNativeGLFW").toBool();
-
-    auto outputPath  = minecraftInstance->getNativePath();
-    auto javaVersion = minecraftInstance->getJavaVersion();
-    bool jniHackEnabled = javaVersion.major() >= 8;
-    for(const auto &source: toExtract)
+    // shared by every launch that needs the same natives, and only extracted by the first one
+    QString error;
+    if(!NativesCache::extract(toExtract, minecraftInstance->getNativesOptions(), error))
     {
-        if(!unzipNatives(source, outputPath, jniHackEnabled, nativeOpenAL, nativeGLFW))
-        {
-            const char *reason = QT_TR_NOOP("Couldn't extract native jar '%1' to destination '%2'");
-            emit logLine(QString(reason).arg(source, outputPath), MessageLevel::Fatal);
-            emitFailed(tr(reason).arg(source, outputPath));
-        }
+        emit logLine(error, MessageLevel::Fatal);
+        emitFailed(error);
+        return;
     }
     emitSucceeded();
 }
 
 void ExtractNatives::finalize()
 {
+    // left behind by older versions, which extracted the natives into the instance
     auto instance = m_parent->instance();
     QString target_dir = FS::PathCombine(instance->instanceRoot(), "natives/");
     QDir dir(target_dir);
@@ -18,6 +18,7 @@
 #include "minecraft/PackProfile.h"
 #include "minecraft/AssetsUtils.h"
 #include "launch/LaunchTask.h"
+#include "Application.h"
 
 void ReconstructAssets::executeTask()
 {
@@ -27,7 +28,9 @@ void ReconstructAssets::executeTask()
     auto profile = components->getProfile();
     auto assets = profile->getMinecraftAssets();
 
-    if(!AssetsUtils::reconstructAssets(assets->id, minecraftInstance->resourcesDir()))
+    // same trade-off as the content store: hardlinks save space, but share the file with the object
+    bool allowHardlinks = APPLICATION->settings()->get("ContentStoreHardlinks").toBool();
+    if(!AssetsUtils::reconstructAssets(assets->id, minecraftInstance->resourcesDir(), allowHardlinks))
     {
         emit logLine("Failed to reconstruct Minecraft assets.", MessageLevel::Error);
     }
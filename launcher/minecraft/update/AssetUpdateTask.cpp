@@ -4,16 +4,25 @@
 #include "minecraft/PackProfile.h"
 #include "net/ChecksumValidator.h"
 #include "minecraft/AssetsUtils.h"
+#include "minecraft/VerifiedObjects.h"
 
 #include "Application.h"
 
-AssetUpdateTask::AssetUpdateTask(MinecraftInstance * inst)
+AssetUpdateTask::AssetUpdateTask(MinecraftInstance * inst, AssetsUtils::CheckMode mode)
 {
     m_inst = inst;
+    m_mode = mode;
+    connect(&m_checkWatcher, &QFutureWatcher<int>::finished, this, &AssetUpdateTask::objectsChecked);
+    connect(&m_checkWatcher, &QFutureWatcher<int>::progressValueChanged, this, [this](int value)
+    {
+        setProgress(value, m_checkWatcher.progressMaximum());
+    });
 }
 
 AssetUpdateTask::~AssetUpdateTask()
 {
+    m_checkWatcher.cancel();
+    m_checkWatcher.waitForFinished();
 }
 
 void AssetUpdateTask::executeTask()
@@ -28,6 +37,7 @@ void AssetUpdateTask::executeTask()
         tr("Asset index for %1").arg(m_inst->name()),
         APPLICATION->network()
     );
+    job->setPriority(Net::Priority::Interactive);
 
     auto metacache = APPLICATION->metacache();
     auto entry = metacache->resolveEntry("asset_indexes", localPath);
@@ -71,9 +81,31 @@ void AssetUpdateTask::assetIndexFinished()
         auto entry = metacache->resolveEntry("asset_indexes", assets->id + ".json");
         metacache->evictEntry(entry);
         emitFailed(tr("Failed to read the assets index!"));
+        return;
     }
 
-    auto job = index.getDownloadJob();
+    // stat the objects on the thread pool, there are thousands of them
+    setStatus(tr("Checking the assets..."));
+    m_index = index;
+    m_checkWatcher.setFuture(AssetsUtils::checkObjects(m_index, m_mode));
+}
+
+void AssetUpdateTask::objectsChecked()
+{
+    if (m_checkWatcher.isCanceled())
+    {
+        emitAborted();
+        return;
+    }
+    AssetsUtils::verifiedObjects().save();
+    auto missing = m_checkWatcher.future().results();
+    qDebug() << m_inst->name() << ":" << missing.size() << "of" << m_index.count() << "asset objects need to be downloaded";
+    if(m_mode == AssetsUtils::CheckMode::Full && missing.size())
+    {
+        logWarning(tr("%n asset object(s) are missing or damaged and will be downloaded again.", "", missing.size()));
+    }
+
+    auto job = m_index.getDownloadJob(missing);
     if(job)
     {
         setStatus(tr("Getting the assets files from Mojang..."));
@@ -81,6 +113,7 @@ void AssetUpdateTask::assetIndexFinished()
         connect(downloadJob.get(), &NetJob::succeeded, this, &AssetUpdateTask::emitSucceeded);
         connect(downloadJob.get(), &NetJob::failed, this, &AssetUpdateTask::assetsFailed);
         connect(downloadJob.get(), &NetJob::progress, this, &AssetUpdateTask::progress);
+        connect(downloadJob.get(), &NetJob::status, this, &AssetUpdateTask::setStatus);
         downloadJob->start();
         return;
     }
@@ -100,6 +133,11 @@ void AssetUpdateTask::assetsFailed(QString reason)
 
 bool AssetUpdateTask::abort()
 {
+    if(m_checkWatcher.isRunning())
+    {
+        m_checkWatcher.cancel();
+        return true;
+    }
     if(downloadJob)
     {
         return downloadJob->abort();
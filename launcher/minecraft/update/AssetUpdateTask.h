@@ -1,13 +1,15 @@
 #pragma once
 #include "tasks/Task.h"
 #include "net/NetJob.h"
+#include "minecraft/AssetsUtils.h"
+#include <QFutureWatcher>
 class MinecraftInstance;
 
 class AssetUpdateTask : public Task
 {
     Q_OBJECT
 public:
-    AssetUpdateTask(MinecraftInstance * inst);
+    AssetUpdateTask(MinecraftInstance * inst, AssetsUtils::CheckMode mode = AssetsUtils::CheckMode::Size);
     virtual ~AssetUpdateTask();
 
     void executeTask() override;
@@ -17,6 +19,7 @@ public:
 private slots:
     void assetIndexFinished();
     void assetIndexFailed(QString reason);
+    void objectsChecked();
     void assetsFailed(QString reason);
 
 public slots:
@@ -24,5 +27,8 @@ public slots:
 
 private:
     MinecraftInstance *m_inst;
+    AssetsUtils::CheckMode m_mode;
     NetJob::Ptr downloadJob;
+    AssetsIndex m_index;
+    QFutureWatcher<int> m_checkWatcher;
 };
@@ -62,6 +62,7 @@ void FMLLibrariesTask::executeTask()
     // download missing libs to our place
     setStatus(tr("Downloading FML libraries..."));
     auto dljob = new NetJob("FML libraries", APPLICATION->network());
+    dljob->setPriority(Net::Priority::Interactive);
     auto metacache = APPLICATION->metacache();
     for (auto &lib : fmlLibsToProcess)
     {
@@ -12,6 +12,37 @@ LibrariesTask::LibrariesTask(MinecraftInstance * inst)
 
 void LibrariesTask::executeTask()
 {
+    setStatus(tr("Checking the library files..."));
+    m_aborted = false;
+    MinecraftInstance *inst = (MinecraftInstance *)m_inst;
+
+    // look at all the cached files in one go, so changed files get hashed in parallel and off the GUI thread
+    auto profile = inst->getPackProfile()->getProfile();
+    QList<LibraryPtr> libraries;
+    libraries.append(profile->getLibraries());
+    libraries.append(profile->getNativeLibraries());
+    libraries.append(profile->getMavenFiles());
+    libraries.append(profile->getMainJar());
+    libraries.append(profile->getJarMods());
+    QStringList storage;
+    for (auto lib : libraries)
+    {
+        if(lib)
+        {
+            storage.append(lib->getCachedStorage(currentSystem));
+        }
+    }
+    storage.removeDuplicates();
+    connect(&m_checkWatcher, &QFutureWatcher<QList<MetaEntryPtr>>::finished, this, &LibrariesTask::librariesChecked, Qt::UniqueConnection);
+    m_checkWatcher.setFuture(APPLICATION->metacache()->resolveEntries("libraries", storage));
+}
+
+void LibrariesTask::librariesChecked()
+{
+    if(m_aborted)
+    {
+        return;
+    }
     setStatus(tr("Getting the library files from Mojang..."));
     qDebug() << m_inst->name() << ": downloading libraries";
     MinecraftInstance *inst = (MinecraftInstance *)m_inst;
@@ -21,9 +52,19 @@ void LibrariesTask::executeTask()
     auto profile = components->getProfile();
 
     auto job = new NetJob(tr("Libraries for instance %1").arg(inst->name()), APPLICATION->network());
+    job->setPriority(Net::Priority::Interactive);
     downloadJob.reset(job);
 
     auto metacache = APPLICATION->metacache();
+    // what executeTask() resolved, so nothing is looked at twice
+    QHash<QString, MetaEntryPtr> resolved;
+    for(auto &entry: m_checkWatcher.result())
+    {
+        if(entry)
+        {
+            resolved.insert(entry->getRelativePath(), entry);
+        }
+    }
 
     auto processArtifactPool = [&](const QList<LibraryPtr> & pool, QStringList & errors, const QString & localPath)
     {
@@ -34,7 +75,7 @@ void LibrariesTask::executeTask()
                 emitFailed(tr("Null jar is specified in the metadata, aborting."));
                 return false;
             }
-            auto dls = lib->getDownloads(currentSystem, metacache.get(), errors, localPath);
+            auto dls = lib->getDownloads(currentSystem, metacache.get(), resolved, errors, localPath);
             for(auto dl : dls)
             {
                 downloadJob->addNetAction(dl);
@@ -65,6 +106,7 @@ void LibrariesTask::executeTask()
     connect(downloadJob.get(), &NetJob::succeeded, this, &LibrariesTask::emitSucceeded);
     connect(downloadJob.get(), &NetJob::failed, this, &LibrariesTask::jarlibFailed);
     connect(downloadJob.get(), &NetJob::progress, this, &LibrariesTask::progress);
+    connect(downloadJob.get(), &NetJob::status, this, &LibrariesTask::setStatus);
     downloadJob->start();
 }
 
@@ -84,6 +126,11 @@ bool LibrariesTask::abort()
     {
         return downloadJob->abort();
     }
+    else if(m_checkWatcher.isRunning())
+    {
+        m_aborted = true;
+        emitFailed(tr("Aborted while checking the library files."));
+    }
     else
     {
         qWarning() << "Prematurely aborted LibrariesTask";
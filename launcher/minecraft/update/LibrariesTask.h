@@ -1,6 +1,8 @@
 #pragma once
 #include "tasks/Task.h"
 #include "net/NetJob.h"
+#include <QFutureWatcher>
+#include "net/HttpMetaCache.h"
 class MinecraftInstance;
 
 class LibrariesTask : public Task
@@ -15,6 +17,7 @@ public:
     bool canAbort() const override;
 
 private slots:
+    void librariesChecked();
     void jarlibFailed(QString reason);
 
 public slots:
@@ -23,4 +26,6 @@ public slots:
 private:
     MinecraftInstance *m_inst;
     NetJob::Ptr downloadJob;
+    QFutureWatcher<QList<MetaEntryPtr>> m_checkWatcher;
+    bool m_aborted = false;
 };
@@ -0,0 +1,178 @@
+#include "VerifyLibrariesTask.h"
+
+#include "minecraft/MinecraftInstance.h"
+#include "minecraft/PackProfile.h"
+#include "hashing/MultiHash.h"
+#include "FileSystem.h"
+
+#include "Application.h"
+
+#include <QFileInfo>
+#include <QSet>
+#include <QtConcurrentFilter>
+#include <quazip.h>
+#include <quazipfile.h>
+
+VerifyLibrariesTask::VerifyLibrariesTask(MinecraftInstance * inst)
+{
+    m_inst = inst;
+    connect(&m_checkWatcher, &QFutureWatcher<int>::finished, this, &VerifyLibrariesTask::filesChecked);
+    connect(&m_checkWatcher, &QFutureWatcher<int>::progressValueChanged, this, [this](int value)
+    {
+        setProgress(value, m_checkWatcher.progressMaximum());
+    });
+}
+
+VerifyLibrariesTask::~VerifyLibrariesTask()
+{
+    m_checkWatcher.cancel();
+    m_checkWatcher.waitForFinished();
+}
+
+bool VerifyLibrariesTask::fileIsGood(const File &file)
+{
+    if (!QFileInfo(file.path).isFile())
+    {
+        return true;
+    }
+    if (!file.sha1.isEmpty())
+    {
+        return Hashing::MultiHash::hashFile(Hashing::Algorithm::Sha1, file.path) == file.sha1;
+    }
+    // nothing to compare with, but an archive can at least be read back completely
+    if (!file.path.endsWith(".jar", Qt::CaseInsensitive) && !file.path.endsWith(".zip", Qt::CaseInsensitive))
+    {
+        return true;
+    }
+    QuaZip zip(file.path);
+    if (!zip.open(QuaZip::mdUnzip))
+    {
+        return false;
+    }
+    QuaZipFile entry(&zip);
+    char buffer[64 * 1024];
+    for (bool more = zip.goToFirstFile(); more; more = zip.goToNextFile())
+    {
+        if (!entry.open(QIODevice::ReadOnly))
+        {
+            return false;
+        }
+        qint64 read;
+        while ((read = entry.read(buffer, sizeof(buffer))) > 0)
+        {
+        }
+        // closing checks the CRC of everything that was read
+        entry.close();
+        if (read < 0 || entry.getZipError() != UNZ_OK)
+        {
+            return false;
+        }
+    }
+    return zip.getZipError() == UNZ_OK;
+}
+
+void VerifyLibrariesTask::executeTask()
+{
+    setStatus(tr("Verifying the library files..."));
+    auto profile = m_inst->getPackProfile()->getProfile();
+    auto base = APPLICATION->metacache()->getBasePath("libraries");
+
+    m_files.clear();
+    QSet<QString> seen;
+    auto addFile = [&](const File &file)
+    {
+        if (!seen.contains(file.path))
+        {
+            seen.insert(file.path);
+            m_files.append(file);
+        }
+    };
+    auto addPool = [&](const QList<LibraryPtr> &pool, const QString &overridePath)
+    {
+        for (auto lib : pool)
+        {
+            if (!lib)
+            {
+                continue;
+            }
+            if (lib->isLocal())
+            {
+                QStringList jar, native, native32, native64;
+                lib->getApplicableFiles(currentSystem, jar, native, native32, native64, overridePath);
+                for (auto &path : jar + native + native32 + native64)
+                {
+                    addFile({path, QString(), QByteArray()});
+                }
+                continue;
+            }
+            auto checksums = lib->getCachedChecksums(currentSystem);
+            for (auto iter = checksums.begin(); iter != checksums.end(); iter++)
+            {
+                addFile({FS::PathCombine(base, iter.key()), iter.key(), QByteArray::fromHex(iter.value().toLatin1())});
+            }
+        }
+    };
+
+    QList<LibraryPtr> libraries;
+    libraries.append(profile->getLibraries());
+    libraries.append(profile->getNativeLibraries());
+    libraries.append(profile->getMavenFiles());
+    libraries.append(profile->getMainJar());
+    addPool(libraries, m_inst->getLocalLibraryPath());
+    addPool(profile->getJarMods(), m_inst->jarModsDir());
+
+    QVector<int> positions;
+    for (int i = 0; i < m_files.size(); i++)
+    {
+        positions.append(i);
+    }
+    auto files = m_files;
+    std::function<bool(int)> isDamaged = [files](int position)
+    {
+        return !fileIsGood(files[position]);
+    };
+    m_checkWatcher.setFuture(QtConcurrent::filtered(positions, isDamaged));
+}
+
+void VerifyLibrariesTask::filesChecked()
+{
+    if (m_checkWatcher.isCanceled())
+    {
+        emitAborted();
+        return;
+    }
+    auto damaged = m_checkWatcher.future().results();
+    qDebug() << m_inst->name() << ":" << damaged.size() << "of" << m_files.size() << "library files are damaged";
+    for (auto position : damaged)
+    {
+        auto &file = m_files[position];
+        auto name = QFileInfo(file.path).fileName();
+        if (file.storage.isEmpty())
+        {
+            logWarning(tr("%1 is damaged and can't be downloaded again, it has to be replaced by hand.").arg(name));
+            continue;
+        }
+        // the metacache drops entries whose file is gone, so the libraries get downloaded again
+        if (!QFile::remove(file.path))
+        {
+            logWarning(tr("%1 is damaged, but it could not be removed.").arg(name));
+            continue;
+        }
+        logWarning(tr("%1 is damaged and will be downloaded again.").arg(name));
+    }
+    emitSucceeded();
+}
+
+bool VerifyLibrariesTask::canAbort() const
+{
+    return true;
+}
+
+bool VerifyLibrariesTask::abort()
+{
+    if (m_checkWatcher.isRunning())
+    {
+        m_checkWatcher.cancel();
+    }
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "tasks/Task.h"
+#include <QFutureWatcher>
+#include <QVector>
+class MinecraftInstance;
+
+/*
+ * Hashes the libraries, natives, main jar and jar mods of an instance on the thread pool and removes the damaged
+ * shared files, so the LibrariesTask that runs after it downloads them again.
+ */
+class VerifyLibrariesTask : public Task
+{
+    Q_OBJECT
+public:
+    struct File
+    {
+        QString path;
+        // path in the "libraries" metacache base, empty for files that live in the instance
+        QString storage;
+        // raw SHA-1 from the metadata, empty if it doesn't say
+        QByteArray sha1;
+    };
+
+    VerifyLibrariesTask(MinecraftInstance * inst);
+    virtual ~VerifyLibrariesTask();
+
+    void executeTask() override;
+
+    bool canAbort() const override;
+
+    /// Check a single file. Missing files pass, getting them is up to the downloads
+    static bool fileIsGood(const File &file);
+
+private slots:
+    void filesChecked();
+
+public slots:
+    bool abort() override;
+
+private:
+    MinecraftInstance *m_inst;
+    QVector<File> m_files;
+    QFutureWatcher<int> m_checkWatcher;
+};
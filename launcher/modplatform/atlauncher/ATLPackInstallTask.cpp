@@ -538,6 +538,7 @@ void PackInstallTask::downloadMods()
 
     jarmods.clear();
     jobPtr = new NetJob(tr("Mod download"), APPLICATION->network());
+    m_storedFiles.reset(new ContentStore::Batch(APPLICATION->contentStore()));
     for(const auto& mod : m_version.mods) {
         // skip non-client mods
         if(!mod.client) continue;
@@ -592,19 +593,24 @@ void PackInstallTask::downloadMods()
             auto relpath = getDirForModType(mod.type, mod.type_raw);
             if(relpath == Q_NULLPTR) continue;
 
-            auto entry = APPLICATION->metacache()->resolveEntry("ATLauncherPacks", cacheName);
-            entry->setStale(true);
-
-            auto dl = Net::Download::makeCached(url, entry);
+            auto path = FS::PathCombine(m_stagingPath, "minecraft", relpath, mod.file);
             if (!mod.md5.isEmpty()) {
                 auto rawMd5 = QByteArray::fromHex(mod.md5.toLatin1());
-                dl->addValidator(new Net::ChecksumValidator(QCryptographicHash::Md5, rawMd5));
+                auto dl = m_storedFiles->add(url, QCryptographicHash::Md5, rawMd5, path);
+                if (dl) {
+                    jobPtr->addNetAction(dl);
+                }
             }
-            jobPtr->addNetAction(dl);
+            else {
+                auto entry = APPLICATION->metacache()->resolveEntry("ATLauncherPacks", cacheName);
+                entry->setStale(true);
 
-            auto path = FS::PathCombine(m_stagingPath, "minecraft", relpath, mod.file);
-            qDebug() << "Will download" << url << "to" << path;
-            modsToCopy[entry->getFullPath()] = path;
+                auto dl = Net::Download::makeCached(url, entry);
+                jobPtr->addNetAction(dl);
+
+                qDebug() << "Will download" << url << "to" << path;
+                modsToCopy[entry->getFullPath()] = path;
+            }
 
             if(mod.type == ModType::Forge) {
                 auto vlist = APPLICATION->metadataIndex()->get("net.minecraftforge");
@@ -651,6 +657,15 @@ void PackInstallTask::onModsDownloaded() {
     qDebug() << "PackInstallTask::onModsDownloaded: " << QThread::currentThreadId();
     jobPtr.reset();
 
+    if (m_storedFiles) {
+        auto failed = m_storedFiles->place();
+        m_storedFiles.reset();
+        if (!failed.isEmpty()) {
+            emitFailed(tr("Failed to place mods:\n%1").arg(failed.join("\n")));
+            return;
+        }
+    }
+
     if(!modsToExtract.empty() || !modsToDecomp.empty() || !modsToCopy.empty()) {
         m_modExtractFuture = QtConcurrent::run(QThreadPool::globalInstance(), this, &PackInstallTask::extractMods, modsToExtract, modsToDecomp, modsToCopy);
         connect(&m_modExtractFutureWatcher, &QFutureWatcher<QStringList>::finished, this, &PackInstallTask::onModsExtracted);
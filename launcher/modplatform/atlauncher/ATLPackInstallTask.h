@@ -22,6 +22,7 @@
 
 #include "InstanceTask.h"
 #include "net/NetJob.h"
+#include "ContentStore.h"
 #include "settings/INISettingsObject.h"
 #include "minecraft/MinecraftInstance.h"
 #include "minecraft/PackProfile.h"
@@ -107,6 +108,7 @@ private:
     QMap<QString, VersionMod> modsToExtract;
     QMap<QString, VersionMod> modsToDecomp;
     QMap<QString, QString> modsToCopy;
+    std::unique_ptr<ContentStore::Batch> m_storedFiles;
 
     QString archivePath;
     QStringList jarmods;
@@ -205,6 +205,15 @@ void CurseForge::FileResolvingTask::netJobFinished()
                 {
                     throw JSONValidationError(QString("Invalid URL: %1").arg(rawUrl));
                 }
+                for(auto hashValue: Json::ensureArray(modObj, "hashes"))
+                {
+                    auto hashObj = hashValue.toObject();
+                    // algo 1 is SHA-1, 2 is MD5
+                    if(hashObj.value("algo").toInt() == 1)
+                    {
+                        m_file.sha1 = QByteArray::fromHex(hashObj.value("value").toString().toLatin1());
+                    }
+                }
             }
         }
     }
@@ -20,6 +20,8 @@ struct File
     bool resolved = false;
     QString fileName;
     QUrl url;
+    // raw SHA-1 of the file, if CurseForge told us
+    QByteArray sha1;
     QString targetFolder = QLatin1Literal("mods");
     enum class Type
     {
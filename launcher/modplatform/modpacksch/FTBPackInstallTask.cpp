@@ -157,9 +157,19 @@ void PackInstallTask::downloadPack()
     setStatus(tr("Downloading mods..."));
 
     jobPtr = new NetJob(tr("Mod download"), APPLICATION->network());
+    m_storedFiles.reset(new ContentStore::Batch(APPLICATION->contentStore()));
     for(auto file : m_version.files) {
         if(file.serverOnly) continue;
 
+        if (file.type != "cf-extract" && !file.sha1.isEmpty()) {
+            auto path = FS::PathCombine(m_stagingPath, "minecraft", file.path, file.name);
+            auto dl = m_storedFiles->add(file.url, QCryptographicHash::Sha1, QByteArray::fromHex(file.sha1.toLatin1()), path);
+            if (dl) {
+                jobPtr->addNetAction(dl);
+            }
+            continue;
+        }
+
         QFileInfo fileName(file.name);
         auto cacheName = fileName.completeBaseName() + "-" + file.sha1 + "." + fileName.suffix();
 
@@ -212,6 +222,16 @@ void PackInstallTask::downloadPack()
 
 void PackInstallTask::install()
 {
+    if (m_storedFiles) {
+        setStatus(tr("Placing stored files"));
+        auto failed = m_storedFiles->place();
+        m_storedFiles.reset();
+        if (!failed.isEmpty()) {
+            emitFailed(tr("Failed to place files:\n%1").arg(failed.join("\n")));
+            return;
+        }
+    }
+
     if (!filesToCopy.isEmpty()) {
         setStatus(tr("Copying modpack files"));
 
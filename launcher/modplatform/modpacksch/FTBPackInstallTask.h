@@ -22,6 +22,7 @@
 
 #include "InstanceTask.h"
 #include "net/NetJob.h"
+#include "ContentStore.h"
 
 namespace ModpacksCH {
 
@@ -63,6 +64,7 @@ private:
 
     QMap<QString, VersionFile> filesToExtract;
     QMap<QString, QString> filesToCopy;
+    std::unique_ptr<ContentStore::Batch> m_storedFiles;
 
 };
 
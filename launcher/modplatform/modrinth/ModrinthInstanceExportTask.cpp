@@ -7,7 +7,6 @@
 
 #include <QDir>
 #include <QDirIterator>
-#include <QCryptographicHash>
 #include <QMap>
 #include "Json.h"
 #include "ModrinthInstanceExportTask.h"
@@ -16,6 +15,7 @@
 #include "ui/dialogs/ModrinthExportDialog.h"
 #include "JlCompress.h"
 #include "FileSystem.h"
+#include "hashing/MultiHash.h"
 #include "ModrinthHashLookupRequest.h"
 
 namespace Modrinth
@@ -92,16 +92,13 @@ void InstanceExportTask::executeTask()
     setProgress(progress, filesToResolve.length());
     for (const QString &filePath: filesToResolve) {
         qDebug() << "Attempting to resolve file hash from Modrinth API: " << filePath;
-        QFile file(filePath);
+        Hashing::MultiHash hasher(Hashing::Algorithm::Sha512);
 
-        if (file.open(QFile::ReadOnly)) {
-            QByteArray contents = file.readAll();
-            QCryptographicHash hasher(QCryptographicHash::Sha512);
-            hasher.addData(contents);
-            QString hash = hasher.result().toHex();
+        if (hasher.addFile(filePath)) {
+            QString hash = hasher.result(Hashing::Algorithm::Sha512).toHex();
 
             hashes.append(HashLookupData {
-                QFileInfo(file),
+                QFileInfo(filePath),
                 hash
             });
 
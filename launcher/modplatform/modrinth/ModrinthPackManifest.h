@@ -26,6 +26,8 @@ struct File
     QString path;
     QCryptographicHash::Algorithm hashAlgorithm;
     QByteArray hash;
+    // what the file is stored under in the content store, if the pack has it
+    QByteArray sha1;
     // TODO: should this support multiple download URLs, like the JSON does?
     QUrl download;
 };
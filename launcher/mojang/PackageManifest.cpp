@@ -9,7 +9,7 @@
 #include <Json.h>
 #include <QDir>
 #include <QDirIterator>
-#include <QCryptographicHash>
+#include "hashing/MultiHash.h"
 #include <QDebug>
 
 #ifndef Q_OS_WIN32
@@ -268,14 +268,14 @@ Package Package::fromInspectedFolder(const QString& folderPath)
             File f;
             f.executable = fileInfo.isExecutable();
             f.size = fileInfo.size();
-            // FIXME: async / optimize the hashing
-            QFile input(fileInfo.absoluteFilePath());
-            if(!input.open(QIODevice::ReadOnly)) {
-                qCritical() << "Folder inspection: Failed to open file:" << fileInfo.absoluteFilePath();
+            // FIXME: async the hashing
+            Hashing::MultiHash hasher(Hashing::Algorithm::Sha1);
+            if(!hasher.addFile(fileInfo.absoluteFilePath())) {
+                qCritical() << "Folder inspection: Failed to read file:" << fileInfo.absoluteFilePath();
                 out.valid = false;
                 break;
             }
-            f.hash = QCryptographicHash::hash(input.readAll(), QCryptographicHash::Sha1).toHex().constData();
+            f.hash = hasher.result(Hashing::Algorithm::Sha1).toHex().constData();
             out.addFile(relPath, f);
         }
         else {
@@ -0,0 +1,53 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "NetAction.h"
+
+namespace Net {
+/*
+ * Hands a NetJob its actions one at a time, when the job has room for them.
+ *
+ * Actions from a source are only created once the job is about to start them, and the job lets
+ * go of them as soon as they succeed, so a job with thousands of parts does not keep thousands
+ * of downloads (with their sinks and validators) alive.
+ */
+class ActionSource
+{
+public: /* types */
+    using Ptr = std::shared_ptr<ActionSource>;
+
+public: /* con/des */
+    ActionSource() {};
+    virtual ~ActionSource() {};
+
+public: /* methods */
+    // the next action, or nullptr if there are no more
+    virtual NetAction::Ptr next() = 0;
+    // how many actions may still come, -1 if that is not known
+    virtual int remainingCount() const
+    {
+        return -1;
+    }
+    // how many bytes the remaining actions may transfer, -1 if that is not known
+    virtual qint64 remainingBytes() const
+    {
+        return -1;
+    }
+};
+}
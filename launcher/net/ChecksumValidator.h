@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Validator.h"
+#include "hashing/MultiHash.h"
 #include <QCryptographicHash>
 #include <memory>
 #include <QFile>
@@ -10,22 +11,62 @@ class ChecksumValidator: public Validator
 {
 public: /* con/des */
     ChecksumValidator(QCryptographicHash::Algorithm algorithm, QByteArray expected = QByteArray())
-        :m_checksum(algorithm), m_expected(expected)
+        :m_expected(expected)
     {
+        Hashing::Algorithm ours;
+        if(Hashing::fromQt(algorithm, ours))
+        {
+            m_checksum = std::make_shared<Hashing::MultiHash>(ours);
+            m_algorithm = ours;
+        }
+        else
+        {
+            m_fallback.reset(new QCryptographicHash(algorithm));
+        }
     };
     virtual ~ChecksumValidator() {};
 
 public: /* methods */
     bool init(QNetworkRequest &) override
     {
-        m_checksum.reset();
+        if(m_fallback)
+        {
+            m_fallback->reset();
+        }
+        else if(!m_shared)
+        {
+            m_checksum->reset();
+        }
         return true;
     }
     bool write(QByteArray & data) override
     {
-        m_checksum.addData(data);
+        if(m_fallback)
+        {
+            m_fallback->addData(data);
+        }
+        else if(!m_shared)
+        {
+            m_checksum->addData(data);
+        }
         return true;
     }
+    Hashing::Algorithms hashes() const override
+    {
+        if(m_fallback)
+        {
+            return Hashing::Algorithms();
+        }
+        return m_algorithm;
+    }
+    void useHashes(std::shared_ptr<Hashing::MultiHash> hashes) override
+    {
+        if(!m_fallback && hashes && hashes->algorithms().testFlag(m_algorithm))
+        {
+            m_checksum = hashes;
+            m_shared = true;
+        }
+    }
     bool abort() override
     {
         return true;
@@ -41,7 +82,11 @@ public: /* methods */
     }
     QByteArray hash()
     {
-        return m_checksum.result();
+        if(m_checksum)
+        {
+            return m_checksum->result(m_algorithm);
+        }
+        return m_fallback->result();
     }
     void setExpected(QByteArray expected)
     {
@@ -49,7 +94,12 @@ public: /* methods */
     }
 
 private: /* data */
-    QCryptographicHash m_checksum;
+    // our own, or the one the sink feeds for all its validators
+    std::shared_ptr<Hashing::MultiHash> m_checksum;
+    bool m_shared = false;
+    Hashing::Algorithm m_algorithm = Hashing::Algorithm::Md5;
+    // for what the hashing engine doesn't do
+    std::unique_ptr<QCryptographicHash> m_fallback;
     QByteArray m_expected;
 };
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "ConnectionWarmer.h"
+
+#include <QDebug>
+#include <QSet>
+#include <QSslConfiguration>
+
+namespace Net {
+
+namespace {
+// idle connections are dropped by the network access manager after two minutes
+const qint64 WarmForMs = 110 * 1000;
+}
+
+void ConnectionWarmer::warmUp(QNetworkAccessManager *network, const QList<QUrl> &urls)
+{
+    QSet<QString> done;
+    for(auto & url: urls)
+    {
+        auto host = url.host();
+        if(host.isEmpty() || done.contains(host))
+        {
+            continue;
+        }
+        done.insert(host);
+        auto &state = m_hosts[host];
+        if(state.warm && state.warmedAt.elapsed() < WarmForMs)
+        {
+            continue;
+        }
+        state.warm = true;
+        state.warmedAt.start();
+        if(url.scheme() == "https")
+        {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+            auto config = QSslConfiguration::defaultConfiguration();
+            if(m_http2Allowed)
+            {
+                config.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2, QSslConfiguration::NextProtocolHttp1_1});
+            }
+            network->connectToHostEncrypted(host, url.port(443), config);
+#else
+            network->connectToHostEncrypted(host, url.port(443));
+#endif
+        }
+        else
+        {
+            network->connectToHost(host, url.port(80));
+        }
+        qDebug() << "Warming up a connection to" << host;
+    }
+}
+
+void ConnectionWarmer::recordHandshake(const QString &host, qint64 ms)
+{
+    auto &state = m_hosts[host];
+    state.samples++;
+    state.handshakeMs = state.samples == 1 ? ms : state.handshakeMs * 0.7 + ms * 0.3;
+}
+
+bool ConnectionWarmer::takeWarm(const QString &host, qint64 &savedMs)
+{
+    auto iter = m_hosts.find(host);
+    if(iter == m_hosts.end() || !iter->warm)
+    {
+        return false;
+    }
+    iter->warm = false;
+    if(iter->warmedAt.elapsed() >= WarmForMs)
+    {
+        return false;
+    }
+    // nothing to compare with until a cold connection to the host was seen
+    savedMs = iter->samples ? qRound64(iter->handshakeMs) : 0;
+    return true;
+}
+
+void ConnectionWarmer::prepare(QNetworkRequest &request) const
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, m_http2Allowed);
+#else
+    // older HTTP/2 support has known bugs, they keep speaking HTTP/1.1
+    Q_UNUSED(request);
+#endif
+}
+
+bool ConnectionWarmer::usedHttp2(QNetworkReply &reply)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    return reply.attribute(QNetworkRequest::Http2WasUsedAttribute).toBool();
+#else
+    Q_UNUSED(reply);
+    return false;
+#endif
+}
+
+void ConnectionWarmer::enableSessionReuse()
+{
+    auto config = QSslConfiguration::defaultConfiguration();
+    config.setSslOption(QSsl::SslOptionDisableSessionSharing, false);
+    config.setSslOption(QSsl::SslOptionDisableSessionPersistence, false);
+    QSslConfiguration::setDefaultConfiguration(config);
+}
+}
@@ -0,0 +1,73 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QUrl>
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+
+namespace Net {
+/*
+ * Opens connections to the hosts the next downloads are going to need before they are needed,
+ * so name resolution and the TCP and TLS handshakes are out of the way by the time they start.
+ *
+ * It also learns how long a cold connection to each host takes, which is what a request that
+ * finds a warm one saves.
+ */
+class ConnectionWarmer
+{
+public: /* methods */
+    // connect to the hosts of the URLs, unless there should still be a connection to them
+    void warmUp(QNetworkAccessManager *network, const QList<QUrl> &urls);
+    // a request had to set up a new connection to the host, which took this long
+    void recordHandshake(const QString &host, qint64 ms);
+    // true if the host was warmed up for this request. The first request after a warm up takes it
+    bool takeWarm(const QString &host, qint64 &savedMs);
+
+    void setHttp2Allowed(bool allowed)
+    {
+        m_http2Allowed = allowed;
+    }
+    bool http2Allowed() const
+    {
+        return m_http2Allowed;
+    }
+    // ask for HTTP/2 if the host speaks it, HTTP/1.1 otherwise. Only with Qt 5.15 and later
+    void prepare(QNetworkRequest &request) const;
+    static bool usedHttp2(QNetworkReply &reply);
+    // keep TLS sessions around for resuming them on new connections
+    static void enableSessionReuse();
+
+private: /* types */
+    struct Host
+    {
+        QElapsedTimer warmedAt;
+        bool warm = false;
+        // moving average of the time to set up a new connection, including name resolution
+        double handshakeMs = 0;
+        int samples = 0;
+    };
+
+private: /* data */
+    QHash<QString, Host> m_hosts;
+    bool m_http2Allowed = true;
+};
+}
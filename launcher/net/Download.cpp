@@ -18,20 +18,43 @@
 #include <QFileInfo>
 #include <QDateTime>
 #include <QDebug>
+#include <QtConcurrentRun>
+
+#include <algorithm>
 
 #include "FileSystem.h"
-#include "Application.h"
 #include "ChecksumValidator.h"
 #include "MetaCacheSink.h"
 #include "ByteArraySink.h"
+#include "Scheduler.h"
 
 #include "BuildConfig.h"
 
 namespace Net {
 
+namespace {
+// bodies smaller than this come in one piece
+const qint64 SegmentThreshold = 32 * 1024 * 1024;
+const qint64 MinSegmentSize = 8 * 1024 * 1024;
+const int MaxSegments = 4;
+// body data waiting for the disk. Past this, the reply stops reading from the network until a write finishes
+const qint64 MaxPendingWrite = 8 * 1024 * 1024;
+}
+
 Download::Download():NetAction()
 {
     m_status = Job_NotStarted;
+    connect(&m_writeWatcher, &QFutureWatcher<JobStatus>::finished, this, &Download::writeFinished);
+    m_hedgeTimer.setSingleShot(true);
+    connect(&m_hedgeTimer, &QTimer::timeout, this, &Download::startHedge);
+    connect(&m_segmentCheckWatcher, &QFutureWatcher<JobStatus>::finished, this, &Download::segmentsChecked);
+}
+
+Download::~Download()
+{
+    // the write uses the sink, which goes away with us
+    m_writeWatcher.waitForFinished();
+    m_segmentCheckWatcher.waitForFinished();
 }
 
 Download::Ptr Download::makeCached(QUrl url, MetaEntryPtr entry, Options options)
@@ -43,6 +66,7 @@ Download::Ptr Download::makeCached(QUrl url, MetaEntryPtr entry, Options options
     auto cachedNode = new MetaCacheSink(entry, md5Node);
     dl->m_sink.reset(cachedNode);
     dl->m_target_path = entry->getFullPath();
+    dl->m_target_key = "cache:" + dl->m_target_path;
     return dl;
 }
 
@@ -61,6 +85,7 @@ Download::Ptr Download::makeFile(QUrl url, QString path, Options options)
     dl->m_url = url;
     dl->m_options = options;
     dl->m_sink.reset(new FileSink(path));
+    dl->m_target_key = "file:" + path + "\n" + url.toString();
     return dl;
 }
 
@@ -77,71 +102,73 @@ void Download::startImpl()
         emit aborted(m_index_within_job);
         return;
     }
-    QString source = "Mojang";
-    if(APPLICATION->getconfigfile()){
-        source = APPLICATION->settings()->get("Downloadsource").toString();
+    bool redirected = m_redirecting;
+    bool failingOver = m_failingOver;
+    m_redirecting = false;
+    m_failingOver = false;
+    if(redirected)
+    {
+        m_trace.redirects++;
+    }
+    else if(failingOver)
+    {
+        m_trace.failovers++;
+    }
+    else
+    {
+        m_trace.attempts++;
     }
+    if(m_trace.originalUrl.isEmpty())
+    {
+        m_trace.originalUrl = m_url;
+    }
+    m_trace.restart();
+    m_hedgeTimer.stop();
+    dropHedge();
+    stopSegments();
+    m_segments.clear();
+    m_segmentEnd = 0;
+    m_segmentsRunning = 0;
 
-    if (source != "Mojang")
+    if(redirected)
     {
-        auto settings = APPLICATION->settings();
-        bool useProxy = settings->get("Downloadsourceproxy").toBool();
-        QString baseUrl = settings->get("Downloadsourceurl").toString().trimmed();
-        if (!baseUrl.isEmpty())
+        // send it to the mirror of the download source, if there is one
+        if(m_router)
         {
-            baseUrl = QUrl::fromUserInput(baseUrl).toString();
-            if (!baseUrl.startsWith("https://"))
-            {
-                baseUrl = baseUrl.replace("http://", "https://");
-            }
-            if (!baseUrl.endsWith("/"))
+            auto route = m_router->route(m_url);
+            if(!route.rule.isEmpty())
             {
-                baseUrl.append('/');
+                m_url = route.url;
+                m_trace.rule = route.rule;
             }
         }
-
-        QString host = m_url.toString();
-        struct Replacement {
-            QString search, replace;
-        };
-        Replacement replacements[] = {
-            {"resources.download.minecraft.net", "<j_url>/assets"},
-            {"libraries.minecraft.net", "<j_url>/maven"},
-            {"maven.fabricmc.net", "<j_url>/maven"},
-            {"launchermeta.mojang.com", "<j_url>"},
-            {"launcher.mojang.com", "<j_url>"},
-            {"files.minecraftforge.net", "<j_url>"},
-            {"meta.fabricmc.net", "<j_url>/fabric-meta"},
-            {"maven.neoforged.net/releases", "<j_url>/maven"},
-            {"maven.quiltmc.org/repository/release","<j_url>/maven"},
-            {"meta.quiltmc.org","<j_url>/quilt-meta"},
-            {"edge.forgecdn.net",""},
-            {"mediafilez.forgecdn.net",""}
-        };
-        for (const auto &replacement : replacements)
-        {
-            if (host.contains(replacement.search) && !host.contains(baseUrl))
-            {
-                QString replacementUrl = baseUrl.isEmpty() ? "" : baseUrl + replacement.replace;
-                if (useProxy && !baseUrl.isEmpty())
-                {
-                    m_url = QUrl(baseUrl + host);
-                }
-                else if (!replacementUrl.isEmpty())
-                {
-                    host.replace(replacement.search, replacementUrl);
-                    m_url = QUrl(host);
-                    break;
-                }
-            }
+        m_trace.url = m_url;
+    }
+    else
+    {
+        // every attempt starts with the healthiest mirror
+        if(!failingOver)
+        {
+            m_candidates = candidatesFor(m_trace.originalUrl);
+            m_candidateIndex = 0;
         }
+        useCandidate(m_candidateIndex);
     }
 
+    emit hostChanged(m_index_within_job, m_url.host(), failingOver);
+
     QNetworkRequest request(m_url);
+    m_headersHandled = false;
+    m_pendingData.clear();
+    m_finishPending = false;
     m_status = m_sink->init(request);
+    // the sink changes it on the thread pool later, keep our own copy for the progress reports
+    m_resumeOffset = m_sink->resumeOffset();
     switch(m_status)
     {
         case Job_Finished:
+            m_trace.cacheResult = RequestTrace::CacheResult::Hit;
+            m_trace.success = true;
             emit succeeded(m_index_within_job);
             qDebug() << "Download cache hit " << m_url.toString();
             return;
@@ -161,21 +188,222 @@ void Download::startImpl()
     for(auto iter = m_extra_headers.begin(); iter != m_extra_headers.end(); iter++) {
         request.setRawHeader(iter.key().toUtf8(), iter.value().toUtf8());
     }
+    if(m_scheduler)
+    {
+        m_scheduler->warmer().prepare(request);
+    }
 
+    m_request = request;
     QNetworkReply *rep = m_network->get(request);
+    m_requestTimer.start();
+
+    if(m_limiter && m_limiter->isLimited(m_priority, m_jobBucket.get()))
+    {
+        rep->setReadBufferSize(RateLimiter::ReadBufferSize);
+    }
+    else
+    {
+        rep->setReadBufferSize(MaxPendingWrite);
+    }
 
     m_reply.reset(rep);
+    connectReply(rep);
+
+    // if it takes too long to get an answer, the next mirror gets asked too
+    if(!redirected && m_health && m_candidateIndex + 1 < m_candidates.size())
+    {
+        m_hedgeTimer.start(m_health->hedgeDelay(m_url.host()));
+    }
+}
+
+QList<UrlRouter::Route> Download::candidatesFor(const QUrl &url)
+{
+    QList<UrlRouter::Route> out;
+    if(m_router)
+    {
+        out = m_router->candidates(url);
+    }
+    if(out.isEmpty())
+    {
+        UrlRouter::Route original;
+        original.url = url;
+        out.append(original);
+    }
+    if(m_health)
+    {
+        std::stable_partition(out.begin(), out.end(), [this](const UrlRouter::Route &route)
+        {
+            return !m_health->isDemoted(route.url.host());
+        });
+    }
+    return out;
+}
+
+void Download::useCandidate(int index)
+{
+    m_candidateIndex = index;
+    auto &route = m_candidates[index];
+    m_url = route.url;
+    m_trace.url = m_url;
+    m_trace.rule = route.rule;
+    m_trace.mirror = m_url.host() != m_trace.originalUrl.host() ? m_url.host() : QString();
+}
+
+void Download::connectReply(QNetworkReply *rep)
+{
     connect(rep, SIGNAL(downloadProgress(qint64, qint64)), SLOT(downloadProgress(qint64, qint64)));
     connect(rep, SIGNAL(finished()), SLOT(downloadFinished()));
     connect(rep, SIGNAL(error(QNetworkReply::NetworkError)), SLOT(downloadError(QNetworkReply::NetworkError)));
     connect(rep, &QNetworkReply::sslErrors, this, &Download::sslErrors);
     connect(rep, &QNetworkReply::readyRead, this, &Download::downloadReadyRead);
+    connect(rep, &QNetworkReply::encrypted, this, [this]()
+    {
+        m_trace.encryptedMs = m_requestTimer.elapsed();
+    });
+    connect(rep, &QNetworkReply::metaDataChanged, this, [this]()
+    {
+        if(m_trace.headersMs < 0)
+        {
+            m_trace.headersMs = m_requestTimer.elapsed();
+        }
+        // we have an answer, nobody else needs to be asked
+        m_hedgeTimer.stop();
+        dropHedge();
+    });
+}
+
+void Download::startHedge()
+{
+    if(!m_reply || m_hedge || m_trace.headersMs >= 0 || m_status != Job_InProgress || m_candidateIndex + 1 >= m_candidates.size())
+    {
+        return;
+    }
+    m_hedgeIndex = m_candidateIndex + 1;
+    QNetworkRequest request = m_request;
+    request.setUrl(m_candidates[m_hedgeIndex].url);
+    qDebug() << "No answer from" << m_url.host() << "after" << m_requestTimer.elapsed() << "ms, also asking" << request.url().host();
+    m_hedge.reset(m_network->get(request));
+    if(m_limiter && m_limiter->isLimited(m_priority, m_jobBucket.get()))
+    {
+        m_hedge->setReadBufferSize(RateLimiter::ReadBufferSize);
+    }
+    else
+    {
+        m_hedge->setReadBufferSize(MaxPendingWrite);
+    }
+    connect(m_hedge.get(), &QNetworkReply::metaDataChanged, this, &Download::hedgeResponded);
+    connect(m_hedge.get(), &QNetworkReply::finished, this, &Download::hedgeResponded);
+    m_trace.hedged = true;
+}
+
+void Download::hedgeResponded()
+{
+    if(!m_hedge)
+    {
+        return;
+    }
+    int statusCode = m_hedge->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if(m_hedge->error() != QNetworkReply::NoError || statusCode >= 400)
+    {
+        // no reason to give up on the first one
+        if(m_health)
+        {
+            m_health->recordFailure(m_hedge->url().host());
+        }
+        dropHedge();
+        return;
+    }
+    if(m_health)
+    {
+        m_health->recordSlow(m_url.host());
+    }
+    takeOverHedge();
+}
+
+void Download::dropHedge()
+{
+    if(!m_hedge)
+    {
+        return;
+    }
+    m_hedge->disconnect(this);
+    m_hedge->abort();
+    m_hedge.reset();
+}
+
+void Download::takeOverHedge()
+{
+    qDebug() << "Continuing" << m_trace.originalUrl.toString() << "with" << m_candidates[m_hedgeIndex].url.host();
+    m_hedgeTimer.stop();
+    if(m_reply)
+    {
+        m_reply->disconnect(this);
+        m_reply->abort();
+    }
+    m_hedge->disconnect(this);
+    m_reply = std::move(m_hedge);
+    useCandidate(m_hedgeIndex);
+    emit hostChanged(m_index_within_job, m_url.host(), false);
+    connectReply(m_reply.get());
+    // it may have gotten further than the signals we connected just now
+    if(m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).isValid())
+    {
+        m_trace.headersMs = m_requestTimer.elapsed();
+    }
+    if(m_reply->isFinished())
+    {
+        if(m_reply->error() != QNetworkReply::NoError)
+        {
+            downloadError(m_reply->error());
+        }
+        downloadFinished();
+    }
+    else if(m_reply->bytesAvailable())
+    {
+        downloadReadyRead();
+    }
+}
+
+bool Download::failOver()
+{
+    if(m_health)
+    {
+        m_health->recordFailure(m_url.host());
+    }
+    if(m_status == Job_Aborted || m_candidateIndex + 1 >= m_candidates.size())
+    {
+        return false;
+    }
+    qWarning() << "Download from" << m_url.host() << "failed, trying" << m_candidates[m_candidateIndex + 1].url.host();
+    m_sink->abort();
+    m_reply.reset();
+    m_candidateIndex++;
+    m_failingOver = true;
+    start(m_network);
+    return true;
 }
 
 void Download::downloadProgress(qint64 bytesReceived, qint64 bytesTotal)
 {
+    if(m_segmentEnd)
+    {
+        reportSegmentProgress();
+        return;
+    }
+    // a resumed transfer only reports the remaining part
+    bytesReceived += m_resumeOffset;
+    if(bytesTotal > 0)
+    {
+        bytesTotal += m_resumeOffset;
+    }
     m_total_progress = bytesTotal;
     m_progress = bytesReceived;
+    // replies report progress for every chunk, nobody needs to see all of that
+    if(m_progressTimer.isValid() && m_progressTimer.elapsed() < 100 && bytesReceived != bytesTotal)
+    {
+        return;
+    }
+    m_progressTimer.start();
     emit netActionProgress(m_index_within_job, bytesReceived, bytesTotal);
 }
 
@@ -272,13 +500,342 @@ bool Download::handleRedirect()
 
     m_url = QUrl(redirect.toString());
     qDebug() << "Following redirect to " << m_url.toString();
+    m_redirecting = true;
     start(m_network);
     return true;
 }
 
+bool Download::isRedirect()
+{
+    int statusCode = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    return statusCode >= 300 && statusCode < 400 && m_reply->hasRawHeader("Location");
+}
+
+void Download::finishTrace(bool success)
+{
+    m_trace.finishedMs = m_requestTimer.elapsed();
+    m_trace.statusCode = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if(m_trace.statusCode == 304)
+    {
+        m_trace.cacheResult = RequestTrace::CacheResult::NotModified;
+    }
+    else if(m_trace.bytes > 0 || m_trace.statusCode == 200 || m_trace.statusCode == 206)
+    {
+        m_trace.cacheResult = RequestTrace::CacheResult::Fetched;
+    }
+    m_trace.success = success;
+    m_trace.http2 = ConnectionWarmer::usedHttp2(*m_reply);
+    if(m_scheduler && m_trace.statusCode > 0 && m_url.scheme() == "https")
+    {
+        // encrypted is only signalled for new connections
+        auto &warmer = m_scheduler->warmer();
+        if(m_trace.encryptedMs >= 0)
+        {
+            warmer.recordHandshake(m_url.host(), m_trace.encryptedMs);
+        }
+        else
+        {
+            m_trace.prewarmed = warmer.takeWarm(m_url.host(), m_trace.savedHandshakeMs);
+        }
+    }
+    if(success && m_health && m_trace.headersMs >= 0 && m_trace.statusCode > 0 && m_trace.statusCode < 400)
+    {
+        m_health->recordSuccess(m_url.host(), m_trace.headersMs);
+    }
+}
+
+bool Download::handleHeaders()
+{
+    if(m_headersHandled)
+    {
+        return true;
+    }
+    m_headersHandled = true;
+    m_status = m_sink->headersReceived(*m_reply.get());
+    // no writes are queued before this, so the sink is not busy on another thread
+    m_resumeOffset = m_sink->resumeOffset();
+    if(m_status == Job_Failed)
+    {
+        qCritical() << "Failed to process response headers for " << m_url.toString();
+        return false;
+    }
+    trySplit();
+    return true;
+}
+
+bool Download::trySplit()
+{
+    if(!m_scheduler || m_reply->isFinished() || isRedirect())
+    {
+        return false;
+    }
+    int statusCode = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    qint64 length = m_reply->header(QNetworkRequest::ContentLengthHeader).toLongLong();
+    if(statusCode != 200 || length < SegmentThreshold)
+    {
+        return false;
+    }
+    if(m_reply->rawHeader("Accept-Ranges") != "bytes" || m_reply->hasRawHeader("Content-Encoding"))
+    {
+        return false;
+    }
+    // the ranges have to come from the same version of the file
+    QByteArray ifRange = m_reply->rawHeader("ETag");
+    if(ifRange.isEmpty() || ifRange.startsWith("W/"))
+    {
+        ifRange = m_reply->rawHeader("Last-Modified");
+    }
+    auto target = m_sink->segmentTarget();
+    if(ifRange.isEmpty() || target.isEmpty())
+    {
+        return false;
+    }
+
+    // every segment needs a connection of its own, and those come out of the shared budget
+    auto host = m_reply->url().host();
+    int wanted = int(qMin<qint64>(MaxSegments, length / MinSegmentSize)) - 1;
+    int extra = m_scheduler->acquireSegments(host, m_priority, wanted);
+    if(extra <= 0)
+    {
+        return false;
+    }
+    if(!m_sink->preallocate(length))
+    {
+        qWarning() << "Could not make room for" << length << "bytes in" << target;
+        for(int i = 0; i < extra; i++)
+        {
+            m_scheduler->hosts().cancel(host);
+        }
+        m_scheduler->schedule();
+        return false;
+    }
+
+    int count = extra + 1;
+    qint64 segmentSize = length / count;
+    m_segmentHost = host;
+    m_segmentEnd = segmentSize;
+    m_segmentedSize = length;
+    m_firstSegmentReceived = 0;
+    m_firstSegmentDone = false;
+    m_trace.segments = count;
+    qDebug() << "Downloading" << m_url.toString() << "in" << count << "segments of" << segmentSize / 1024 << "KiB";
+
+    QNetworkRequest request = m_request;
+    request.setUrl(m_reply->url());
+    for(int i = 1; i < count; i++)
+    {
+        qint64 end = i == count - 1 ? length : (i + 1) * segmentSize;
+        auto segment = new RangeSegment(request, ifRange, target, i * segmentSize, end);
+        m_segments.emplace_back(segment);
+        m_segmentsRunning++;
+        if(m_limiter)
+        {
+            segment->setRateLimiter(m_limiter, m_priority, m_jobBucket);
+        }
+        connect(segment, &RangeSegment::progress, this, &Download::reportSegmentProgress);
+        connect(segment, &RangeSegment::finished, this, [this, segment](bool success)
+        {
+            segmentFinished(segment, success);
+        });
+        segment->start(m_network);
+    }
+    return true;
+}
+
+void Download::firstSegmentDone()
+{
+    // the rest of the reply is what the segments bring
+    m_firstSegmentDone = true;
+    if(m_limiter)
+    {
+        disconnect(m_limiter, &RateLimiter::tokensAvailable, this, &Download::downloadReadyRead);
+    }
+    m_reply->disconnect(this);
+    m_reply->abort();
+    reportSegmentProgress();
+    checkSegments();
+}
+
+void Download::reportSegmentProgress()
+{
+    qint64 received = m_firstSegmentReceived;
+    for(auto & segment: m_segments)
+    {
+        received += segment->received();
+    }
+    m_progress = received;
+    m_total_progress = m_segmentedSize;
+    if(m_progressTimer.isValid() && m_progressTimer.elapsed() < 100 && received != m_segmentedSize)
+    {
+        return;
+    }
+    m_progressTimer.start();
+    emit netActionProgress(m_index_within_job, received, m_segmentedSize);
+}
+
+void Download::segmentFinished(RangeSegment *segment, bool success)
+{
+    m_segmentsRunning--;
+    m_trace.bytes += segment->received();
+    m_scheduler->releaseSegment(m_segmentHost, success, segment->received(), segment->elapsedMs());
+    if(!success && m_status == Job_InProgress)
+    {
+        qCritical() << "A segment of" << m_url.toString() << "failed";
+        m_status = Job_Failed;
+        stopSegments();
+    }
+    checkSegments();
+}
+
+void Download::stopSegments()
+{
+    if(m_segmentEnd && !m_firstSegmentDone && m_reply)
+    {
+        m_reply->disconnect(this);
+        m_reply->abort();
+    }
+    for(auto & segment: m_segments)
+    {
+        if(!segment->isFinished())
+        {
+            segment->abort();
+            m_segmentsRunning--;
+            if(m_scheduler)
+            {
+                m_scheduler->hosts().cancel(m_segmentHost);
+            }
+        }
+    }
+    if(m_scheduler && !m_segments.empty())
+    {
+        m_scheduler->schedule();
+    }
+}
+
+void Download::checkSegments()
+{
+    if(!m_segmentEnd || m_writeWatcher.isRunning() || m_segmentCheckWatcher.isRunning())
+    {
+        // comes back here once those are done
+        return;
+    }
+    if(m_status == Job_InProgress)
+    {
+        if(!m_firstSegmentDone || m_segmentsRunning > 0)
+        {
+            return;
+        }
+        // everything is in, let the validators see the part that did not come through the sink
+        auto sink = m_sink.get();
+        qint64 from = m_segmentEnd;
+        qint64 to = m_segmentedSize;
+        m_segmentCheckWatcher.setFuture(QtConcurrent::run(QThreadPool::globalInstance(), [sink, from, to]()
+        {
+            return sink->segmentsWritten(from, to);
+        }));
+        return;
+    }
+
+    stopSegments();
+    auto status = m_status;
+    m_segments.clear();
+    m_segmentEnd = 0;
+    finishTrace(false);
+    if(status == Job_Aborted)
+    {
+        qDebug() << "Download aborted:" << m_url.toString();
+        m_sink->abort();
+        m_reply.reset();
+        emit aborted(m_index_within_job);
+        return;
+    }
+    qDebug() << "Segmented download failed:" << m_url.toString();
+    m_status = Job_Failed;
+    if(failOver())
+    {
+        return;
+    }
+    m_sink->abort();
+    m_reply.reset();
+    emit failed(m_index_within_job);
+}
+
+void Download::segmentsChecked()
+{
+    if(m_status == Job_InProgress && m_segmentCheckWatcher.result() == Job_Failed)
+    {
+        m_status = Job_Failed;
+    }
+    if(m_status != Job_InProgress)
+    {
+        checkSegments();
+        return;
+    }
+    m_segments.clear();
+    m_segmentEnd = 0;
+    m_status = m_sink->finalize(*m_reply.get());
+    if(m_status != Job_Finished)
+    {
+        qDebug() << "Segmented download failed to finalize:" << m_url.toString();
+        finishTrace(false);
+        if(failOver())
+        {
+            return;
+        }
+        m_sink->abort();
+        m_reply.reset();
+        emit failed(m_index_within_job);
+        return;
+    }
+    finishTrace(true);
+    m_reply.reset();
+    qDebug() << "Download succeeded:" << m_url.toString();
+    emit succeeded(m_index_within_job);
+}
+
 
 void Download::downloadFinished()
 {
+    if(m_limiter)
+    {
+        disconnect(m_limiter, &RateLimiter::tokensAvailable, this, &Download::downloadReadyRead);
+    }
+    // the sink can only be finalized, aborted or restarted once it has everything
+    if(m_writeWatcher.isRunning())
+    {
+        m_finishPending = true;
+        return;
+    }
+
+    if(m_segmentEnd)
+    {
+        // the reply ended before it brought all of the first segment
+        if(m_status != Job_Aborted)
+        {
+            qCritical() << "Download of the first segment of" << m_url.toString() << "ended early";
+            m_status = Job_Failed;
+        }
+        checkSegments();
+        return;
+    }
+
+    m_hedgeTimer.stop();
+    if(m_hedge)
+    {
+        if(m_reply->error() != QNetworkReply::NoError && m_status != Job_Aborted)
+        {
+            // the other mirror may still come through
+            if(m_health)
+            {
+                m_health->recordFailure(m_url.host());
+            }
+            m_status = Job_InProgress;
+            takeOverHedge();
+            return;
+        }
+        dropHedge();
+    }
+
     // handle HTTP redirection first
     if(handleRedirect())
     {
@@ -290,6 +847,7 @@ void Download::downloadFinished()
     if (m_status == Job_Failed_Proceed)
     {
         qDebug() << "Download failed but we are allowed to proceed:" << m_url.toString();
+        finishTrace(true);
         m_sink->abort();
         m_reply.reset();
         emit succeeded(m_index_within_job);
@@ -298,6 +856,11 @@ void Download::downloadFinished()
     else if (m_status == Job_Failed)
     {
         qDebug() << "Download failed in previous step:" << m_url.toString();
+        finishTrace(false);
+        if(failOver())
+        {
+            return;
+        }
         m_sink->abort();
         m_reply.reset();
         emit failed(m_index_within_job);
@@ -306,18 +869,38 @@ void Download::downloadFinished()
     else if(m_status == Job_Aborted)
     {
         qDebug() << "Download aborted in previous step:" << m_url.toString();
+        finishTrace(false);
         m_sink->abort();
         m_reply.reset();
         emit aborted(m_index_within_job);
         return;
     }
 
+    if(!handleHeaders())
+    {
+        finishTrace(false);
+        if(failOver())
+        {
+            return;
+        }
+        m_sink->abort();
+        m_reply.reset();
+        emit failed(m_index_within_job);
+        return;
+    }
+
     // make sure we got all the remaining data, if any
     auto data = m_reply->readAll();
     if(data.size())
     {
         qDebug() << "Writing extra" << data.size() << "bytes to" << m_target_path;
-        m_status = m_sink->write(data);
+        queueWrite(data);
+    }
+    if(m_writeWatcher.isRunning())
+    {
+        // come back once it is written
+        m_finishPending = true;
+        return;
     }
 
     // otherwise, finalize the whole graph
@@ -325,11 +908,17 @@ void Download::downloadFinished()
     if (m_status != Job_Finished)
     {
         qDebug() << "Download failed to finalize:" << m_url.toString();
+        finishTrace(false);
+        if(failOver())
+        {
+            return;
+        }
         m_sink->abort();
         m_reply.reset();
         emit failed(m_index_within_job);
         return;
     }
+    finishTrace(true);
     m_reply.reset();
     qDebug() << "Download succeeded:" << m_url.toString();
     emit succeeded(m_index_within_job);
@@ -337,28 +926,173 @@ void Download::downloadFinished()
 
 void Download::downloadReadyRead()
 {
+    if(!m_reply)
+    {
+        return;
+    }
     if(m_status == Job_InProgress)
     {
-        auto data = m_reply->readAll();
-        m_status = m_sink->write(data);
-        if(m_status == Job_Failed)
+        if(isRedirect())
+        {
+            // the body of a redirect is not what we are looking for
+            m_reply->readAll();
+            return;
+        }
+        if(!handleHeaders())
         {
-            qCritical() << "Failed to process response chunk for " << m_target_path;
+            m_reply->readAll();
+            return;
+        }
+        qint64 room = MaxPendingWrite - m_pendingData.size();
+        if(room <= 0)
+        {
+            // the disk is behind, the rest waits in the reply until writeFinished asks for it
+            return;
+        }
+        qint64 limit = m_segmentEnd ? qMin(room, m_segmentEnd - m_firstSegmentReceived) : room;
+        auto data = readAllowed(limit);
+        if(data.isEmpty())
+        {
+            return;
+        }
+        queueWrite(data);
+        if(m_segmentEnd)
+        {
+            m_firstSegmentReceived += data.size();
+            if(m_firstSegmentReceived >= m_segmentEnd)
+            {
+                firstSegmentDone();
+            }
         }
         // qDebug() << "Download" << m_url.toString() << "gained" << data.size() << "bytes";
     }
     else
     {
         qCritical() << "Cannot write to " << m_target_path << ", illegal status" << m_status;
+        if(m_limiter)
+        {
+            disconnect(m_limiter, &RateLimiter::tokensAvailable, this, &Download::downloadReadyRead);
+        }
     }
 }
 
+QByteArray Download::readAllowed(qint64 limit)
+{
+    qint64 available = m_reply->bytesAvailable();
+    if(limit >= 0)
+    {
+        available = qMin(available, limit);
+    }
+    if(!m_limiter)
+    {
+        return m_reply->read(available);
+    }
+    qint64 allowed = m_limiter->acquire(m_priority, m_jobBucket.get(), available);
+    if(allowed < available)
+    {
+        // the rest stays in the reply, which stops reading from the network once its buffer is full
+        connect(m_limiter, &RateLimiter::tokensAvailable, this, &Download::downloadReadyRead, Qt::UniqueConnection);
+    }
+    else
+    {
+        disconnect(m_limiter, &RateLimiter::tokensAvailable, this, &Download::downloadReadyRead);
+    }
+    if(allowed <= 0)
+    {
+        return QByteArray();
+    }
+    return m_reply->read(allowed);
+}
+
+void Download::queueWrite(const QByteArray &data)
+{
+    m_trace.bytes += data.size();
+    m_pendingData.append(data);
+    if(!m_writeWatcher.isRunning())
+    {
+        startWrite();
+    }
+}
+
+bool Download::readBuffered()
+{
+    if(m_status != Job_InProgress || !m_reply || m_reply->isFinished() || !m_reply->bytesAvailable())
+    {
+        return false;
+    }
+    downloadReadyRead();
+    return m_writeWatcher.isRunning();
+}
+
+void Download::startWrite()
+{
+    // everything that arrived while the last write was running goes in one go
+    QByteArray data;
+    data.swap(m_pendingData);
+    auto sink = m_sink.get();
+    m_writeWatcher.setFuture(QtConcurrent::run(QThreadPool::globalInstance(), [sink, data]() mutable
+    {
+        return sink->write(data);
+    }));
+}
+
+void Download::writeFinished()
+{
+    auto result = m_writeWatcher.result();
+    if(result == Job_Failed && m_status == Job_InProgress)
+    {
+        qCritical() << "Failed to process response chunk for " << m_target_path;
+        m_status = Job_Failed;
+    }
+    if(m_status == Job_InProgress && m_pendingData.size())
+    {
+        startWrite();
+        // there is room for more now
+        readBuffered();
+        return;
+    }
+    m_pendingData.clear();
+    if(!m_finishPending && readBuffered())
+    {
+        return;
+    }
+    if(m_finishPending)
+    {
+        m_finishPending = false;
+        downloadFinished();
+    }
+    else if(m_segmentEnd)
+    {
+        checkSegments();
+    }
+}
+
+}
+
+bool Net::Download::adoptResult()
+{
+    return m_sink->adopt() == Job_Finished;
 }
 
 bool Net::Download::abort()
 {
-    if(m_reply)
+    if(m_leader)
+    {
+        // we were only waiting for someone else
+        stopFollowing();
+        m_status = Job_Aborted;
+        emit aborted(m_index_within_job);
+    }
+    else if(m_segmentEnd)
+    {
+        m_status = Job_Aborted;
+        stopSegments();
+        checkSegments();
+    }
+    else if(m_reply)
     {
+        m_hedgeTimer.stop();
+        dropHedge();
         m_reply->abort();
     }
     else
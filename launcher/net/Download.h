@@ -19,8 +19,13 @@
 #include "HttpMetaCache.h"
 #include "Validator.h"
 #include "Sink.h"
+#include "RangeSegment.h"
 
 #include <QMap>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <vector>
 
 #include "QObjectPtr.h"
 
@@ -41,7 +46,7 @@ public: /* types */
 protected: /* con/des */
     explicit Download();
 public:
-    virtual ~Download(){};
+    virtual ~Download();
     static Download::Ptr makeCached(QUrl url, MetaEntryPtr entry, Options options = Option::NoOptions);
     static Download::Ptr makeByteArray(QUrl url, QByteArray *output, Options options = Option::NoOptions);
     static Download::Ptr makeFile(QUrl url, QString path, Options options = Option::NoOptions);
@@ -54,9 +59,42 @@ public: /* methods */
     void addValidator(Validator * v);
     bool abort() override;
     bool canAbort() override;
+    QString targetKey() override
+    {
+        return m_target_key;
+    }
+
+protected: /* methods */
+    bool adoptResult() override;
 
 private: /* methods */
     bool handleRedirect();
+    bool isRedirect();
+    bool handleHeaders();
+    void finishTrace(bool success);
+    // where the URL can be fetched from, demoted mirrors last
+    QList<UrlRouter::Route> candidatesFor(const QUrl &url);
+    void useCandidate(int index);
+    void connectReply(QNetworkReply *reply);
+    // start over with the next candidate, if there is one
+    bool failOver();
+    void dropHedge();
+    void takeOverHedge();
+    // hand body data to the sink on the thread pool, in order
+    void queueWrite(const QByteArray &data);
+    void startWrite();
+    // read what the reply held back while the writes were behind. True if that started a write
+    bool readBuffered();
+    // as much of the available body data as the rate limits allow, and no more than limit if it is set
+    QByteArray readAllowed(qint64 limit = -1);
+    // fetch the rest of a large body in ranges over more connections, if the server and the budget allow
+    bool trySplit();
+    void firstSegmentDone();
+    void reportSegmentProgress();
+    // stop the reply and all segments
+    void stopSegments();
+    // wrap up a split download once everything settled, successfully or not
+    void checkSegments();
 
 protected slots:
     void downloadProgress(qint64 bytesReceived, qint64 bytesTotal) override;
@@ -64,6 +102,11 @@ protected slots:
     void sslErrors(const QList<QSslError> & errors);
     void downloadFinished() override;
     void downloadReadyRead() override;
+    void writeFinished();
+    void startHedge();
+    void hedgeResponded();
+    void segmentFinished(RangeSegment *segment, bool success);
+    void segmentsChecked();
 
 public slots:
     void startImpl() override;
@@ -71,8 +114,47 @@ public slots:
 private: /* data */
     // FIXME: remove this, it has no business being here.
     QString m_target_path;
+    // downloads with the same key write the same file from the same source
+    QString m_target_key;
     std::unique_ptr<Sink> m_sink;
     Options m_options;
+    bool m_headersHandled = false;
+
+    // body data not given to the sink yet, and the sink write in progress
+    QByteArray m_pendingData;
+    QFutureWatcher<JobStatus> m_writeWatcher;
+    // where the body of the current response starts in the file, read from the sink on our thread
+    qint64 m_resumeOffset = 0;
+    // the reply finished while data was still being written
+    bool m_finishPending = false;
+    QElapsedTimer m_progressTimer;
+    // time since the request was sent
+    QElapsedTimer m_requestTimer;
+    // the next start follows a redirect, not a new attempt
+    bool m_redirecting = false;
+
+    // the URLs of the current attempt, and which one is used
+    QList<UrlRouter::Route> m_candidates;
+    int m_candidateIndex = 0;
+    // the next start tries the next candidate, not a new attempt
+    bool m_failingOver = false;
+    // what was asked for, so it can be asked of another mirror
+    QNetworkRequest m_request;
+    // the same request to the next candidate, while the current one keeps us waiting
+    unique_qobject_ptr<QNetworkReply> m_hedge;
+    int m_hedgeIndex = -1;
+    QTimer m_hedgeTimer;
+
+    // a split download: the reply brings the body up to m_segmentEnd, the segments the rest
+    std::vector<unique_qobject_ptr<RangeSegment>> m_segments;
+    QString m_segmentHost;
+    qint64 m_segmentEnd = 0;
+    qint64 m_segmentedSize = 0;
+    qint64 m_firstSegmentReceived = 0;
+    bool m_firstSegmentDone = false;
+    int m_segmentsRunning = 0;
+    // the validators reading back what the segments wrote
+    QFutureWatcher<JobStatus> m_segmentCheckWatcher;
 };
 }
 
@@ -0,0 +1,254 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QEventLoop>
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QElapsedTimer>
+
+#include "net/NetJob.h"
+#include "net/Download.h"
+#include "net/ChecksumValidator.h"
+#include "net/FakeCdn.h"
+#include <FileSystem.h>
+
+class DownloadTest : public QObject
+{
+    Q_OBJECT
+
+    bool download(const QString &target, const QString &path, const QByteArray &sha1, Net::Download::Ptr *out = nullptr)
+    {
+        NetJob::Ptr job(new NetJob("Download test", m_network));
+        job->setScheduler(m_scheduler);
+        auto dl = Net::Download::makeFile(m_server->url(path), target);
+        if(out)
+        {
+            *out = dl;
+        }
+        dl->addValidator(new Net::ChecksumValidator(QCryptographicHash::Sha1, sha1));
+        dl->addValidator(new Net::ChecksumValidator(QCryptographicHash::Sha256));
+        job->addNetAction(dl);
+
+        QEventLoop loop;
+        connect(job.get(), &Task::finished, &loop, &QEventLoop::quit);
+        job->start();
+        loop.exec();
+        return job->wasSuccessful();
+    }
+
+    QByteArray fileSha1(const QString &path)
+    {
+        QFile file(path);
+        if(!file.open(QIODevice::ReadOnly))
+        {
+            return QByteArray();
+        }
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(&file);
+        return hash.result();
+    }
+
+    // downloads of "routed/" ask the mirror server first, the original server is the fallback
+    void routeToMirror()
+    {
+        Net::UrlRouter::Rule rule;
+        rule.match = m_server->url("routed").host() + "/routed";
+        rule.replacement = m_mirror->url("mirror").toString();
+        rule.name = "test";
+        m_scheduler->router().compile(QString(), false, {rule});
+    }
+
+    // the same, with the mirror as a download source and the rule rewriting for every source
+    void routeToSource()
+    {
+        Net::UrlRouter::Source source;
+        source.name = "mirror";
+        source.baseUrl = m_mirror->url(QString()).toString();
+        Net::UrlRouter::Rule rule;
+        rule.match = m_server->url("routed").host() + "/routed";
+        rule.replacement = "<j_url>/mirror";
+        rule.mode = Net::UrlRouter::Mode::Mirror;
+        rule.name = "test";
+        m_scheduler->router().compile({source}, {rule});
+    }
+
+private
+slots:
+    void initTestCase()
+    {
+        // not compressible, so nothing along the way can take shortcuts
+        m_body = FakeCdn::generate(0x12345678, 0, 256 * 1024);
+        m_sha1 = QCryptographicHash::hash(m_body, QCryptographicHash::Sha1);
+        m_server.reset(new FakeCdn());
+        // one stream, unless the test asks for ranges
+        m_server->addFile("body.bin", m_body, false);
+        m_server->addRedirect("moved/body.bin", "body.bin");
+        m_server->addFile("resumable/body.bin", m_body, true);
+        // just big enough to be split into segments, made up on the fly
+        QCryptographicHash ranged(QCryptographicHash::Sha1);
+        for(qint64 offset = 0; offset < RangedSize; offset += 1024 * 1024)
+        {
+            ranged.addData(FakeCdn::generate(0x9abcdef0, offset, 1024 * 1024));
+        }
+        m_rangedSha1 = ranged.result();
+        m_server->addGeneratedFile("ranged/body.bin", RangedSize, 0x9abcdef0, true);
+        m_server->addFile("routed/body.bin", m_body, false);
+        m_mirror.reset(new FakeCdn());
+        m_mirror->addFile("mirror/body.bin", m_body, false);
+        m_network.reset(new QNetworkAccessManager());
+    }
+
+    void init()
+    {
+        // mirror health and routing start from scratch in every test
+        m_scheduler.reset(new Net::Scheduler());
+        m_server->setOptions(FakeCdn::Options());
+        m_mirror->setOptions(FakeCdn::Options());
+        m_server->resetCounters();
+        m_mirror->resetCounters();
+    }
+
+    void test_download()
+    {
+        QTemporaryDir dir;
+        auto target = FS::PathCombine(dir.path(), "body.bin");
+        QVERIFY(download(target, "body.bin", m_sha1));
+        QVERIFY(!QFile::exists(target + ".part"));
+        QCOMPARE(QFileInfo(target).size(), qint64(m_body.size()));
+        QCOMPARE(fileSha1(target), m_sha1);
+    }
+
+    void test_checksumMismatch()
+    {
+        QTemporaryDir dir;
+        auto target = FS::PathCombine(dir.path(), "body.bin");
+        QVERIFY(!download(target, "body.bin", QByteArray(20, 'x')));
+        QVERIFY(!QFile::exists(target));
+    }
+
+    void test_redirect()
+    {
+        QTemporaryDir dir;
+        auto target = FS::PathCombine(dir.path(), "body.bin");
+        Net::Download::Ptr dl;
+        QVERIFY(download(target, "moved/body.bin", m_sha1, &dl));
+        QCOMPARE(dl->m_trace.redirects, 1);
+        QCOMPARE(fileSha1(target), m_sha1);
+    }
+
+    void test_segmented()
+    {
+        QTemporaryDir dir;
+        auto target = FS::PathCombine(dir.path(), "body.bin");
+        Net::Download::Ptr dl;
+        QVERIFY(download(target, "ranged/body.bin", m_rangedSha1, &dl));
+        QVERIFY(dl->m_trace.segments >= 2);
+        QVERIFY(!QFile::exists(target + ".part"));
+        QCOMPARE(QFileInfo(target).size(), RangedSize);
+        QCOMPARE(fileSha1(target), m_rangedSha1);
+    }
+
+    void test_resume()
+    {
+        QTemporaryDir dir;
+        auto target = FS::PathCombine(dir.path(), "body.bin");
+        auto options = m_server->options();
+        // every response is cut off halfway, so the job gives up with part of the file on disk
+        auto cut = options;
+        cut.resetPercent = 100;
+        m_server->setOptions(cut);
+        QVERIFY(!download(target, "resumable/body.bin", m_sha1));
+        m_server->setOptions(options);
+        auto kept = QFileInfo(target + ".part").size();
+        QVERIFY(kept > 0);
+        QVERIFY(QFile::exists(target + ".part.resume"));
+        QVERIFY(!QFile::exists(target));
+
+        // a new download of the same target continues where the last one stopped
+        m_server->resetCounters();
+        QVERIFY(download(target, "resumable/body.bin", m_sha1));
+        QVERIFY(m_server->bytesSent() < m_body.size() - kept + 4096);
+        QCOMPARE(fileSha1(target), m_sha1);
+        QVERIFY(!QFile::exists(target + ".part"));
+        QVERIFY(!QFile::exists(target + ".part.resume"));
+    }
+
+    void test_failover()
+    {
+        QTemporaryDir dir;
+        auto target = FS::PathCombine(dir.path(), "body.bin");
+        routeToMirror();
+        FakeCdn::Options broken;
+        broken.errorPercent = 100;
+        m_mirror->setOptions(broken);
+        Net::Download::Ptr dl;
+        QVERIFY(download(target, "routed/body.bin", m_sha1, &dl));
+        QCOMPARE(m_mirror->requests(), qint64(1));
+        QCOMPARE(dl->url().port(), m_server->url("routed").port());
+        // moving on to the next candidate is not a retry
+        QCOMPARE(dl->m_trace.attempts, 1);
+        QCOMPARE(dl->m_trace.failovers, 1);
+        QVERIFY(!dl->m_trace.hedged);
+        QCOMPARE(fileSha1(target), m_sha1);
+    }
+
+    void test_sourceFailover()
+    {
+        QTemporaryDir dir;
+        auto target = FS::PathCombine(dir.path(), "body.bin");
+        routeToSource();
+        Net::Download::Ptr dl;
+        // the source has the file where the rule says
+        QVERIFY(download(target, "routed/body.bin", m_sha1, &dl));
+        QCOMPARE(dl->url(), m_mirror->url("mirror/body.bin"));
+        QCOMPARE(m_server->requests(), qint64(0));
+        QCOMPARE(dl->m_trace.failovers, 0);
+
+        // and when it fails, the original server takes over
+        QFile::remove(target);
+        FakeCdn::Options broken;
+        broken.errorPercent = 100;
+        m_mirror->setOptions(broken);
+        QVERIFY(download(target, "routed/body.bin", m_sha1, &dl));
+        QCOMPARE(dl->url().port(), m_server->url("routed").port());
+        QCOMPARE(dl->m_trace.attempts, 1);
+        QCOMPARE(dl->m_trace.failovers, 1);
+        QCOMPARE(fileSha1(target), m_sha1);
+    }
+
+    void test_hedge()
+    {
+        QTemporaryDir dir;
+        auto target = FS::PathCombine(dir.path(), "body.bin");
+        routeToMirror();
+        // answers eventually, but later than the hedge delay of a host without history
+        FakeCdn::Options slow;
+        slow.latencyMs = 5000;
+        m_mirror->setOptions(slow);
+        Net::Download::Ptr dl;
+        QElapsedTimer timer;
+        timer.start();
+        QVERIFY(download(target, "routed/body.bin", m_sha1, &dl));
+        QVERIFY(timer.elapsed() < 5000);
+        QVERIFY(dl->m_trace.hedged);
+        QCOMPARE(dl->url().port(), m_server->url("routed").port());
+        QCOMPARE(dl->m_trace.attempts, 1);
+        QCOMPARE(dl->m_trace.failovers, 0);
+        QCOMPARE(fileSha1(target), m_sha1);
+    }
+
+private:
+    // the smallest download that is split into segments
+    static constexpr qint64 RangedSize = 32 * 1024 * 1024;
+
+    QByteArray m_body;
+    QByteArray m_sha1;
+    QByteArray m_rangedSha1;
+    std::unique_ptr<FakeCdn> m_server;
+    std::unique_ptr<FakeCdn> m_mirror;
+    shared_qobject_ptr<QNetworkAccessManager> m_network;
+    Net::Scheduler::Ptr m_scheduler;
+};
+
+QTEST_GUILESS_MAIN(DownloadTest)
+
+#include "Download_test.moc"
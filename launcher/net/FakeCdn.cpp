@@ -0,0 +1,430 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "FakeCdn.h"
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+#include <random>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+namespace {
+qint64 threadCpuTimeMs()
+{
+#if defined(Q_OS_WIN)
+    FILETIME creation, exit, kernel, user;
+    if(!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+    {
+        return -1;
+    }
+    auto toMs = [](const FILETIME &time)
+    {
+        return ((qint64(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 10000;
+    };
+    return toMs(kernel) + toMs(user);
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec time;
+    if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+    {
+        return -1;
+    }
+    return qint64(time.tv_sec) * 1000 + time.tv_nsec / 1000000;
+#else
+    return -1;
+#endif
+}
+
+const qint64 ChunkSize = 256 * 1024;
+const qint64 MaxQueued = 1024 * 1024;
+}
+
+/*
+ * One client connection, answering its requests one after the other.
+ */
+class FakeCdnConnection : public QObject
+{
+public:
+    FakeCdnConnection(FakeCdn *cdn, QTcpSocket *socket, std::minstd_rand *random)
+        : QObject(socket), m_cdn(cdn), m_socket(socket), m_random(random)
+    {
+        connect(socket, &QTcpSocket::readyRead, this, [this]()
+        {
+            m_buffer.append(m_socket->readAll());
+            readRequest();
+        });
+        connect(socket, &QTcpSocket::bytesWritten, this, [this]()
+        {
+            if(m_busy && m_pos < m_end && !m_pumpScheduled)
+            {
+                pump();
+            }
+        });
+    }
+
+private:
+    void readRequest()
+    {
+        if(m_busy)
+        {
+            return;
+        }
+        int end = m_buffer.indexOf("\r\n\r\n");
+        if(end == -1)
+        {
+            return;
+        }
+        auto head = m_buffer.left(end);
+        m_buffer.remove(0, end + 4);
+        m_busy = true;
+        int latency = m_cdn->options().latencyMs;
+        if(latency > 0)
+        {
+            QTimer::singleShot(latency, this, [this, head]()
+            {
+                respond(head);
+            });
+        }
+        else
+        {
+            respond(head);
+        }
+    }
+
+    void respond(const QByteArray &head)
+    {
+        m_cdn->m_requests.fetchAndAddRelaxed(1);
+        auto lines = head.split('\n');
+        auto requestLine = lines.value(0).trimmed().split(' ');
+        auto method = requestLine.value(0);
+        QUrl target(QString::fromLatin1(requestLine.value(1)));
+        auto path = target.path().mid(1);
+        QHash<QByteArray, QByteArray> headers;
+        for(int i = 1; i < lines.size(); i++)
+        {
+            auto separator = lines[i].indexOf(':');
+            if(separator > 0)
+            {
+                headers.insert(lines[i].left(separator).trimmed().toLower(), lines[i].mid(separator + 1).trimmed());
+            }
+        }
+        m_close = headers.value("connection").toLower() == "close";
+        m_head = method == "HEAD";
+        auto options = m_cdn->options();
+
+        auto redirect = m_cdn->redirect(path);
+        if(!redirect.isEmpty())
+        {
+            auto location = "http://127.0.0.1:" + QByteArray::number(m_cdn->m_port) + "/" + redirect.toUtf8();
+            sendEmpty("302 Found", "Location: " + location + "\r\n");
+            return;
+        }
+        FakeCdn::File file;
+        if(!m_cdn->findFile(path, file))
+        {
+            sendEmpty("404 Not Found");
+            return;
+        }
+        if(int((*m_random)() % 100) < options.errorPercent)
+        {
+            sendEmpty("503 Service Unavailable");
+            return;
+        }
+        if(headers.value("if-none-match") == file.etag)
+        {
+            sendEmpty("304 Not Modified", "ETag: " + file.etag + "\r\n");
+            return;
+        }
+
+        QByteArray status = "200 OK";
+        QByteArray extra;
+        qint64 first = 0;
+        qint64 last = file.size - 1;
+        auto ifRange = headers.value("if-range");
+        if(file.ranges && headers.contains("range") && (ifRange.isEmpty() || ifRange == file.etag))
+        {
+            // bytes=<first>-[<last>]
+            auto spec = headers.value("range").mid(6).split('-');
+            first = spec.value(0).toLongLong();
+            if(spec.value(1).size())
+            {
+                last = qMin(last, spec.value(1).toLongLong());
+            }
+            if(first >= file.size || first > last)
+            {
+                sendEmpty("416 Range Not Satisfiable", "Content-Range: bytes */" + QByteArray::number(file.size) + "\r\n");
+                return;
+            }
+            status = "206 Partial Content";
+            extra += "Content-Range: bytes " + QByteArray::number(first) + "-" + QByteArray::number(last) + "/" + QByteArray::number(file.size) + "\r\n";
+        }
+        if(file.ranges)
+        {
+            extra += "Accept-Ranges: bytes\r\n";
+        }
+        extra += "ETag: " + file.etag + "\r\nContent-Type: application/octet-stream\r\n";
+        writeHead(status, extra, last - first + 1);
+
+        m_file = file;
+        m_pos = first;
+        m_end = m_head ? first : last + 1;
+        m_cutAt = -1;
+        if(!m_head && int((*m_random)() % 100) < options.resetPercent)
+        {
+            m_cutAt = first + (m_end - first) / 2;
+        }
+        m_bytesPerSecond = options.bytesPerSecond;
+        m_paceTimer.start();
+        m_paceSent = 0;
+        pump();
+    }
+
+    void writeHead(const QByteArray &status, const QByteArray &extra, qint64 length)
+    {
+        QByteArray head = "HTTP/1.1 " + status + "\r\n" + extra;
+        head += "Content-Length: " + QByteArray::number(length) + "\r\n";
+        head += m_close ? "Connection: close\r\n\r\n" : "Connection: keep-alive\r\n\r\n";
+        m_socket->write(head);
+    }
+
+    void sendEmpty(const QByteArray &status, const QByteArray &extra = QByteArray())
+    {
+        writeHead(status, extra, 0);
+        finishResponse();
+    }
+
+    void pump()
+    {
+        m_pumpScheduled = false;
+        while(m_pos < m_end)
+        {
+            if(m_socket->bytesToWrite() > MaxQueued)
+            {
+                // bytesWritten brings us back
+                return;
+            }
+            qint64 chunk = qMin(m_end - m_pos, ChunkSize);
+            if(m_bytesPerSecond > 0)
+            {
+                qint64 allowed = m_paceTimer.elapsed() * m_bytesPerSecond / 1000 - m_paceSent;
+                if(allowed <= 0)
+                {
+                    m_pumpScheduled = true;
+                    QTimer::singleShot(10, this, [this]()
+                    {
+                        pump();
+                    });
+                    return;
+                }
+                chunk = qMin(chunk, allowed);
+            }
+            bool cut = m_cutAt >= 0 && m_pos + chunk >= m_cutAt;
+            if(cut)
+            {
+                chunk = m_cutAt - m_pos;
+            }
+            auto data = m_file.generated ? FakeCdn::generate(m_file.seed, m_pos, chunk) : m_file.data.mid(int(m_pos), int(chunk));
+            m_socket->write(data);
+            m_pos += chunk;
+            m_paceSent += chunk;
+            m_cdn->m_bytesSent.fetchAndAddRelaxed(chunk);
+            if(cut)
+            {
+                // the client gets less than Content-Length promised
+                m_busy = false;
+                m_socket->disconnectFromHost();
+                m_cdn->m_cpuTimeMs.store(threadCpuTimeMs());
+                return;
+            }
+        }
+        finishResponse();
+    }
+
+    void finishResponse()
+    {
+        m_busy = false;
+        m_cdn->m_cpuTimeMs.store(threadCpuTimeMs());
+        if(m_close)
+        {
+            m_socket->disconnectFromHost();
+            return;
+        }
+        readRequest();
+    }
+
+private:
+    FakeCdn *m_cdn;
+    QTcpSocket *m_socket;
+    std::minstd_rand *m_random;
+    QByteArray m_buffer;
+    bool m_busy = false;
+    bool m_close = false;
+    bool m_head = false;
+
+    // the body being sent
+    FakeCdn::File m_file;
+    qint64 m_pos = 0;
+    qint64 m_end = 0;
+    qint64 m_cutAt = -1;
+    qint64 m_bytesPerSecond = 0;
+    QElapsedTimer m_paceTimer;
+    qint64 m_paceSent = 0;
+    bool m_pumpScheduled = false;
+};
+
+FakeCdn::FakeCdn()
+{
+    m_requests.store(0);
+    m_bytesSent.store(0);
+    m_connections.store(0);
+    m_cpuTimeMs.store(-1);
+}
+
+FakeCdn::~FakeCdn()
+{
+    quit();
+    wait();
+}
+
+void FakeCdn::setOptions(const Options &options)
+{
+    QMutexLocker locker(&m_mutex);
+    m_options = options;
+}
+
+FakeCdn::Options FakeCdn::options() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_options;
+}
+
+void FakeCdn::addFile(const QString &path, const QByteArray &data, bool ranges)
+{
+    File file;
+    file.data = data;
+    file.size = data.size();
+    file.ranges = ranges;
+    file.etag = "\"" + QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex().left(16) + "\"";
+    QMutexLocker locker(&m_mutex);
+    m_files.insert(path, file);
+}
+
+void FakeCdn::addGeneratedFile(const QString &path, qint64 size, quint32 seed, bool ranges)
+{
+    File file;
+    file.size = size;
+    file.seed = seed;
+    file.generated = true;
+    file.ranges = ranges;
+    file.etag = "\"" + QByteArray::number(seed) + "-" + QByteArray::number(size) + "\"";
+    QMutexLocker locker(&m_mutex);
+    m_files.insert(path, file);
+}
+
+void FakeCdn::addRedirect(const QString &from, const QString &to)
+{
+    QMutexLocker locker(&m_mutex);
+    m_redirects.insert(from, to);
+}
+
+bool FakeCdn::findFile(const QString &path, File &out) const
+{
+    QMutexLocker locker(&m_mutex);
+    auto iter = m_files.find(path);
+    if(iter == m_files.end())
+    {
+        return false;
+    }
+    out = *iter;
+    return true;
+}
+
+QString FakeCdn::redirect(const QString &path) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_redirects.value(path);
+}
+
+QByteArray FakeCdn::generate(quint32 seed, qint64 offset, qint64 size)
+{
+    // splitmix64 over the index of every 8 bytes, so any range can be made without the ones before it
+    QByteArray out;
+    out.resize(int(size));
+    auto data = out.data();
+    qint64 word = offset / 8;
+    int skip = int(offset % 8);
+    qint64 written = 0;
+    while(written < size)
+    {
+        quint64 x = (quint64(seed) << 32) ^ quint64(word++);
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        x ^= x >> 31;
+        for(int byte = skip; byte < 8 && written < size; byte++)
+        {
+            data[written++] = char(x >> (byte * 8));
+        }
+        skip = 0;
+    }
+    return out;
+}
+
+QUrl FakeCdn::url(const QString &path)
+{
+    if(!m_started)
+    {
+        m_started = true;
+        start();
+    }
+    m_ready.acquire();
+    m_ready.release();
+    return QUrl(QString("http://127.0.0.1:%1/%2").arg(m_port).arg(path));
+}
+
+void FakeCdn::resetCounters()
+{
+    m_requests.store(0);
+    m_bytesSent.store(0);
+    m_connections.store(0);
+}
+
+void FakeCdn::run()
+{
+    QTcpServer server;
+    std::minstd_rand random(1);
+    connect(&server, &QTcpServer::newConnection, [&]()
+    {
+        while(auto socket = server.nextPendingConnection())
+        {
+            m_connections.fetchAndAddRelaxed(1);
+            new FakeCdnConnection(this, socket, &random);
+            connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        }
+    });
+    server.listen(QHostAddress::LocalHost);
+    m_port = server.serverPort();
+    m_ready.release();
+    exec();
+}
@@ -0,0 +1,122 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <QThread>
+#include <QMutex>
+#include <QSemaphore>
+#include <QHash>
+#include <QUrl>
+#include <QAtomicInteger>
+
+/*
+ * A stand-in for the download servers, for tests and benchmarks of the network code.
+ *
+ * It speaks just enough HTTP/1.1 for QNetworkAccessManager: keep-alive, ETag and If-None-Match,
+ * Range and If-Range, and redirects. Latency, bandwidth and failures can be dialed in. It runs
+ * on its own thread, so the code under test has the main thread to itself.
+ *
+ * Not part of the launcher, only built into the test executables.
+ */
+class FakeCdn : public QThread
+{
+    Q_OBJECT
+public: /* types */
+    struct Options
+    {
+        // delay before each response
+        int latencyMs = 0;
+        // per connection, 0 for as fast as possible
+        qint64 bytesPerSecond = 0;
+        // share of requests answered with 503
+        int errorPercent = 0;
+        // share of responses cut off halfway through the body
+        int resetPercent = 0;
+    };
+
+    struct File
+    {
+        QByteArray data;
+        // generated content: no data, the bytes come from the seed
+        qint64 size = 0;
+        quint32 seed = 0;
+        bool generated = false;
+        bool ranges = true;
+        QByteArray etag;
+    };
+
+public: /* con/des */
+    FakeCdn();
+    virtual ~FakeCdn();
+
+public: /* methods */
+    void setOptions(const Options &options);
+    Options options() const;
+
+    void addFile(const QString &path, const QByteArray &data, bool ranges = true);
+    // content made up on the fly, so large files don't need the memory
+    void addGeneratedFile(const QString &path, qint64 size, quint32 seed, bool ranges = true);
+    void addRedirect(const QString &from, const QString &to);
+    // the bytes of a generated file
+    static QByteArray generate(quint32 seed, qint64 offset, qint64 size);
+
+    // starts the server if it isn't running yet
+    QUrl url(const QString &path);
+
+    qint64 requests() const
+    {
+        return m_requests.load();
+    }
+    qint64 bytesSent() const
+    {
+        return m_bytesSent.load();
+    }
+    qint64 connections() const
+    {
+        return m_connections.load();
+    }
+    // CPU time the server thread used, -1 where it can't be measured
+    qint64 cpuTimeMs() const
+    {
+        return m_cpuTimeMs.load();
+    }
+    void resetCounters();
+
+    // what the server has at the path, false if it has nothing
+    bool findFile(const QString &path, File &out) const;
+    QString redirect(const QString &path) const;
+
+protected:
+    void run() override;
+
+private: /* data */
+    friend class FakeCdnConnection;
+
+    mutable QMutex m_mutex;
+    Options m_options;
+    QHash<QString, File> m_files;
+    QHash<QString, QString> m_redirects;
+
+    QSemaphore m_ready;
+    bool m_started = false;
+    quint16 m_port = 0;
+
+    QAtomicInteger<qint64> m_requests;
+    QAtomicInteger<qint64> m_bytesSent;
+    QAtomicInteger<qint64> m_connections;
+    QAtomicInteger<qint64> m_cpuTimeMs;
+};
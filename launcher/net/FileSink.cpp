@@ -5,8 +5,13 @@
 
 namespace Net {
 
+namespace {
+// below this, starting over costs less than writing down how to resume
+const qint64 ResumeValidatorsMinSize = 1024 * 1024;
+}
+
 FileSink::FileSink(QString filename)
-    :m_filename(filename)
+    :m_filename(filename), m_partial_filename(filename + ".part"), m_resume_filename(filename + ".part.resume")
 {
     // nil
 }
@@ -23,23 +28,52 @@ JobStatus FileSink::init(QNetworkRequest& request)
     {
         return result;
     }
-    // create a new save file and open it for writing
+    // create a new partial file (or continue an existing one) and open it for writing
     if (!FS::ensureFilePathExists(m_filename))
     {
         qCritical() << "Could not create folder for " + m_filename;
         return Job_Failed;
     }
-    wroteAnyData = false;
-    m_output_file.reset(new QSaveFile(m_filename));
-    if (!m_output_file->open(QIODevice::WriteOnly))
+    m_resume_offset = 0;
+    m_segmented = false;
+    m_output_file.reset(new QFile(m_partial_filename));
+    if(m_partial_etag.isEmpty() && m_partial_last_modified.isEmpty())
     {
-        qCritical() << "Could not open " + m_filename + " for writing";
-        return Job_Failed;
+        loadResumeValidators();
+    }
+    if(canResume())
+    {
+        if (!m_output_file->open(QIODevice::WriteOnly | QIODevice::Append))
+        {
+            qCritical() << "Could not open " + m_partial_filename + " for appending";
+            return Job_Failed;
+        }
+        m_resume_offset = m_output_file->size();
+        request.setRawHeader("Range", QString("bytes=%1-").arg(m_resume_offset).toLatin1());
+        // only continue if the remote file is still the one the partial data came from
+        request.setRawHeader("If-Range", m_partial_etag.size() ? m_partial_etag : m_partial_last_modified);
+        qDebug() << "Resuming" << m_filename << "from byte" << m_resume_offset;
     }
+    else
+    {
+        if (!m_output_file->open(QIODevice::WriteOnly | QIODevice::Truncate))
+        {
+            qCritical() << "Could not open " + m_partial_filename + " for writing";
+            return Job_Failed;
+        }
+    }
+    wroteAnyData = m_resume_offset > 0;
+    m_request = request;
 
-    if(initAllValidators(request))
-        return Job_InProgress;
-    return Job_Failed;
+    if(!initAllValidators(request))
+        return Job_Failed;
+    // the validators need to see the whole file, including what we already have
+    if(m_resume_offset > 0 && !feedValidatorsFromPartial())
+    {
+        qCritical() << "Could not read back partial data from " + m_partial_filename;
+        return Job_Failed;
+    }
+    return Job_InProgress;
 }
 
 JobStatus FileSink::initCache(QNetworkRequest &)
@@ -47,13 +81,70 @@ JobStatus FileSink::initCache(QNetworkRequest &)
     return Job_InProgress;
 }
 
+JobStatus FileSink::headersReceived(QNetworkReply& reply)
+{
+    int statusCode = reply.attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if(m_resume_offset > 0)
+    {
+        bool resumed = false;
+        if(statusCode == 206)
+        {
+            // Content-Range: bytes <first>-<last>/<total>
+            auto range = QString::fromLatin1(reply.rawHeader("Content-Range"));
+            auto first = range.section(' ', 1).section('-', 0, 0);
+            bool ok = false;
+            resumed = first.toLongLong(&ok) == m_resume_offset && ok;
+            if(!resumed)
+            {
+                qWarning() << "Unexpected Content-Range" << range << "while resuming" << m_filename;
+                discardPartial();
+                return Job_Failed;
+            }
+        }
+        if(!resumed)
+        {
+            // the remote file changed, the server can't do ranges or this is a cache hit. Start over.
+            qDebug() << "Not resuming" << m_filename << "- server responded with" << statusCode;
+            m_resume_offset = 0;
+            wroteAnyData = false;
+            if(statusCode == 416)
+            {
+                // whatever we have is useless for further requests
+                m_partial_etag.clear();
+                m_partial_last_modified.clear();
+            }
+            if(!m_output_file || !m_output_file->resize(0) || !initAllValidators(m_request))
+            {
+                qCritical() << "Could not restart writing into " + m_partial_filename;
+                return Job_Failed;
+            }
+        }
+    }
+    if(statusCode == 200 || statusCode == 206)
+    {
+        // remember what we are downloading, so an interrupted transfer can be resumed later
+        m_partial_etag = reply.rawHeader("ETag");
+        m_partial_last_modified = reply.rawHeader("Last-Modified");
+        if(reply.rawHeader("Accept-Ranges") == "none")
+        {
+            m_partial_etag.clear();
+            m_partial_last_modified.clear();
+        }
+        else if(statusCode == 200 && reply.header(QNetworkRequest::ContentLengthHeader).toLongLong() >= ResumeValidatorsMinSize)
+        {
+            // in case we don't get to abort() cleanly
+            saveResumeValidators();
+        }
+    }
+    return Job_InProgress;
+}
+
 JobStatus FileSink::write(QByteArray& data)
 {
-    if (!writeAllValidators(data) || m_output_file->write(data) != data.size())
+    if (!m_output_file || !writeAllValidators(data) || m_output_file->write(data) != data.size())
     {
         qCritical() << "Failed writing into " + m_filename;
-        m_output_file->cancelWriting();
-        m_output_file.reset();
+        discardPartial();
         wroteAnyData = false;
         return Job_Failed;
     }
@@ -63,7 +154,20 @@ JobStatus FileSink::write(QByteArray& data)
 
 JobStatus FileSink::abort()
 {
-    m_output_file->cancelWriting();
+    if(m_output_file)
+    {
+        m_output_file->close();
+        m_output_file.reset();
+        // keep what we got if it can be continued by the next attempt
+        if(!wroteAnyData || m_segmented || (m_partial_etag.isEmpty() && m_partial_last_modified.isEmpty()))
+        {
+            discardPartial();
+        }
+        else
+        {
+            saveResumeValidators();
+        }
+    }
     failAllValidators();
     return Job_Failed;
 }
@@ -77,26 +181,34 @@ JobStatus FileSink::finalize(QNetworkReply& reply)
     if(validStatus)
     {
         // this leaves out 304 Not Modified
-        gotFile = statusCode == 200 || statusCode == 203;
+        gotFile = statusCode == 200 || statusCode == 203 || statusCode == 206;
     }
-    // if we wrote any data to the save file, we try to commit the data to the real file.
+    // if we wrote any data to the partial file, we try to commit the data to the real file.
     // if it actually got a proper file, we write it even if it was empty
     if (gotFile || wroteAnyData)
     {
         // ask validators for data consistency
         // we only do this for actual downloads, not 'your data is still the same' cache hits
         if(!finalizeAllValidators(reply))
+        {
+            discardPartial();
             return Job_Failed;
+        }
         // nothing went wrong...
-        if (!m_output_file->commit())
+        if (!commitPartial())
         {
             qCritical() << "Failed to commit changes to " << m_filename;
-            m_output_file->cancelWriting();
+            discardPartial();
             return Job_Failed;
         }
     }
-    // then get rid of the save file
-    m_output_file.reset();
+    else
+    {
+        // then get rid of the partial file
+        discardPartial();
+    }
+    m_partial_etag.clear();
+    m_partial_last_modified.clear();
 
     return finalizeCache(reply);
 }
@@ -111,4 +223,145 @@ bool FileSink::hasLocalData()
     QFileInfo info(m_filename);
     return info.exists() && info.size() != 0;
 }
+
+JobStatus FileSink::adopt()
+{
+    return QFileInfo(m_filename).isFile() ? Job_Finished : Job_Failed;
+}
+
+qint64 FileSink::resumeOffset()
+{
+    return m_resume_offset;
+}
+
+QString FileSink::segmentTarget()
+{
+    return m_output_file && m_resume_offset == 0 ? m_partial_filename : QString();
+}
+
+bool FileSink::preallocate(qint64 size)
+{
+    if(!m_output_file || m_resume_offset != 0 || !m_output_file->resize(size))
+    {
+        return false;
+    }
+    m_segmented = true;
+    return true;
+}
+
+JobStatus FileSink::segmentsWritten(qint64 from, qint64 to)
+{
+    // the validators have seen what came through write(), give them the rest in order
+    QFile input(m_partial_filename);
+    if(!m_output_file || !m_output_file->flush() || !input.open(QIODevice::ReadOnly) || !input.seek(from))
+    {
+        qCritical() << "Could not read back the segments of" << m_partial_filename;
+        return Job_Failed;
+    }
+    qint64 remaining = to - from;
+    while(remaining > 0)
+    {
+        auto chunk = input.read(qMin<qint64>(remaining, 1024 * 1024));
+        if(chunk.isEmpty() || !writeAllValidators(chunk))
+        {
+            qCritical() << "Could not check the segments of" << m_partial_filename;
+            return Job_Failed;
+        }
+        remaining -= chunk.size();
+    }
+    wroteAnyData = true;
+    return Job_InProgress;
+}
+
+bool FileSink::canResume()
+{
+    // weak validators can't be used with If-Range
+    if(m_partial_etag.startsWith("W/"))
+    {
+        m_partial_etag.clear();
+    }
+    if(m_partial_etag.isEmpty() && m_partial_last_modified.isEmpty())
+    {
+        return false;
+    }
+    QFileInfo info(m_partial_filename);
+    return info.isFile() && info.size() > 0;
+}
+
+bool FileSink::feedValidatorsFromPartial()
+{
+    QFile input(m_partial_filename);
+    if(!input.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+    qint64 remaining = m_resume_offset;
+    while(remaining > 0)
+    {
+        auto chunk = input.read(qMin<qint64>(remaining, 64 * 1024));
+        if(chunk.isEmpty() || !writeAllValidators(chunk))
+        {
+            return false;
+        }
+        remaining -= chunk.size();
+    }
+    return true;
+}
+
+bool FileSink::commitPartial()
+{
+    if(!m_output_file)
+    {
+        return false;
+    }
+    m_output_file->close();
+    m_output_file.reset();
+    // the old file stays in place until the new one replaces it
+    if(!FS::renameOver(m_partial_filename, m_filename))
+    {
+        return false;
+    }
+    QFile::remove(m_resume_filename);
+    return true;
+}
+
+void FileSink::saveResumeValidators()
+{
+    if(m_partial_etag.isEmpty() && m_partial_last_modified.isEmpty())
+    {
+        return;
+    }
+    try
+    {
+        FS::write(m_resume_filename, m_partial_etag + '\n' + m_partial_last_modified + '\n');
+    }
+    catch (const FS::FileSystemException &e)
+    {
+        qWarning() << "Could not save how to resume" << m_filename << ":" << e.cause();
+    }
+}
+
+void FileSink::loadResumeValidators()
+{
+    QFile input(m_resume_filename);
+    if(!input.open(QIODevice::ReadOnly))
+    {
+        return;
+    }
+    auto lines = input.readAll().split('\n');
+    m_partial_etag = lines.value(0);
+    m_partial_last_modified = lines.value(1);
+}
+
+void FileSink::discardPartial()
+{
+    if(m_output_file)
+    {
+        m_output_file->close();
+        m_output_file.reset();
+    }
+    QFile::remove(m_partial_filename);
+    QFile::remove(m_resume_filename);
+    m_resume_offset = 0;
+}
 }
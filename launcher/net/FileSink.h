@@ -1,6 +1,6 @@
 #pragma once
 #include "Sink.h"
-#include <QSaveFile>
+#include <QFile>
 
 namespace Net {
 class FileSink : public Sink
@@ -11,18 +11,45 @@ public: /* con/des */
 
 public: /* methods */
     JobStatus init(QNetworkRequest & request) override;
+    JobStatus headersReceived(QNetworkReply & reply) override;
     JobStatus write(QByteArray & data) override;
     JobStatus abort() override;
     JobStatus finalize(QNetworkReply & reply) override;
     bool hasLocalData() override;
+    JobStatus adopt() override;
+    qint64 resumeOffset() override;
+    QString segmentTarget() override;
+    bool preallocate(qint64 size) override;
+    JobStatus segmentsWritten(qint64 from, qint64 to) override;
 
 protected: /* methods */
     virtual JobStatus initCache(QNetworkRequest &);
     virtual JobStatus finalizeCache(QNetworkReply &reply);
 
+private: /* methods */
+    bool canResume();
+    bool feedValidatorsFromPartial();
+    bool commitPartial();
+    void discardPartial();
+    // the validators are kept next to the partial file, so another download of the same target can resume it
+    void saveResumeValidators();
+    void loadResumeValidators();
+
 protected: /* data */
     QString m_filename;
     bool wroteAnyData = false;
-    std::unique_ptr<QSaveFile> m_output_file;
+    std::unique_ptr<QFile> m_output_file;
+
+private: /* data */
+    // partial data is kept next to the target and moved over it once complete
+    QString m_partial_filename;
+    QString m_resume_filename;
+    QNetworkRequest m_request;
+    qint64 m_resume_offset = 0;
+    // the partial file has holes until all ranges are in
+    bool m_segmented = false;
+    // validators of the response the partial data came from, used for If-Range
+    QByteArray m_partial_etag;
+    QByteArray m_partial_last_modified;
 };
 }
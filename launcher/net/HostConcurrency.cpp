@@ -0,0 +1,164 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "HostConcurrency.h"
+
+#include "ExponentialSeries.h"
+
+namespace Net {
+
+HostConcurrency::HostConcurrency(int initialWindow, int hardCap)
+    : m_initialWindow(initialWindow), m_hardCap(hardCap)
+{
+    clamp(m_hardCap, 1, 64);
+    clamp(m_initialWindow, 1, m_hardCap);
+}
+
+void HostConcurrency::setHardCap(int hardCap)
+{
+    clamp(hardCap, 1, 64);
+    m_hardCap = hardCap;
+    clamp(m_initialWindow, 1, m_hardCap);
+    for(auto & host: m_hosts)
+    {
+        clamp(host.window, 1, m_hardCap);
+    }
+}
+
+HostConcurrency::HostState &HostConcurrency::state(const QString &host)
+{
+    auto iter = m_hosts.find(host);
+    if(iter == m_hosts.end())
+    {
+        HostState fresh;
+        fresh.window = fresh.maxWindow = m_initialWindow;
+        iter = m_hosts.insert(host, fresh);
+    }
+    return *iter;
+}
+
+bool HostConcurrency::tryAcquire(const QString &host)
+{
+    auto &s = state(host);
+    if(s.inFlight >= s.window)
+    {
+        return false;
+    }
+    s.inFlight++;
+    m_inFlight++;
+    return true;
+}
+
+void HostConcurrency::acquire(const QString &host)
+{
+    state(host).inFlight++;
+    m_inFlight++;
+}
+
+void HostConcurrency::cancel(const QString &host)
+{
+    auto &s = state(host);
+    if(s.inFlight > 0)
+    {
+        s.inFlight--;
+        m_inFlight--;
+    }
+}
+
+void HostConcurrency::release(const QString &host, bool success, qint64 bytes, qint64 elapsedMs)
+{
+    cancel(host);
+    auto &s = state(host);
+    s.requests++;
+    if(!success)
+    {
+        // multiplicative decrease
+        s.failures++;
+        s.successesInWindow = 0;
+        s.window = qMax(1, s.window / 2);
+        return;
+    }
+    s.bytes += qMax<qint64>(bytes, 0);
+    s.busyMs += qMax<qint64>(elapsedMs, 0);
+
+    // requests answered without touching the network (cache hits) say nothing about the host
+    if(elapsedMs > 0)
+    {
+        double sample = elapsedMs;
+        if(s.latency == 0.0)
+        {
+            s.latency = s.minLatency = sample;
+        }
+        else
+        {
+            s.latency = s.latency * 0.8 + sample * 0.2;
+            s.minLatency = qMin(s.minLatency, sample);
+        }
+    }
+
+    // additive increase, once per full window of successes - but not while the host is getting slower
+    s.successesInWindow++;
+    if(s.successesInWindow >= s.window)
+    {
+        s.successesInWindow = 0;
+        bool congested = s.latency > s.minLatency * 4 && s.latency > 250.0;
+        if(congested)
+        {
+            s.window = qMax(1, s.window - 1);
+        }
+        else if(s.window < m_hardCap)
+        {
+            s.window++;
+            s.maxWindow = qMax(s.maxWindow, s.window);
+        }
+    }
+}
+
+int HostConcurrency::window(const QString &host) const
+{
+    auto iter = m_hosts.find(host);
+    if(iter == m_hosts.end())
+    {
+        return m_initialWindow;
+    }
+    return iter->window;
+}
+
+QStringList HostConcurrency::describe(const QSet<QString> &only) const
+{
+    QStringList out;
+    for(auto iter = m_hosts.begin(); iter != m_hosts.end(); iter++)
+    {
+        if(!only.isEmpty() && !only.contains(iter.key()))
+        {
+            continue;
+        }
+        auto &s = iter.value();
+        // throughput of one request slot, multiplied by the average number of slots used
+        double kibPerSec = s.busyMs ? (s.bytes / 1024.0) / (s.busyMs / 1000.0) : 0.0;
+        out.append(QString("%1: window %2 (max %3), %4 requests, %5 failed, %6 KiB, ~%7 KiB/s per connection, latency %8 ms")
+            .arg(iter.key().isEmpty() ? QString("<local>") : iter.key())
+            .arg(s.window)
+            .arg(s.maxWindow)
+            .arg(s.requests)
+            .arg(s.failures)
+            .arg(s.bytes / 1024)
+            .arg(kibPerSec, 0, 'f', 1)
+            .arg(s.latency, 0, 'f', 0));
+    }
+    out.sort();
+    return out;
+}
+}
@@ -0,0 +1,85 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+
+namespace Net {
+/*
+ * Per-host concurrency windows, adjusted AIMD-style.
+ *
+ * Every host starts with a small window of parallel requests. A full window of successful
+ * requests grows it by one, unless the latency of the host is climbing. A failure halves it.
+ * The window never exceeds the hard cap.
+ */
+class HostConcurrency
+{
+public: /* types */
+    struct HostState
+    {
+        int window = 0;
+        int maxWindow = 0;
+        int inFlight = 0;
+        int successesInWindow = 0;
+        int requests = 0;
+        int failures = 0;
+        qint64 bytes = 0;
+        qint64 busyMs = 0;
+        // exponentially weighted average and the best seen, in ms
+        double latency = 0.0;
+        double minLatency = 0.0;
+    };
+
+public: /* con/des */
+    HostConcurrency(int initialWindow = 2, int hardCap = 8);
+
+public: /* methods */
+    void setHardCap(int hardCap);
+    int hardCap() const
+    {
+        return m_hardCap;
+    }
+
+    // take a slot for a request to the host, if its window allows it
+    bool tryAcquire(const QString &host);
+    // take a slot for a request that is already on its way to the host, even past its window
+    void acquire(const QString &host);
+    // give the slot back and adjust the window by the outcome of the request
+    void release(const QString &host, bool success, qint64 bytes, qint64 elapsedMs);
+    // give the slot back without judging the host (aborted requests)
+    void cancel(const QString &host);
+
+    int window(const QString &host) const;
+    int inFlight() const
+    {
+        return m_inFlight;
+    }
+    // one line per host, optionally only for the given hosts
+    QStringList describe(const QSet<QString> &only = QSet<QString>()) const;
+
+private: /* methods */
+    HostState &state(const QString &host);
+
+private: /* data */
+    QHash<QString, HostState> m_hosts;
+    int m_initialWindow;
+    int m_hardCap;
+    int m_inFlight = 0;
+};
+}
@@ -15,11 +15,16 @@
 
 #include "HttpMetaCache.h"
 #include "FileSystem.h"
+#include "hashing/MultiHash.h"
 
 #include <QFileInfo>
 #include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
 #include <QDateTime>
 #include <QCryptographicHash>
+#include <QFutureWatcher>
+#include <QtConcurrentMap>
 
 #include <QDebug>
 
@@ -27,6 +32,23 @@
 #include <QJsonArray>
 #include <QJsonObject>
 
+namespace {
+const quint32 JOURNAL_MAGIC = 0x4D434A4C; // "MCJL"
+const quint32 JOURNAL_VERSION = 2;
+
+enum RecordType : quint8
+{
+    // quint32 base id, QString base name
+    Record_Base = 1,
+    // quint32 path id, quint32 base id, QString path
+    Record_Path = 2,
+    // quint32 path id, QString md5sum, QString etag, qint64 local timestamp, QString remote timestamp
+    Record_Put = 3,
+    // quint32 path id
+    Record_Remove = 4
+};
+}
+
 QString MetaEntry::getFullPath()
 {
     // FIXME: make local?
@@ -36,6 +58,10 @@ QString MetaEntry::getFullPath()
 HttpMetaCache::HttpMetaCache(QString path) : QObject()
 {
     m_index_file = path;
+    if(!path.isNull())
+    {
+        m_journal_file = path + ".journal";
+    }
     saveBatchingTimer.setSingleShot(true);
     saveBatchingTimer.setTimerType(Qt::VeryCoarseTimer);
     connect(&saveBatchingTimer, SIGNAL(timeout()), SLOT(SaveNow()));
@@ -56,11 +82,7 @@ MetaEntryPtr HttpMetaCache::getEntry(QString base, QString resource_path)
         return MetaEntryPtr();
     }
     EntryMap &map = m_entries[base];
-    if (map.entry_list.contains(resource_path))
-    {
-        return map.entry_list[resource_path];
-    }
-    return MetaEntryPtr();
+    return map.entry_list.value(resource_path);
 }
 
 MetaEntryPtr HttpMetaCache::resolveEntry(QString base, QString resource_path, QString expected_etag)
@@ -80,14 +102,14 @@ MetaEntryPtr HttpMetaCache::resolveEntry(QString base, QString resource_path, QS
     if (!finfo.isFile() || !finfo.isReadable())
     {
         // if the file doesn't exist, we disown the entry
-        selected_base.entry_list.remove(resource_path);
+        removeEntry(base, resource_path);
         return staleEntry(base, resource_path);
     }
 
     if (!expected_etag.isEmpty() && expected_etag != entry->etag)
     {
         // if the etag doesn't match expected, we disown the entry
-        selected_base.entry_list.remove(resource_path);
+        removeEntry(base, resource_path);
         return staleEntry(base, resource_path);
     }
 
@@ -95,18 +117,15 @@ MetaEntryPtr HttpMetaCache::resolveEntry(QString base, QString resource_path, QS
     qint64 file_last_changed = finfo.lastModified().toUTC().toMSecsSinceEpoch();
     if (file_last_changed != entry->local_changed_timestamp)
     {
-        QFile input(real_path);
-        input.open(QIODevice::ReadOnly);
-        QString md5sum = QCryptographicHash::hash(input.readAll(), QCryptographicHash::Md5)
-                             .toHex()
-                             .constData();
+        QString md5sum = Hashing::MultiHash::hashFile(Hashing::Algorithm::Md5, real_path).toHex().constData();
         if (entry->md5sum != md5sum)
         {
-            selected_base.entry_list.remove(resource_path);
+            removeEntry(base, resource_path);
             return staleEntry(base, resource_path);
         }
         // md5sums matched... keep entry and save the new state to file
         entry->local_changed_timestamp = file_last_changed;
+        journalPut(entry);
         SaveEventually();
     }
 
@@ -115,6 +134,120 @@ MetaEntryPtr HttpMetaCache::resolveEntry(QString base, QString resource_path, QS
     return entry;
 }
 
+QFuture<MetaEntryPtr> HttpMetaCache::resolveEntryAsync(QString base, QString resource_path, QString expected_etag)
+{
+    auto promise = std::make_shared<QFutureInterface<MetaEntryPtr>>();
+    promise->reportStarted();
+    QStringList paths;
+    auto entry = getEntry(base, resource_path);
+    // no point in hashing a file we will throw away anyway
+    if (entry && (expected_etag.isEmpty() || expected_etag == entry->etag))
+    {
+        paths.append(resource_path);
+    }
+    checkInBackground(base, paths, [this, promise, base, resource_path, expected_etag]()
+    {
+        promise->reportResult(resolveEntry(base, resource_path, expected_etag));
+        promise->reportFinished();
+    });
+    return promise->future();
+}
+
+QFuture<QList<MetaEntryPtr>> HttpMetaCache::resolveEntries(QString base, QStringList resource_paths)
+{
+    auto promise = std::make_shared<QFutureInterface<QList<MetaEntryPtr>>>();
+    promise->reportStarted();
+    checkInBackground(base, resource_paths, [this, promise, base, resource_paths]()
+    {
+        // changed files have been checked by now, this only looks at file metadata
+        QList<MetaEntryPtr> entries;
+        for (auto & path : resource_paths)
+        {
+            entries.append(resolveEntry(base, path));
+        }
+        promise->reportResult(entries);
+        promise->reportFinished();
+    });
+    return promise->future();
+}
+
+HttpMetaCache::FileCheck HttpMetaCache::checkFile(const FileCheck &check)
+{
+    FileCheck result = check;
+    QFileInfo finfo(check.fullPath);
+    if (!finfo.isFile() || !finfo.isReadable())
+    {
+        result.timestamp = -1;
+        return result;
+    }
+    result.timestamp = finfo.lastModified().toUTC().toMSecsSinceEpoch();
+    if (result.timestamp != check.knownTimestamp)
+    {
+        result.md5sum = Hashing::MultiHash::hashFile(Hashing::Algorithm::Md5, check.fullPath).toHex().constData();
+    }
+    return result;
+}
+
+void HttpMetaCache::checkInBackground(const QString &base, const QStringList &resource_paths, std::function<void()> done)
+{
+    QList<FileCheck> checks;
+    if (m_entries.contains(base))
+    {
+        auto &map = m_entries[base];
+        for (auto & path : resource_paths)
+        {
+            auto entry = map.entry_list.value(path);
+            if (!entry)
+            {
+                continue;
+            }
+            FileCheck check;
+            check.path = path;
+            check.fullPath = FS::PathCombine(map.base_path, path);
+            check.knownTimestamp = entry->local_changed_timestamp;
+            checks.append(check);
+        }
+    }
+    if (checks.isEmpty())
+    {
+        done();
+        return;
+    }
+    auto watcher = new QFutureWatcher<FileCheck>(this);
+    connect(watcher, &QFutureWatcher<FileCheck>::finished, this, [this, watcher, base, done]()
+    {
+        for (auto & check : watcher->future().results())
+        {
+            applyCheck(base, check);
+        }
+        watcher->deleteLater();
+        done();
+    });
+    watcher->setFuture(QtConcurrent::mapped(checks, &HttpMetaCache::checkFile));
+}
+
+void HttpMetaCache::applyCheck(const QString &base, const FileCheck &check)
+{
+    auto entry = getEntry(base, check.path);
+    // missing files and entries that changed in the meantime are left to resolveEntry
+    if (!entry || entry->local_changed_timestamp != check.knownTimestamp)
+    {
+        return;
+    }
+    if (check.timestamp < 0 || check.timestamp == check.knownTimestamp)
+    {
+        return;
+    }
+    if (entry->md5sum != check.md5sum)
+    {
+        removeEntry(base, check.path);
+        return;
+    }
+    entry->local_changed_timestamp = check.timestamp;
+    journalPut(entry);
+    SaveEventually();
+}
+
 bool HttpMetaCache::updateEntry(MetaEntryPtr stale_entry)
 {
     if (!m_entries.contains(stale_entry->baseId))
@@ -129,6 +262,7 @@ bool HttpMetaCache::updateEntry(MetaEntryPtr stale_entry)
         return false;
     }
     m_entries[stale_entry->baseId].entry_list[stale_entry->relativePath] = stale_entry;
+    journalPut(stale_entry);
     SaveEventually();
     return true;
 }
@@ -138,12 +272,24 @@ bool HttpMetaCache::evictEntry(MetaEntryPtr entry)
     if(entry)
     {
         entry->stale = true;
+        // only forget about it if it is the entry we know
+        if(getEntry(entry->baseId, entry->relativePath) == entry)
+        {
+            journalRemove(entry->baseId, entry->relativePath);
+        }
         SaveEventually();
         return true;
     }
     return false;
 }
 
+void HttpMetaCache::removeEntry(const QString &base, const QString &resource_path)
+{
+    m_entries[base].entry_list.remove(resource_path);
+    journalRemove(base, resource_path);
+    SaveEventually();
+}
+
 MetaEntryPtr HttpMetaCache::staleEntry(QString base, QString resource_path)
 {
     auto foo = new MetaEntry();
@@ -174,35 +320,235 @@ QString HttpMetaCache::getBasePath(QString base)
     return QString();
 }
 
+QStringList HttpMetaCache::getEntryPaths(QString base)
+{
+    QStringList paths;
+    if (!m_entries.contains(base))
+    {
+        return paths;
+    }
+    auto &map = m_entries[base];
+    for (auto iter = map.entry_list.begin(); iter != map.entry_list.end(); iter++)
+    {
+        paths.append(FS::PathCombine(map.base_path, iter.key()));
+    }
+    return paths;
+}
+
+quint32 HttpMetaCache::internBase(const QString &base)
+{
+    auto iter = m_base_ids.find(base);
+    if(iter != m_base_ids.end())
+    {
+        return *iter;
+    }
+    quint32 id = m_base_ids.size();
+    m_base_ids.insert(base, id);
+    QDataStream out(&m_pending, QIODevice::WriteOnly | QIODevice::Append);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << quint8(Record_Base) << id << base;
+    m_journal_records++;
+    return id;
+}
+
+quint32 HttpMetaCache::internPath(const QString &base, const QString &resource_path)
+{
+    auto &map = m_entries[base];
+    auto iter = map.path_ids.find(resource_path);
+    if(iter != map.path_ids.end())
+    {
+        return *iter;
+    }
+    quint32 baseId = internBase(base);
+    quint32 id = m_next_path_id++;
+    map.path_ids.insert(resource_path, id);
+    QDataStream out(&m_pending, QIODevice::WriteOnly | QIODevice::Append);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << quint8(Record_Path) << id << baseId << resource_path;
+    m_journal_records++;
+    return id;
+}
+
+void HttpMetaCache::journalPut(MetaEntryPtr entry)
+{
+    if(m_journal_file.isNull())
+        return;
+    quint32 id = internPath(entry->baseId, entry->relativePath);
+    QDataStream out(&m_pending, QIODevice::WriteOnly | QIODevice::Append);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << quint8(Record_Put) << id << entry->md5sum << entry->etag << entry->local_changed_timestamp
+        << entry->remote_changed_timestamp;
+    m_journal_records++;
+}
+
+void HttpMetaCache::journalRemove(const QString &base, const QString &resource_path)
+{
+    if(m_journal_file.isNull() || !m_entries.contains(base))
+        return;
+    auto &map = m_entries[base];
+    auto iter = map.path_ids.find(resource_path);
+    if(iter == map.path_ids.end())
+    {
+        // never written, nothing to remove
+        return;
+    }
+    QDataStream out(&m_pending, QIODevice::WriteOnly | QIODevice::Append);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << quint8(Record_Remove) << *iter;
+    m_journal_records++;
+}
+
 void HttpMetaCache::Load()
 {
     if(m_index_file.isNull())
         return;
 
+    if(replayJournal())
+        return;
+
+    // no usable journal. If there is an index in the old format, convert it.
+    if(loadLegacyIndex())
+    {
+        qDebug() << "Migrating" << m_index_file << "to" << m_journal_file;
+        if(compactJournal())
+        {
+            QFile::remove(m_index_file);
+        }
+    }
+}
+
+bool HttpMetaCache::replayJournal()
+{
+    QFile journal(m_journal_file);
+    if (!journal.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&journal);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != JOURNAL_MAGIC || version != JOURNAL_VERSION)
+    {
+        qWarning() << "Ignoring metacache journal" << m_journal_file << "with unknown format";
+        return false;
+    }
+
+    // journal ids to what they mean
+    QHash<quint32, QString> bases;
+    QHash<quint32, QPair<QString, QString>> paths;
+    qint64 goodOffset = journal.pos();
+    m_journal_records = 0;
+    while (!in.atEnd())
+    {
+        quint8 type = 0;
+        in >> type;
+        switch(type)
+        {
+            case Record_Base:
+            {
+                quint32 id;
+                QString name;
+                in >> id >> name;
+                bases[id] = name;
+                m_base_ids[name] = id;
+                break;
+            }
+            case Record_Path:
+            {
+                quint32 id, baseId;
+                QString path;
+                in >> id >> baseId >> path;
+                auto base = bases.value(baseId);
+                paths[id] = qMakePair(base, path);
+                m_next_path_id = qMax(m_next_path_id, id + 1);
+                if (m_entries.contains(base))
+                {
+                    m_entries[base].path_ids[path] = id;
+                }
+                break;
+            }
+            case Record_Put:
+            {
+                quint32 id;
+                auto foo = new MetaEntry();
+                in >> id >> foo->md5sum >> foo->etag >> foo->local_changed_timestamp >> foo->remote_changed_timestamp;
+                MetaEntryPtr entry(foo);
+                if (in.status() != QDataStream::Ok || !paths.contains(id))
+                    break;
+                auto location = paths[id];
+                if (!m_entries.contains(location.first))
+                    break;
+                auto &entrymap = m_entries[location.first];
+                foo->baseId = location.first;
+                foo->basePath = entrymap.base_path;
+                foo->relativePath = location.second;
+                // presumed innocent until closer examination
+                foo->stale = false;
+                entrymap.entry_list[location.second] = entry;
+                break;
+            }
+            case Record_Remove:
+            {
+                quint32 id;
+                in >> id;
+                if (in.status() != QDataStream::Ok || !paths.contains(id))
+                    break;
+                auto location = paths[id];
+                if (m_entries.contains(location.first))
+                {
+                    m_entries[location.first].entry_list.remove(location.second);
+                }
+                break;
+            }
+            default:
+                in.setStatus(QDataStream::ReadCorruptData);
+                break;
+        }
+        if (in.status() != QDataStream::Ok)
+            break;
+        goodOffset = journal.pos();
+        m_journal_records++;
+    }
+
+    // a record cut short by a crash - drop it, everything before it is fine
+    qint64 size = journal.size();
+    journal.close();
+    if (goodOffset < size)
+    {
+        qWarning() << "Dropping" << size - goodOffset << "damaged bytes at the end of" << m_journal_file;
+        QFile::resize(m_journal_file, goodOffset);
+    }
+    m_journal_valid = true;
+    return true;
+}
+
+bool HttpMetaCache::loadLegacyIndex()
+{
     QFile index(m_index_file);
     if (!index.open(QIODevice::ReadOnly))
-        return;
+        return false;
 
     QJsonDocument json = QJsonDocument::fromJson(index.readAll());
     if (!json.isObject())
-        return;
+        return false;
     auto root = json.object();
     // check file version first
     auto version_val = root.value("version");
     if (!version_val.isString())
-        return;
+        return false;
     if (version_val.toString() != "1")
-        return;
+        return false;
 
     // read the entry array
     auto entries_val = root.value("entries");
     if (!entries_val.isArray())
-        return;
+        return false;
     QJsonArray array = entries_val.toArray();
     for (auto element : array)
     {
         if (!element.isObject())
-            return;
+            return false;
         auto element_obj = element.toObject();
         QString base = element_obj.value("base").toString();
         if (!m_entries.contains(base))
@@ -210,6 +556,7 @@ void HttpMetaCache::Load()
         auto &entrymap = m_entries[base];
         auto foo = new MetaEntry();
         foo->baseId = base;
+        foo->basePath = entrymap.base_path;
         QString path = foo->relativePath = element_obj.value("path").toString();
         foo->md5sum = element_obj.value("md5sum").toString();
         foo->etag = element_obj.value("etag").toString();
@@ -220,6 +567,54 @@ void HttpMetaCache::Load()
         foo->stale = false;
         entrymap.entry_list[path] = MetaEntryPtr(foo);
     }
+    return true;
+}
+
+bool HttpMetaCache::compactJournal()
+{
+    // start from scratch, ids are handed out again
+    m_pending.clear();
+    m_base_ids.clear();
+    m_next_path_id = 0;
+    m_journal_records = 0;
+    for (auto & group : m_entries)
+    {
+        group.path_ids.clear();
+    }
+    for (auto & group : m_entries)
+    {
+        for (auto & entry : group.entry_list)
+        {
+            // do not save stale entries. they are dead.
+            if (entry->stale)
+            {
+                continue;
+            }
+            journalPut(entry);
+        }
+    }
+
+    QByteArray header;
+    {
+        QDataStream out(&header, QIODevice::WriteOnly);
+        out.setVersion(QDataStream::Qt_5_0);
+        out << JOURNAL_MAGIC << JOURNAL_VERSION;
+    }
+    if (!FS::ensureFilePathExists(m_journal_file))
+    {
+        qWarning() << "Could not create folder for" << m_journal_file;
+        return false;
+    }
+    QSaveFile out(m_journal_file);
+    if (!out.open(QIODevice::WriteOnly) || out.write(header) != header.size() || out.write(m_pending) != m_pending.size() || !out.commit())
+    {
+        qWarning() << "Could not write" << m_journal_file << ":" << out.errorString();
+        m_journal_valid = false;
+        return false;
+    }
+    m_pending.clear();
+    m_journal_valid = true;
+    return true;
 }
 
 void HttpMetaCache::SaveEventually()
@@ -233,40 +628,33 @@ void HttpMetaCache::SaveNow()
 {
     if(m_index_file.isNull())
         return;
-    QJsonObject toplevel;
-    toplevel.insert("version", QJsonValue(QString("1")));
-    QJsonArray entriesArr;
-    for (auto group : m_entries)
+
+    qint64 live = 0;
+    for (auto & group : m_entries)
     {
-        for (auto entry : group.entry_list)
-        {
-            // do not save stale entries. they are dead.
-            if(entry->stale)
-            {
-                continue;
-            }
-            QJsonObject entryObj;
-            entryObj.insert("base", QJsonValue(entry->baseId));
-            entryObj.insert("path", QJsonValue(entry->relativePath));
-            entryObj.insert("md5sum", QJsonValue(entry->md5sum));
-            entryObj.insert("etag", QJsonValue(entry->etag));
-            entryObj.insert("last_changed_timestamp",
-                            QJsonValue(double(entry->local_changed_timestamp)));
-            if (!entry->remote_changed_timestamp.isEmpty())
-                entryObj.insert("remote_changed_timestamp",
-                                QJsonValue(entry->remote_changed_timestamp));
-            entriesArr.append(entryObj);
-        }
+        live += group.entry_list.size();
+    }
+    // rewrite the journal when most of it is history
+    if (!m_journal_valid || m_journal_records > live * 2 + 1024)
+    {
+        compactJournal();
+        return;
     }
-    toplevel.insert("entries", entriesArr);
+    if (m_pending.isEmpty())
+        return;
 
-    QJsonDocument doc(toplevel);
-    try
+    QFile journal(m_journal_file);
+    if (!journal.open(QIODevice::WriteOnly | QIODevice::Append))
     {
-        FS::write(m_index_file, doc.toJson());
+        qWarning() << "Could not open" << m_journal_file << "for appending:" << journal.errorString();
+        return;
     }
-    catch (const Exception &e)
+    if (journal.write(m_pending) != m_pending.size())
     {
-        qWarning() << e.what();
+        // we don't know what made it to the disk, rewrite everything next time
+        qWarning() << "Could not append to" << m_journal_file << ":" << journal.errorString();
+        m_journal_valid = false;
+        return;
     }
+    m_pending.clear();
 }
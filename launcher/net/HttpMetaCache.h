@@ -16,8 +16,12 @@
 #pragma once
 #include <QString>
 #include <QMap>
+#include <QHash>
+#include <QStringList>
+#include <QFuture>
 #include <qtimer.h>
 #include <memory>
+#include <functional>
 
 class HttpMetaCache;
 
@@ -36,6 +40,14 @@ public:
         this->stale = stale;
     }
     QString getFullPath();
+    QString getBaseId()
+    {
+        return baseId;
+    }
+    QString getRelativePath()
+    {
+        return relativePath;
+    }
     QString getRemoteChangedTimestamp()
     {
         return remote_changed_timestamp;
@@ -44,6 +56,10 @@ public:
     {
         this->remote_changed_timestamp = remote_changed_timestamp;
     }
+    qint64 getLocalChangedTimestamp()
+    {
+        return local_changed_timestamp;
+    }
     void setLocalChangedTimestamp(qint64 timestamp)
     {
         local_changed_timestamp = timestamp;
@@ -77,6 +93,14 @@ protected:
 
 typedef std::shared_ptr<MetaEntry> MetaEntryPtr;
 
+/*
+ * Keeps track of downloaded files and the HTTP metadata needed to revalidate them.
+ *
+ * The index is stored as an append-only journal: every change appends a small record, and the
+ * journal is rewritten as a compact snapshot once it holds much more history than live entries.
+ * Base ids and paths are interned, so repeated updates of an entry only store numbers and the
+ * changed fields.
+ */
 class HttpMetaCache : public QObject
 {
     Q_OBJECT
@@ -93,6 +117,13 @@ public:
     MetaEntryPtr resolveEntry(QString base, QString resource_path,
                               QString expected_etag = QString());
 
+    // same as resolveEntry, but files that changed on disk are hashed on the thread pool
+    QFuture<MetaEntryPtr> resolveEntryAsync(QString base, QString resource_path,
+                                            QString expected_etag = QString());
+
+    // resolve many entries of one base at once, changed files are hashed in parallel
+    QFuture<QList<MetaEntryPtr>> resolveEntries(QString base, QStringList resource_paths);
+
     // add a previously resolved stale entry
     bool updateEntry(MetaEntryPtr stale_entry);
 
@@ -105,6 +136,8 @@ public:
     void SaveEventually();
     void Load();
     QString getBasePath(QString base);
+    // full paths of the files the cache has entries for in the base
+    QStringList getEntryPaths(QString base);
 public
 slots:
     void SaveNow();
@@ -112,12 +145,50 @@ slots:
 private:
     // create a new stale entry, given the parameters
     MetaEntryPtr staleEntry(QString base, QString resource_path);
+    // drop the entry from the index
+    void removeEntry(const QString &base, const QString &resource_path);
+
+    // result of looking at a file of an entry, off the main thread
+    struct FileCheck
+    {
+        QString path;
+        QString fullPath;
+        qint64 knownTimestamp = 0;
+        // -1 if the file is gone
+        qint64 timestamp = 0;
+        QString md5sum;
+    };
+    static FileCheck checkFile(const FileCheck &check);
+    // check the files of the entries in the background, then call done on our thread
+    void checkInBackground(const QString &base, const QStringList &resource_paths, std::function<void()> done);
+    void applyCheck(const QString &base, const FileCheck &check);
+
+    // journal handling
+    bool replayJournal();
+    bool loadLegacyIndex();
+    bool compactJournal();
+    quint32 internBase(const QString &base);
+    quint32 internPath(const QString &base, const QString &resource_path);
+    void journalPut(MetaEntryPtr entry);
+    void journalRemove(const QString &base, const QString &resource_path);
+
     struct EntryMap
     {
         QString base_path;
-        QMap<QString, MetaEntryPtr> entry_list;
+        QHash<QString, MetaEntryPtr> entry_list;
+        // journal ids of the paths already written for this base
+        QHash<QString, quint32> path_ids;
     };
     QMap<QString, EntryMap> m_entries;
     QString m_index_file;
+    QString m_journal_file;
     QTimer saveBatchingTimer;
+
+    // records not yet written out
+    QByteArray m_pending;
+    QHash<QString, quint32> m_base_ids;
+    quint32 m_next_path_id = 0;
+    // number of records in the journal file, to know when to compact it
+    qint64 m_journal_records = 0;
+    bool m_journal_valid = false;
 };
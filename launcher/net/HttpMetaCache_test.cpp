@@ -0,0 +1,172 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QFileInfo>
+
+#include "net/HttpMetaCache.h"
+#include "FileSystem.h"
+
+class HttpMetaCacheTest : public QObject
+{
+    Q_OBJECT
+
+    QTemporaryDir m_dir;
+
+    QString indexPath()
+    {
+        return FS::PathCombine(m_dir.path(), "metacache");
+    }
+
+    QString journalPath()
+    {
+        return indexPath() + ".journal";
+    }
+
+    std::unique_ptr<HttpMetaCache> open()
+    {
+        std::unique_ptr<HttpMetaCache> cache(new HttpMetaCache(indexPath()));
+        cache->addBase("libraries", FS::PathCombine(m_dir.path(), "libraries"));
+        cache->Load();
+        return cache;
+    }
+
+    // what a finished download stores
+    MetaEntryPtr put(HttpMetaCache &cache, const QString &path, const QString &etag)
+    {
+        auto entry = cache.resolveEntry("libraries", path);
+        entry->setETag(etag);
+        entry->setMD5Sum("d41d8cd98f00b204e9800998ecf8427e");
+        entry->setLocalChangedTimestamp(1000);
+        entry->setRemoteChangedTimestamp("Thu, 01 Jan 1970 00:00:01 GMT");
+        entry->setStale(false);
+        cache.updateEntry(entry);
+        return entry;
+    }
+
+private
+slots:
+    void init()
+    {
+        QFile::remove(indexPath());
+        QFile::remove(journalPath());
+    }
+
+    void test_replay()
+    {
+        {
+            auto cache = open();
+            put(*cache, "a/a.jar", "\"a\"");
+            // the first save writes a snapshot
+            cache->SaveNow();
+            put(*cache, "b/b.jar", "\"b\"");
+            put(*cache, "c/c.jar", "\"c\"");
+            // the following ones only append
+            cache->SaveNow();
+            put(*cache, "b/b.jar", "\"b2\"");
+            cache->evictEntry(cache->getEntry("libraries", "c/c.jar"));
+        }
+        auto cache = open();
+        auto a = cache->getEntry("libraries", "a/a.jar");
+        QVERIFY(a);
+        QCOMPARE(a->getETag(), QString("\"a\""));
+        QCOMPARE(a->getLocalChangedTimestamp(), qint64(1000));
+        QCOMPARE(a->getRemoteChangedTimestamp(), QString("Thu, 01 Jan 1970 00:00:01 GMT"));
+        QVERIFY(!a->isStale());
+        auto b = cache->getEntry("libraries", "b/b.jar");
+        QVERIFY(b);
+        QCOMPARE(b->getETag(), QString("\"b2\""));
+        QVERIFY(!cache->getEntry("libraries", "c/c.jar"));
+    }
+
+    void test_truncatedTail()
+    {
+        {
+            auto cache = open();
+            put(*cache, "a/a.jar", "\"a\"");
+        }
+        qint64 good = QFileInfo(journalPath()).size();
+        {
+            // a put record cut short by a crash
+            QFile journal(journalPath());
+            QVERIFY(journal.open(QIODevice::WriteOnly | QIODevice::Append));
+            journal.write(QByteArray("\x03\x00\x00", 3));
+        }
+        {
+            auto cache = open();
+            QVERIFY(cache->getEntry("libraries", "a/a.jar"));
+            QCOMPARE(QFileInfo(journalPath()).size(), good);
+            // records appended after the recovery are read back too
+            put(*cache, "b/b.jar", "\"b\"");
+        }
+        auto cache = open();
+        QVERIFY(cache->getEntry("libraries", "a/a.jar"));
+        QVERIFY(cache->getEntry("libraries", "b/b.jar"));
+    }
+
+    void test_compaction()
+    {
+        auto cache = open();
+        auto entry = put(*cache, "a/a.jar", "\"a\"");
+        cache->SaveNow();
+        qint64 snapshot = QFileInfo(journalPath()).size();
+        for (int i = 0; i < 500; i++)
+        {
+            cache->updateEntry(entry);
+        }
+        cache->SaveNow();
+        QVERIFY(QFileInfo(journalPath()).size() > snapshot);
+        // now most of the journal is history and it is rewritten
+        for (int i = 0; i < 600; i++)
+        {
+            cache->updateEntry(entry);
+        }
+        cache->SaveNow();
+        QCOMPARE(QFileInfo(journalPath()).size(), snapshot);
+        cache.reset();
+        cache = open();
+        QVERIFY(cache->getEntry("libraries", "a/a.jar"));
+    }
+
+    void test_legacyMigration()
+    {
+        FS::write(indexPath(), R"({
+            "version": "1",
+            "entries": [
+                {
+                    "base": "libraries",
+                    "path": "a/a.jar",
+                    "md5sum": "d41d8cd98f00b204e9800998ecf8427e",
+                    "etag": "\"a\"",
+                    "last_changed_timestamp": 1000,
+                    "remote_changed_timestamp": "Thu, 01 Jan 1970 00:00:01 GMT"
+                },
+                {
+                    "base": "unknown",
+                    "path": "b/b.jar",
+                    "md5sum": "d41d8cd98f00b204e9800998ecf8427e",
+                    "etag": "\"b\"",
+                    "last_changed_timestamp": 1000,
+                    "remote_changed_timestamp": ""
+                }
+            ]
+        })");
+        {
+            auto cache = open();
+            auto a = cache->getEntry("libraries", "a/a.jar");
+            QVERIFY(a);
+            QCOMPARE(a->getETag(), QString("\"a\""));
+            QCOMPARE(a->getLocalChangedTimestamp(), qint64(1000));
+            QVERIFY(!QFileInfo::exists(indexPath()));
+            QVERIFY(QFileInfo::exists(journalPath()));
+        }
+        // read back from the journal alone
+        auto cache = open();
+        auto a = cache->getEntry("libraries", "a/a.jar");
+        QVERIFY(a);
+        QCOMPARE(a->getMD5Sum(), QString("d41d8cd98f00b204e9800998ecf8427e"));
+        QCOMPARE(a->getRemoteChangedTimestamp(), QString("Thu, 01 Jan 1970 00:00:01 GMT"));
+    }
+};
+
+QTEST_GUILESS_MAIN(HttpMetaCacheTest)
+
+#include "HttpMetaCache_test.moc"
@@ -57,6 +57,30 @@ JobStatus MetaCacheSink::finalizeCache(QNetworkReply & reply)
     return Job_Finished;
 }
 
+JobStatus MetaCacheSink::adopt()
+{
+    auto result = FileSink::adopt();
+    if(result != Job_Finished)
+    {
+        return result;
+    }
+    // the other download registered its own entry for the same file, copy it
+    auto current = APPLICATION->metacache()->getEntry(m_entry->getBaseId(), m_entry->getRelativePath());
+    if(!current || current->isStale())
+    {
+        return Job_Failed;
+    }
+    if(current != m_entry)
+    {
+        m_entry->setMD5Sum(current->getMD5Sum());
+        m_entry->setETag(current->getETag());
+        m_entry->setRemoteChangedTimestamp(current->getRemoteChangedTimestamp());
+        m_entry->setLocalChangedTimestamp(current->getLocalChangedTimestamp());
+        m_entry->setStale(false);
+    }
+    return Job_Finished;
+}
+
 bool MetaCacheSink::hasLocalData()
 {
     QFileInfo info(m_filename);
@@ -10,6 +10,7 @@ public: /* con/des */
     MetaCacheSink(MetaEntryPtr entry, ChecksumValidator * md5sum);
     virtual ~MetaCacheSink();
     bool hasLocalData() override;
+    JobStatus adopt() override;
 
 protected: /* methods */
     JobStatus initCache(QNetworkRequest & request) override;
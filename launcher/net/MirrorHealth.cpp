@@ -0,0 +1,121 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "MirrorHealth.h"
+
+#include <QDebug>
+
+namespace Net {
+
+namespace {
+// before this many answers, the latency of a host is not known well enough to judge it
+const int MinSamples = 4;
+const qint64 DefaultHedgeDelayMs = 2000;
+const qint64 MinHedgeDelayMs = 500;
+const qint64 MaxHedgeDelayMs = 5000;
+}
+
+void MirrorHealth::recordSuccess(const QString &host, qint64 ttfbMs)
+{
+    auto &state = m_hosts[host];
+    state.successes++;
+    if(ttfbMs >= 0)
+    {
+        state.latencyMs = state.successes == 1 ? ttfbMs : state.latencyMs * 0.8 + ttfbMs * 0.2;
+    }
+    updateDemotion(host, state);
+}
+
+void MirrorHealth::recordFailure(const QString &host)
+{
+    auto &state = m_hosts[host];
+    state.failures++;
+    updateDemotion(host, state);
+}
+
+void MirrorHealth::recordSlow(const QString &host)
+{
+    auto &state = m_hosts[host];
+    state.slow++;
+    updateDemotion(host, state);
+}
+
+void MirrorHealth::updateDemotion(const QString &host, State &state)
+{
+    if(state.demoted)
+    {
+        return;
+    }
+    QString reason;
+    if(state.failures >= 3 && state.failures * 4 > state.successes)
+    {
+        reason = QString("%1 failed requests").arg(state.failures);
+    }
+    else if(state.slow >= 3 && state.slow * 2 > state.successes)
+    {
+        reason = QString("lost %1 requests to other mirrors").arg(state.slow);
+    }
+    else if(state.successes >= MinSamples && state.latencyMs > 1000)
+    {
+        // much slower than the best host we know of
+        double best = state.latencyMs;
+        for(auto iter = m_hosts.cbegin(); iter != m_hosts.cend(); iter++)
+        {
+            if(!iter->demoted && iter->successes >= MinSamples)
+            {
+                best = qMin(best, iter->latencyMs);
+            }
+        }
+        if(state.latencyMs > best * 4)
+        {
+            reason = QString("answers in %1 ms, the best mirror in %2 ms").arg(qRound(state.latencyMs)).arg(qRound(best));
+        }
+    }
+    if(!reason.isEmpty())
+    {
+        qWarning() << "Demoting download mirror" << host << "for this session:" << reason;
+        state.demoted = true;
+    }
+}
+
+bool MirrorHealth::isDemoted(const QString &host) const
+{
+    auto iter = m_hosts.find(host);
+    return iter != m_hosts.end() && iter->demoted;
+}
+
+qint64 MirrorHealth::hedgeDelay(const QString &host) const
+{
+    auto iter = m_hosts.find(host);
+    if(iter == m_hosts.end() || iter->successes < MinSamples)
+    {
+        return DefaultHedgeDelayMs;
+    }
+    return qBound(MinHedgeDelayMs, qint64(iter->latencyMs * 3), MaxHedgeDelayMs);
+}
+
+QStringList MirrorHealth::describe() const
+{
+    QStringList out;
+    for(auto iter = m_hosts.cbegin(); iter != m_hosts.cend(); iter++)
+    {
+        out.append(QString("%1: %2 ok, %3 failed, %4 slower than another mirror, %5 ms to first byte%6")
+            .arg(iter.key()).arg(iter->successes).arg(iter->failures).arg(iter->slow)
+            .arg(qRound(iter->latencyMs)).arg(iter->demoted ? ", demoted" : ""));
+    }
+    return out;
+}
+}
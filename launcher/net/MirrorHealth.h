@@ -0,0 +1,62 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+
+namespace Net {
+/*
+ * Keeps track of how well the hosts downloads are sent to are doing, for the rest of the session.
+ *
+ * Hosts that keep failing, or keep losing against other mirrors, are demoted and only used once
+ * everything else was tried.
+ */
+class MirrorHealth
+{
+public: /* methods */
+    // time to the first byte of a response from the host
+    void recordSuccess(const QString &host, qint64 ttfbMs);
+    void recordFailure(const QString &host);
+    // another host answered the same request first
+    void recordSlow(const QString &host);
+
+    bool isDemoted(const QString &host) const;
+    // how long to wait for the host to answer before also asking the next one
+    qint64 hedgeDelay(const QString &host) const;
+    // one line per host
+    QStringList describe() const;
+
+private: /* types */
+    struct State
+    {
+        // moving average of the time to the first byte
+        double latencyMs = 0;
+        int successes = 0;
+        int failures = 0;
+        int slow = 0;
+        bool demoted = false;
+    };
+
+private: /* methods */
+    void updateDemotion(const QString &host, State &state);
+
+private: /* data */
+    QHash<QString, State> m_hosts;
+};
+}
@@ -5,6 +5,8 @@ namespace Net
 enum class Mode
 {
     Offline,
-    Online
+    Online,
+    // like Online, but also hash everything that is already there and download the damaged files again
+    Verify
 };
 }
@@ -16,11 +16,21 @@
 #pragma once
 
 #include <QObject>
+#include <QPointer>
 #include <QUrl>
 #include <memory>
 #include <QNetworkReply>
 #include <QObjectPtr.h>
 
+#include "MirrorHealth.h"
+#include "RateLimiter.h"
+#include "RequestTrace.h"
+#include "UrlRouter.h"
+
+namespace Net {
+class Scheduler;
+}
+
 enum JobStatus
 {
     Job_NotStarted,
@@ -79,6 +89,38 @@ public:
     {
         return m_url;
     }
+    /// identifies what this action produces, actions with the same key produce the same result
+    virtual QString targetKey()
+    {
+        return QString();
+    }
+    /// pace reading of the reply through the limiter, with the limits of the given class and job
+    void setRateLimiter(Net::RateLimiter * limiter, Net::Priority priority, std::shared_ptr<Net::TokenBucket> jobBucket)
+    {
+        m_limiter = limiter;
+        m_priority = priority;
+        m_jobBucket = jobBucket;
+    }
+    /// rewrite the URL through the router before it is requested, and pick mirrors by their health
+    void setRouter(Net::UrlRouter * router, Net::MirrorHealth * health)
+    {
+        m_router = router;
+        m_health = health;
+    }
+    /// borrow connections from the scheduler to fetch parts of the target in parallel
+    void setScheduler(Net::Scheduler * scheduler)
+    {
+        m_scheduler = scheduler;
+    }
+    /// how many bytes the action is expected to transfer, -1 if that is not known up front
+    void setExpectedSize(qint64 size)
+    {
+        m_expected_size = size;
+    }
+    qint64 expectedSize() const
+    {
+        return m_expected_size;
+    }
     void setExtraHeader(const QString& key, const QString & value) {
         if(value.isNull()) {
             m_extra_headers.remove(key);
@@ -94,6 +136,8 @@ signals:
     void succeeded(int index);
     void failed(int index);
     void aborted(int index);
+    // the request now goes to another host, after a redirect, a failover or a hedge that answered first
+    void hostChanged(int index, QString host, bool previousFailed);
 
 protected slots:
     virtual void downloadProgress(qint64 bytesReceived, qint64 bytesTotal) = 0;
@@ -107,8 +151,68 @@ public slots:
         startImpl();
     }
 
+    /// let another action producing the same target do the work and take over its result
+    void follow(NetAction * leader)
+    {
+        m_leader = leader;
+        m_status = Job_InProgress;
+        connect(leader, &NetAction::succeeded, this, &NetAction::leaderSucceeded);
+        connect(leader, &NetAction::failed, this, &NetAction::leaderFailed);
+        connect(leader, &NetAction::aborted, this, &NetAction::leaderFailed);
+        connect(leader, &NetAction::netActionProgress, this, &NetAction::leaderProgress);
+        // gone without a word, when its job is torn down before it gets anywhere
+        connect(leader, &QObject::destroyed, this, [this]()
+        {
+            leaderFailed(m_index_within_job);
+        });
+    }
+
+protected slots:
+    void leaderSucceeded(int)
+    {
+        stopFollowing();
+        m_trace.cacheResult = Net::RequestTrace::CacheResult::Adopted;
+        if(adoptResult())
+        {
+            m_trace.success = true;
+            m_status = Job_Finished;
+            emit succeeded(m_index_within_job);
+        }
+        else
+        {
+            m_status = Job_Failed;
+            emit failed(m_index_within_job);
+        }
+    }
+    void leaderFailed(int)
+    {
+        // our own job will retry and do the work itself if needed
+        stopFollowing();
+        m_status = Job_Failed;
+        emit failed(m_index_within_job);
+    }
+    void leaderProgress(int, qint64 current, qint64 total)
+    {
+        m_progress = current;
+        m_total_progress = total;
+        emit netActionProgress(m_index_within_job, current, total);
+    }
+
 protected:
     virtual void startImpl() = 0;
+    /// the leader we followed produced the target, take it over
+    virtual bool adoptResult()
+    {
+        return false;
+    }
+    void stopFollowing()
+    {
+        if(m_leader)
+        {
+            m_leader->disconnect(this);
+        }
+        m_leader = nullptr;
+    }
 
 public:
     shared_qobject_ptr<QNetworkAccessManager> m_network;
@@ -124,9 +228,20 @@ public:
 
     qint64 m_progress = 0;
     qint64 m_total_progress = 1;
+    qint64 m_expected_size = -1;
 
     QMap<QString, QString> m_extra_headers;
 
+    /// what happened to the request, filled in as it goes
+    Net::RequestTrace m_trace;
+
 protected:
     JobStatus m_status = Job_NotStarted;
+    QPointer<NetAction> m_leader;
+    QPointer<Net::RateLimiter> m_limiter;
+    Net::Priority m_priority = Net::Priority::Background;
+    std::shared_ptr<Net::TokenBucket> m_jobBucket;
+    Net::UrlRouter * m_router = nullptr;
+    Net::MirrorHealth * m_health = nullptr;
+    Net::Scheduler * m_scheduler = nullptr;
 };
@@ -16,23 +16,396 @@
 #include "NetJob.h"
 #include "Download.h"
 #include "Application.h"
+#include "MMCTime.h"
 
 #include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDateTime>
+#include <algorithm>
+#include <limits>
+
+namespace {
+// what we assume a part weighs before we know anything about the job
+const qint64 defaultPartSize = 512 * 1024;
+
+// nearest-rank percentile of sorted values
+qint64 percentile(const QList<qint64> &sorted, int percent)
+{
+    if(sorted.isEmpty())
+    {
+        return -1;
+    }
+    int rank = (percent * sorted.size() + 99) / 100;
+    return sorted[qBound(0, rank - 1, sorted.size() - 1)];
+}
+}
+
+void NetJob::releasePart(int index, bool success)
+{
+    auto &slot = parts_progress[index];
+    if(m_scheduler)
+    {
+        m_scheduler->releaseTarget(downloads[index].get());
+    }
+    if(!slot.timer.isValid())
+    {
+        // this part was started outside of the job, it doesn't hold a host slot
+        return;
+    }
+    qint64 bytes = qMax<qint64>(slot.current_progress, 0);
+    m_scheduler->hosts().release(slot.host, success, bytes, slot.timer.elapsed());
+    slot.timer.invalidate();
+    if(success)
+    {
+        m_bytesDone += bytes;
+    }
+}
+
+void NetJob::trace_stats::add(const Net::RequestTrace &trace, bool keepRequest)
+{
+    cacheResults[Net::RequestTrace::cacheResultName(trace.cacheResult)]++;
+    retries += qMax(trace.attempts - 1, 0);
+    failovers += trace.failovers;
+    hedged += trace.hedged ? 1 : 0;
+    http2 += trace.http2 ? 1 : 0;
+    prewarmed += trace.prewarmed ? 1 : 0;
+    if(!trace.rule.isEmpty())
+    {
+        rewritten++;
+        rules[trace.rule]++;
+    }
+    savedHandshakeMs += trace.savedHandshakeMs;
+    if(trace.headersMs >= 0)
+    {
+        ttfb.append(trace.headersMs);
+    }
+    if(trace.finishedMs >= 0)
+    {
+        total.append(trace.finishedMs);
+        auto pos = std::find_if(slowest.begin(), slowest.end(), [&](const Net::RequestTrace &other)
+        {
+            return other.finishedMs < trace.finishedMs;
+        });
+        slowest.insert(pos, trace);
+        if(slowest.size() > 5)
+        {
+            slowest.removeLast();
+        }
+    }
+    if(keepRequest)
+    {
+        requests.append(trace);
+    }
+}
+
+QJsonObject NetJob::summary(bool withRequests) const
+{
+    auto stats = m_retired;
+    for(auto & part: downloads)
+    {
+        if(!part)
+        {
+            // let go of, already counted
+            continue;
+        }
+        auto &trace = part->m_trace;
+        if(trace.attempts == 0 && trace.cacheResult == Net::RequestTrace::CacheResult::None)
+        {
+            // never started
+            continue;
+        }
+        stats.add(trace, withRequests);
+    }
+    std::sort(stats.ttfb.begin(), stats.ttfb.end());
+    std::sort(stats.total.begin(), stats.total.end());
+
+    qint64 elapsed = m_timer.isValid() ? qMax<qint64>(m_timer.elapsed(), 1) : 0;
+    QJsonObject out;
+    out.insert("job", objectName());
+    out.insert("parts", downloads.size());
+    out.insert("failed", m_failed.size());
+    out.insert("retries", stats.retries);
+    out.insert("failovers", stats.failovers);
+    out.insert("hedged", stats.hedged);
+    out.insert("http2", stats.http2);
+    out.insert("prewarmed", stats.prewarmed);
+    out.insert("rewritten", stats.rewritten);
+    out.insert("savedHandshakeMs", stats.savedHandshakeMs);
+    out.insert("elapsedMs", elapsed);
+    out.insert("bytes", m_bytesDone);
+    out.insert("plannedBytes", plannedBytes());
+    out.insert("kibPerSecond", elapsed ? (m_bytesDone / 1024.0) / (elapsed / 1000.0) : 0.0);
+    QJsonObject cache;
+    for(auto iter = stats.cacheResults.begin(); iter != stats.cacheResults.end(); iter++)
+    {
+        cache.insert(iter.key(), iter.value());
+    }
+    out.insert("cache", cache);
+    QJsonObject rules;
+    for(auto iter = stats.rules.begin(); iter != stats.rules.end(); iter++)
+    {
+        rules.insert(iter.key(), iter.value());
+    }
+    out.insert("rules", rules);
+    QJsonObject latency;
+    latency.insert("ttfbP50", percentile(stats.ttfb, 50));
+    latency.insert("ttfbP95", percentile(stats.ttfb, 95));
+    latency.insert("totalP50", percentile(stats.total, 50));
+    latency.insert("totalP95", percentile(stats.total, 95));
+    out.insert("latencyMs", latency);
+    QJsonArray slowest;
+    for(auto & trace: stats.slowest)
+    {
+        slowest.append(trace.toJson());
+    }
+    out.insert("slowest", slowest);
+    if(withRequests)
+    {
+        QJsonArray requests;
+        for(auto & trace: stats.requests)
+        {
+            requests.append(trace.toJson());
+        }
+        out.insert("requests", requests);
+    }
+    return out;
+}
+
+void NetJob::logStatistics()
+{
+    if(!m_timer.isValid())
+    {
+        return;
+    }
+    auto stats = summary();
+    auto latency = stats.value("latencyMs").toObject();
+    qDebug() << "Job" << objectName() << "transferred" << m_bytesDone / 1024 << "KiB in" << stats.value("elapsedMs").toInt() << "ms,"
+             << stats.value("kibPerSecond").toDouble() << "KiB/s,"
+             << "retries:" << stats.value("retries").toInt() << "failovers:" << stats.value("failovers").toInt()
+             << "hedged:" << stats.value("hedged").toInt();
+    if(stats.value("prewarmed").toInt() || stats.value("http2").toInt())
+    {
+        qDebug() << "  connections: HTTP/2 requests:" << stats.value("http2").toInt() << "prewarmed:" << stats.value("prewarmed").toInt()
+                 << "saving about" << stats.value("savedHandshakeMs").toInt() << "ms of handshakes";
+    }
+    qDebug() << "  cache:" << QJsonDocument(stats.value("cache").toObject()).toJson(QJsonDocument::Compact).constData()
+             << "time to first byte p50/p95:" << latency.value("ttfbP50").toInt() << "/" << latency.value("ttfbP95").toInt() << "ms,"
+             << "total p50/p95:" << latency.value("totalP50").toInt() << "/" << latency.value("totalP95").toInt() << "ms";
+    for(auto slow: stats.value("slowest").toArray())
+    {
+        auto trace = slow.toObject();
+        qDebug() << "  slow:" << trace.value("url").toString() << trace.value("totalMs").toInt() << "ms," << qint64(trace.value("bytes").toDouble()) << "bytes";
+    }
+    for(auto & line: m_scheduler->hosts().describe(m_hostsUsed))
+    {
+        qDebug() << "  " << line;
+    }
+    // only the rules this job used, the router knows many more
+    auto rules = stats.value("rules").toObject();
+    for(auto iter = rules.begin(); iter != rules.end(); iter++)
+    {
+        qDebug() << "  rule" << iter.key() << ":" << iter.value().toInt() << "requests";
+    }
+    if(stats.value("failovers").toInt() || stats.value("hedged").toInt())
+    {
+        for(auto & line: m_scheduler->mirrorHealth().describe())
+        {
+            qDebug() << "  mirror" << line;
+        }
+    }
+    dumpTrace();
+}
+
+void NetJob::dumpTrace()
+{
+    auto path = m_scheduler->traceFile();
+    if(path.isEmpty())
+    {
+        return;
+    }
+    QFile out(path);
+    if(!out.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        qWarning() << "Could not write network trace to" << path << ":" << out.errorString();
+        return;
+    }
+    // one job per line
+    auto stats = summary(true);
+    stats.insert("finished", QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+    out.write(QJsonDocument(stats).toJson(QJsonDocument::Compact) + "\n");
+}
+
+void NetJob::updateRate(qint64 bytes)
+{
+    m_rateBytes += bytes;
+    if(!m_rateTimer.isValid())
+    {
+        m_rateTimer.start();
+        return;
+    }
+    auto elapsed = m_rateTimer.elapsed();
+    if(elapsed < 1000)
+    {
+        return;
+    }
+    qint64 rate = m_rateBytes * 1000 / elapsed;
+    // smooth it out a bit, so the number stays readable
+    m_rate = m_rate ? (m_rate + rate) / 2 : rate;
+    m_rateBytes = 0;
+    m_rateTimer.restart();
+    QString rateText;
+    if(m_rate >= 1024 * 1024)
+    {
+        rateText = tr("%1 MiB/s").arg(m_rate / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+    else
+    {
+        rateText = tr("%1 KiB/s").arg(m_rate / 1024);
+    }
+    auto left = eta();
+    if(left < 0)
+    {
+        setStatus(tr("Downloading %1 files at %2").arg(m_todo.size() + m_doing.size()).arg(rateText));
+        return;
+    }
+    setStatus(tr("Downloading %1 files at %2, about %3 left").arg(m_todo.size() + m_doing.size()).arg(rateText).arg(Time::prettifyDuration(left)));
+}
+
+qint64 NetJob::estimatedPartSize() const
+{
+    if(!m_knownParts)
+    {
+        return defaultPartSize;
+    }
+    return qMax<qint64>(m_knownBytes / m_knownParts, 1);
+}
+
+qint64 NetJob::plannedBytes() const
+{
+    return m_knownBytes + m_estimatedParts * estimatedPartSize() + pendingSourceBytes();
+}
+
+qint64 NetJob::pendingSourceBytes() const
+{
+    qint64 bytes = 0;
+    for(auto & source: m_sources)
+    {
+        auto remaining = source->remainingBytes();
+        if(remaining >= 0)
+        {
+            bytes += remaining;
+        }
+        else
+        {
+            bytes += qMax(source->remainingCount(), 0) * estimatedPartSize();
+        }
+    }
+    return bytes;
+}
+
+void NetJob::pullFromSources()
+{
+    // enough to fill every connection we could get, and then some, so the hosts can be mixed
+    int wanted = m_scheduler->connectionBudget() * 2;
+    while(!m_sources.isEmpty() && m_todo.size() < wanted)
+    {
+        auto action = m_sources.first()->next();
+        if(!action)
+        {
+            m_sources.removeFirst();
+            continue;
+        }
+        addNetAction(action);
+        parts_progress.last().fromSource = true;
+    }
+}
+
+void NetJob::retirePart(int index)
+{
+    auto &part = downloads[index];
+    m_retired.add(part->m_trace, !m_scheduler->traceFile().isEmpty());
+    part.reset();
+}
+
+qint64 NetJob::eta() const
+{
+    if(m_rate <= 0)
+    {
+        return -1;
+    }
+    return qMax<qint64>(plannedBytes() - m_reportedProgress, 0) / m_rate;
+}
+
+void NetJob::setPartSize(int index, qint64 size)
+{
+    auto &slot = parts_progress[index];
+    if(slot.estimated)
+    {
+        slot.estimated = false;
+        m_estimatedParts--;
+    }
+    else
+    {
+        m_knownBytes -= slot.size;
+        m_knownParts--;
+    }
+    slot.size = size;
+    m_knownBytes += size;
+    m_knownParts++;
+}
+
+void NetJob::reportProgress()
+{
+    qint64 estimate = estimatedPartSize();
+    qint64 current = m_finishedBytes;
+    for(auto index: m_doing)
+    {
+        auto &slot = parts_progress[index];
+        current += qBound<qint64>(0, slot.current_progress, slot.estimated ? estimate : slot.size);
+    }
+    qint64 total = qMax(plannedBytes(), current);
+    // retries start parts over, don't let the bar jump back for that
+    current = qMin(qMax(current, m_reportedProgress), total);
+    m_reportedProgress = current;
+    // progress bars only take ints
+    while(total > std::numeric_limits<int>::max())
+    {
+        current >>= 10;
+        total >>= 10;
+    }
+    setProgress(current, total);
+}
 
 void NetJob::partSucceeded(int index)
 {
-    // do progress. all slots are 1 in size at least
     auto &slot = parts_progress[index];
-    partProgress(index, slot.total_progress, slot.total_progress);
+    if(slot.total_progress > slot.current_progress)
+    {
+        slot.current_progress = slot.total_progress;
+    }
+    releasePart(index, true);
 
     m_doing.remove(index);
     m_done.insert(index);
+    // the part is done, whatever we still didn't know about its size stays as it is now
+    if(slot.estimated)
+    {
+        setPartSize(index, slot.current_progress > 1 ? slot.current_progress : estimatedPartSize());
+    }
+    m_finishedBytes += slot.size;
+    reportProgress();
     downloads[index].get()->disconnect(this);
+    if(slot.fromSource)
+    {
+        retirePart(index);
+    }
     startMoreParts();
 }
 
 void NetJob::partFailed(int index)
 {
+    releasePart(index, false);
     m_doing.remove(index);
     auto &slot = parts_progress[index];
     if (slot.failures == 3)
@@ -42,7 +415,7 @@ void NetJob::partFailed(int index)
     else
     {
         slot.failures++;
-        m_todo.enqueue(index);
+        queuePart(index);
     }
     downloads[index].get()->disconnect(this);
     startMoreParts();
@@ -50,6 +423,16 @@ void NetJob::partFailed(int index)
 
 void NetJob::partAborted(int index)
 {
+    auto &slot = parts_progress[index];
+    if(m_scheduler)
+    {
+        m_scheduler->releaseTarget(downloads[index].get());
+    }
+    if(slot.timer.isValid())
+    {
+        m_scheduler->hosts().cancel(slot.host);
+        slot.timer.invalidate();
+    }
     m_aborted = true;
     m_doing.remove(index);
     m_failed.insert(index);
@@ -57,48 +440,83 @@ void NetJob::partAborted(int index)
     startMoreParts();
 }
 
-void NetJob::partProgress(int index, qint64 bytesReceived, qint64 bytesTotal)
+void NetJob::partMoved(int index, QString host, bool previousFailed)
 {
     auto &slot = parts_progress[index];
-    slot.current_progress = bytesReceived;
-    slot.total_progress = bytesTotal;
-
-    int done = m_done.size();
-    int doing = m_doing.size();
-    int all = parts_progress.size();
-
-    qint64 bytesAll = 0;
-    qint64 bytesTotalAll = 0;
-    for(auto & partIdx: m_doing)
+    if(slot.host == host)
     {
-        auto part = parts_progress[partIdx];
-        // do not count parts with unknown/nonsensical total size
-        if(part.total_progress <= 0)
+        return;
+    }
+    if(slot.timer.isValid())
+    {
+        // the request is on its way already, so the new host gets a slot even if its window is full
+        auto &hosts = m_scheduler->hosts();
+        if(previousFailed)
         {
-            continue;
+            hosts.release(slot.host, false, 0, slot.timer.elapsed());
         }
-        bytesAll += part.current_progress;
-        bytesTotalAll += part.total_progress;
+        else
+        {
+            hosts.cancel(slot.host);
+        }
+        hosts.acquire(host);
+        slot.timer.restart();
+        m_hostsUsed.insert(host);
+    }
+    slot.host = host;
+    if(m_scheduler)
+    {
+        m_scheduler->schedule();
+    }
+}
+
+void NetJob::queuePart(int index)
+{
+    auto &slot = parts_progress[index];
+    if(m_scheduler)
+    {
+        slot.host = m_scheduler->hostFor(slot.url);
     }
+    m_todo.enqueue(index);
+    m_todoHosts[slot.host]++;
+}
 
-    qint64 inprogress = (bytesTotalAll == 0) ? 0 : (bytesAll * 1000) / bytesTotalAll;
-    auto current = done * 1000 + doing * inprogress;
-    auto current_total = all * 1000;
-    // HACK: make sure it never jumps backwards.
-    // FAIL: This breaks if the size is not known (or is it something else?) and jumps to 1000, so if it is 1000 reset it to inprogress
-    if(m_current_progress == 1000) {
-        m_current_progress = inprogress;
+void NetJob::partProgress(int index, qint64 bytesReceived, qint64 bytesTotal)
+{
+    auto &slot = parts_progress[index];
+    if(m_doing.contains(index) && bytesReceived > slot.current_progress)
+    {
+        updateRate(bytesReceived - slot.current_progress);
     }
-    if(m_current_progress > current)
+    slot.current_progress = bytesReceived;
+    slot.total_progress = bytesTotal;
+    // the server knows better than the plan. Ignore the placeholder size of parts that didn't start yet
+    if(m_doing.contains(index) && bytesTotal > 1 && (slot.estimated || slot.size != bytesTotal))
     {
-        current = m_current_progress;
+        setPartSize(index, bytesTotal);
     }
-    m_current_progress = current;
-    setProgress(current, current_total);
+    reportProgress();
 }
 
 void NetJob::executeTask()
 {
+    m_timer.start();
+    qDebug() << "Job" << objectName() << "plans to transfer" << plannedBytes() / 1024 << "KiB in" << parts_progress.size() << "parts,"
+             << m_estimatedParts << "of them of unknown size";
+    reportProgress();
+    if(!m_scheduler)
+    {
+        m_scheduler = APPLICATION->netScheduler();
+    }
+    // the parts were queued before we knew where the router sends them
+    m_todoHosts.clear();
+    for(auto index: m_todo)
+    {
+        auto &slot = parts_progress[index];
+        slot.host = m_scheduler->hostFor(slot.url);
+        m_todoHosts[slot.host]++;
+    }
+    m_scheduler->addJob(this);
     // hack that delays early failures so they can be caught easier
     QMetaObject::invokeMethod(this, "startMoreParts", Qt::QueuedConnection);
 }
@@ -111,46 +529,85 @@ void NetJob::startMoreParts()
         return;
     }
     // OK. We are actively processing tasks, proceed.
+    pullFromSources();
     // Check for final conditions if there's nothing in the queue.
-    if(!m_todo.size())
-    {
-        if(!m_doing.size())
-        {
-            if(!m_failed.size())
-            {
-                emitSucceeded();
-            }
-            else if(m_aborted)
-            {
-                emitAborted();
-            }
-            else
-            {
-                emitFailed(tr("Job '%1' failed to process:\n%2").arg(objectName()).arg(getFailedFiles().join("\n")));
-            }
+    if(!m_todo.size() && !m_doing.size())
+    {
+        // give our slots to the other jobs
+        m_scheduler->removeJob(this);
+        m_scheduler->schedule();
+        logStatistics();
+        if(m_aborted)
+        {
+            emitAborted();
+        }
+        else if(!m_failed.size())
+        {
+            emitSucceeded();
+        }
+        else
+        {
+            emitFailed(tr("Job '%1' failed to process:\n%2").arg(objectName()).arg(getFailedFiles().join("\n")));
         }
         return;
     }
-    // There's work to do, try to start more parts.
-    int source = 6;
-    if(APPLICATION->getconfigfile()){
-        source = APPLICATION->settings()->get("Threads").toInt();
+    // There's work to do (here or in other jobs), the scheduler decides what runs next.
+    m_scheduler->schedule();
+}
+
+bool NetJob::startNextPart(Net::HostConcurrency &hosts)
+{
+    if(!isRunning())
+    {
+        return false;
     }
-    while (m_doing.size() < source)
+    pullFromSources();
+    int candidates = m_todo.size();
+    QSet<QString> saturated;
+    while (candidates-- > 0)
     {
-        if(!m_todo.size())
-            return;
+        // every host that still has work queued is at its limit
+        if(saturated.size() >= m_todoHosts.size())
+            return false;
         int doThis = m_todo.dequeue();
-        m_doing.insert(doThis);
+        auto &slot = parts_progress[doThis];
         auto part = downloads[doThis];
+        // somebody else is already fetching the same thing, no need to use a connection for it
+        auto leader = m_scheduler->producerOf(part.get());
+        if(!leader && (saturated.contains(slot.host) || !hosts.tryAcquire(slot.host)))
+        {
+            saturated.insert(slot.host);
+            m_todo.enqueue(doThis);
+            continue;
+        }
+        if(--m_todoHosts[slot.host] <= 0)
+        {
+            m_todoHosts.remove(slot.host);
+        }
+        m_doing.insert(doThis);
         // connect signals :D
         connect(part.get(), SIGNAL(succeeded(int)), SLOT(partSucceeded(int)));
         connect(part.get(), SIGNAL(failed(int)), SLOT(partFailed(int)));
         connect(part.get(), SIGNAL(aborted(int)), SLOT(partAborted(int)));
+        connect(part.get(), &NetAction::hostChanged, this, &NetJob::partMoved);
         connect(part.get(), SIGNAL(netActionProgress(int, qint64, qint64)),
                 SLOT(partProgress(int, qint64, qint64)));
+        if(leader)
+        {
+            qDebug() << "Waiting for a running download of" << part->targetKey();
+            part->follow(leader);
+            return true;
+        }
+        part->setRateLimiter(&m_scheduler->rateLimiter(), m_priority, m_rateBucket);
+        part->setRouter(&m_scheduler->router(), &m_scheduler->mirrorHealth());
+        part->setScheduler(m_scheduler.get());
+        m_scheduler->claimTarget(part.get());
+        m_hostsUsed.insert(slot.host);
+        slot.timer.start();
         part->start(m_network);
+        return true;
     }
+    return false;
 }
 
 
@@ -186,9 +643,13 @@ bool NetJob::canAbort() const
 bool NetJob::abort()
 {
     bool fullyAborted = true;
+    m_aborted = true;
     // fail all waiting
     m_failed.unite(m_todo.toSet());
     m_todo.clear();
+    m_todoHosts.clear();
+    // whatever the sources still have will not be needed
+    m_sources.clear();
     // abort active
     auto toKill = m_doing.toList();
     for(auto index: toKill)
@@ -196,16 +657,38 @@ bool NetJob::abort()
         auto part = downloads[index];
         fullyAborted &= part->abort();
     }
+    if(toKill.isEmpty())
+    {
+        // all parts were still waiting for a slot, nothing will report back to finish the job
+        QMetaObject::invokeMethod(this, "startMoreParts", Qt::QueuedConnection);
+    }
     return fullyAborted;
 }
 
+void NetJob::addActionSource(Net::ActionSource::Ptr source)
+{
+    m_sources.append(source);
+}
+
 bool NetJob::addNetAction(NetAction::Ptr action)
 {
     action->m_index_within_job = downloads.size();
     downloads.append(action);
     part_info pi;
+    pi.url = action->url();
+    pi.host = pi.url.host();
     parts_progress.append(pi);
-    partProgress(parts_progress.count() - 1, action->currentProgress(), action->totalProgress());
+    m_estimatedParts++;
+    int index = parts_progress.count() - 1;
+    if(action->expectedSize() >= 0)
+    {
+        setPartSize(index, action->expectedSize());
+    }
+    else if(action->totalProgress() > 1)
+    {
+        setPartSize(index, action->totalProgress());
+    }
+    partProgress(index, action->currentProgress(), action->totalProgress());
 
     if(action->isRunning())
     {
@@ -215,9 +698,15 @@ bool NetJob::addNetAction(NetAction::Ptr action)
     }
     else
     {
-        m_todo.append(parts_progress.size() - 1);
+        queuePart(index);
     }
     return true;
 }
 
-NetJob::~NetJob() = default;
+NetJob::~NetJob()
+{
+    if(m_scheduler)
+    {
+        m_scheduler->removeJob(this);
+    }
+}
@@ -15,9 +15,13 @@
 
 #pragma once
 #include <QtNetwork>
+#include <QJsonObject>
 #include "NetAction.h"
+#include "ActionSource.h"
 #include "Download.h"
 #include "HttpMetaCache.h"
+#include "Scheduler.h"
+#include "Priority.h"
 #include "tasks/Task.h"
 #include "QObjectPtr.h"
 
@@ -36,7 +40,10 @@ public:
     virtual ~NetJob();
 
     bool addNetAction(NetAction::Ptr action);
+    // take more actions from the source while the job runs, after the ones added directly
+    void addActionSource(Net::ActionSource::Ptr source);
 
+    // NOTE: actions that came from a source and succeeded are let go, they show up as null here
     NetAction::Ptr operator[](int index)
     {
         return downloads[index];
@@ -59,9 +66,64 @@ public:
 
     bool canAbort() const override;
 
+    void setPriority(Net::Priority priority)
+    {
+        m_priority = priority;
+    }
+    Net::Priority priority() const
+    {
+        return m_priority;
+    }
+    // use a scheduler other than the application-wide one
+    void setScheduler(Net::Scheduler::Ptr scheduler)
+    {
+        m_scheduler = scheduler;
+    }
+    int runningParts() const
+    {
+        return m_doing.size();
+    }
+    // limit the download rate of this job, in bytes per second. 0 means no limit
+    void setRateLimit(qint64 bytesPerSecond)
+    {
+        m_rateBucket->setRate(bytesPerSecond);
+    }
+    // timings, cache results and the slowest requests of the parts that ran, once the job is done
+    QJsonObject summary(bool withRequests = false) const;
+    // bytes per second over the last few seconds
+    qint64 currentRate() const
+    {
+        return m_rate;
+    }
+    // bytes the whole job is expected to transfer, with parts of unknown size estimated
+    qint64 plannedBytes() const;
+    // seconds until the job is done at the current rate, -1 if there is no rate yet
+    qint64 eta() const;
+
 private slots:
     void startMoreParts();
 
+private:
+    friend class Net::Scheduler;
+    // start one queued part whose host has a free slot, called by the scheduler
+    bool startNextPart(Net::HostConcurrency &hosts);
+    void logStatistics();
+    void dumpTrace();
+    void releasePart(int index, bool success);
+    void updateRate(qint64 bytes);
+    // what a part of unknown size is assumed to weigh, based on the parts we know
+    qint64 estimatedPartSize() const;
+    void setPartSize(int index, qint64 size);
+    void reportProgress();
+    // planned bytes of the actions the sources did not hand out yet
+    qint64 pendingSourceBytes() const;
+    // queue up some actions from the sources, if the queue runs low
+    void pullFromSources();
+    // let go of a finished action, keeping only what the summary needs of it
+    void retirePart(int index);
+    // put the part in the queue, under the host it will be requested from
+    void queuePart(int index);
+
 public slots:
     virtual void executeTask() override;
     virtual bool abort() override;
@@ -71,6 +133,7 @@ private slots:
     void partSucceeded(int index);
     void partFailed(int index);
     void partAborted(int index);
+    void partMoved(int index, QString host, bool previousFailed);
 
 private:
     shared_qobject_ptr<QNetworkAccessManager> m_network;
@@ -79,14 +142,69 @@ private:
     {
         qint64 current_progress = 0;
         qint64 total_progress = 1;
+        // expected size in bytes, only meaningful if it is not estimated
+        qint64 size = 0;
+        bool estimated = true;
+        // the action came from a source and can be let go when it is done
+        bool fromSource = false;
         int failures = 0;
+        QUrl url;
+        // where the request goes, after routing. The slot of a running part is held there
+        QString host;
+        QElapsedTimer timer;
     };
+    // the numbers summary() reports, collected from the traces of the parts
+    struct trace_stats
+    {
+        void add(const Net::RequestTrace &trace, bool keepRequest);
+
+        QList<qint64> ttfb;
+        QList<qint64> total;
+        QHash<QString, int> cacheResults;
+        int retries = 0;
+        int failovers = 0;
+        int hedged = 0;
+        int http2 = 0;
+        int prewarmed = 0;
+        int rewritten = 0;
+        // requests per routing rule that rewrote them
+        QHash<QString, int> rules;
+        qint64 savedHandshakeMs = 0;
+        // the five slowest, slowest first
+        QList<Net::RequestTrace> slowest;
+        QList<Net::RequestTrace> requests;
+    };
+
     QList<NetAction::Ptr> downloads;
+    QList<Net::ActionSource::Ptr> m_sources;
+    // what is left of the actions that were let go
+    trace_stats m_retired;
     QList<part_info> parts_progress;
     QQueue<int> m_todo;
+    // number of queued parts per host
+    QHash<QString, int> m_todoHosts;
     QSet<int> m_doing;
     QSet<int> m_done;
     QSet<int> m_failed;
-    qint64 m_current_progress = 0;
     bool m_aborted = false;
+
+    // the planned size of the job: parts with a known size, and how many are estimated
+    qint64 m_knownBytes = 0;
+    int m_knownParts = 0;
+    int m_estimatedParts = 0;
+    // planned bytes of the parts that are done
+    qint64 m_finishedBytes = 0;
+    qint64 m_reportedProgress = 0;
+
+    Net::Scheduler::Ptr m_scheduler;
+    Net::Priority m_priority = Net::Priority::Background;
+    QSet<QString> m_hostsUsed;
+    QElapsedTimer m_timer;
+    qint64 m_bytesDone = 0;
+
+    std::shared_ptr<Net::TokenBucket> m_rateBucket = std::make_shared<Net::TokenBucket>();
+    // bytes received since the rate was last updated
+    qint64 m_rateBytes = 0;
+    QElapsedTimer m_rateTimer;
+    qint64 m_rate = 0;
 };
@@ -0,0 +1,256 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QEventLoop>
+#include <QElapsedTimer>
+#include <QCryptographicHash>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QFile>
+#include <QTimer>
+#include <random>
+#include <algorithm>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "net/NetJob.h"
+#include "net/Download.h"
+#include "net/ChecksumValidator.h"
+#include "net/FakeCdn.h"
+#include <FileSystem.h>
+
+/*
+ * Drives NetJob against FakeCdn with workloads shaped like what the launcher downloads: thousands
+ * of small assets, a few hundred libraries and one big file.
+ *
+ * Built as NetJob_benchmark, ctest doesn't run it. The workloads are scaled down by default, so a run stays
+ * short. Set LAUNCHER_NET_BENCHMARK_FULL=1 for the real sizes, and LAUNCHER_NET_BENCHMARK_OUTPUT to a file
+ * to append the results to, as JSON lines.
+ *
+ * Besides throughput and CPU time, every run samples how late a 1 ms timer on the main thread fires. The
+ * launcher's GUI thread runs the downloads, so the longest and the 99th percentile delay are how long the
+ * UI froze.
+ */
+namespace {
+qint64 processCpuTimeMs()
+{
+#if defined(Q_OS_WIN)
+    FILETIME creation, exit, kernel, user;
+    if(!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+    {
+        return -1;
+    }
+    auto toMs = [](const FILETIME &time)
+    {
+        return ((qint64(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 10000;
+    };
+    return toMs(kernel) + toMs(user);
+#else
+    rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return -1;
+    }
+    return (qint64(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+#endif
+}
+
+struct Object
+{
+    QString path;
+    qint64 size = 0;
+    QByteArray sha1;
+};
+}
+
+class NetJobBenchmark : public QObject
+{
+    Q_OBJECT
+
+    void addObjects(const QString &workload, int count, qint64 minSize, qint64 maxSize)
+    {
+        std::minstd_rand random(qHash(workload));
+        auto &objects = m_workloads[workload];
+        for(int i = 0; i < count; i++)
+        {
+            Object object;
+            object.path = QString("%1/%2/%3.bin").arg(workload).arg(i % 256, 2, 16, QChar('0')).arg(i);
+            object.size = minSize + qint64(random() % quint64(maxSize - minSize + 1));
+            quint32 seed = quint32(random());
+            m_cdn->addGeneratedFile(object.path, object.size, seed);
+            QCryptographicHash hash(QCryptographicHash::Sha1);
+            for(qint64 offset = 0; offset < object.size; offset += 1024 * 1024)
+            {
+                hash.addData(FakeCdn::generate(seed, offset, qMin<qint64>(1024 * 1024, object.size - offset)));
+            }
+            object.sha1 = hash.result();
+            objects.append(object);
+        }
+    }
+
+    FakeCdn::Options remote(int latencyMs, qint64 bytesPerSecond)
+    {
+        FakeCdn::Options options;
+        options.latencyMs = latencyMs;
+        options.bytesPerSecond = bytesPerSecond;
+        return options;
+    }
+
+    void runWorkload(const QString &workload, const FakeCdn::Options &options)
+    {
+        auto &objects = m_workloads[workload];
+        QTemporaryDir dir;
+        m_cdn->setOptions(options);
+        m_cdn->resetCounters();
+
+        NetJob::Ptr job(new NetJob("Benchmark " + workload, m_network));
+        // nothing learned about the hosts in earlier runs
+        job->setScheduler(Net::Scheduler::Ptr(new Net::Scheduler()));
+        qint64 bytes = 0;
+        for(auto & object: objects)
+        {
+            auto dl = Net::Download::makeFile(m_cdn->url(object.path), FS::PathCombine(dir.path(), object.path));
+            dl->addValidator(new Net::ChecksumValidator(QCryptographicHash::Sha1, object.sha1));
+            job->addNetAction(dl);
+            bytes += object.size;
+        }
+
+        // time between ticks of the main thread's event loop
+        QList<qint64> ticks;
+        QElapsedTimer sinceTick;
+        QTimer ticker;
+        ticker.setTimerType(Qt::PreciseTimer);
+        ticker.setInterval(1);
+        connect(&ticker, &QTimer::timeout, [&]()
+        {
+            ticks.append(sinceTick.restart());
+        });
+
+        QEventLoop loop;
+        connect(job.get(), &Task::finished, &loop, &QEventLoop::quit);
+        qint64 cpuBefore = processCpuTimeMs();
+        qint64 serverCpuBefore = m_cdn->cpuTimeMs();
+        QElapsedTimer timer;
+        timer.start();
+        sinceTick.start();
+        ticker.start();
+        job->start();
+        loop.exec();
+        ticker.stop();
+        qint64 elapsedMs = qMax<qint64>(timer.elapsed(), 1);
+        std::sort(ticks.begin(), ticks.end());
+        qint64 stallMaxMs = ticks.isEmpty() ? elapsedMs : ticks.last();
+        qint64 stallP99Ms = ticks.isEmpty() ? elapsedMs : ticks[qMin(ticks.size() - 1, ticks.size() * 99 / 100)];
+        qint64 cpuMs = processCpuTimeMs() - cpuBefore;
+        // the server runs in this process too, its share is not what we are measuring
+        if(serverCpuBefore >= 0 && m_cdn->cpuTimeMs() >= 0)
+        {
+            cpuMs -= m_cdn->cpuTimeMs() - serverCpuBefore;
+        }
+        QVERIFY(job->wasSuccessful());
+
+        QJsonObject result;
+        result.insert("workload", workload);
+        result.insert("scenario", QString(QTest::currentDataTag()));
+        result.insert("objects", objects.size());
+        result.insert("bytes", bytes);
+        result.insert("elapsedMs", elapsedMs);
+        result.insert("cpuMs", cpuMs);
+        result.insert("stallMaxMs", stallMaxMs);
+        result.insert("stallP99Ms", stallP99Ms);
+        result.insert("mbPerSecond", (bytes / 1048576.0) / (elapsedMs / 1000.0));
+        result.insert("requestsPerSecond", m_cdn->requests() * 1000.0 / elapsedMs);
+        result.insert("requests", m_cdn->requests());
+        result.insert("connections", m_cdn->connections());
+        qDebug() << workload << QTest::currentDataTag() << ":" << objects.size() << "objects," << bytes / 1048576.0 << "MiB in" << elapsedMs << "ms,"
+                 << result.value("mbPerSecond").toDouble() << "MB/s," << result.value("requestsPerSecond").toDouble() << "requests/s,"
+                 << "CPU:" << cpuMs << "ms," << m_cdn->connections() << "connections,"
+                 << "main thread stalls max/p99:" << stallMaxMs << "/" << stallP99Ms << "ms";
+
+        auto output = qgetenv("LAUNCHER_NET_BENCHMARK_OUTPUT");
+        if(!output.isEmpty())
+        {
+            QFile file(QString::fromLocal8Bit(output));
+            if(file.open(QIODevice::WriteOnly | QIODevice::Append))
+            {
+                file.write(QJsonDocument(result).toJson(QJsonDocument::Compact) + "\n");
+            }
+        }
+    }
+
+    void addScenarios(qint64 remoteBytesPerSecond)
+    {
+        QTest::addColumn<int>("latencyMs");
+        QTest::addColumn<qint64>("bytesPerSecond");
+        QTest::newRow("local") << 0 << qint64(0);
+        QTest::newRow("remote") << 20 << remoteBytesPerSecond;
+    }
+
+private
+slots:
+    void initTestCase()
+    {
+        bool full = qgetenv("LAUNCHER_NET_BENCHMARK_FULL") == "1";
+        int scale = full ? 1 : 10;
+        m_cdn.reset(new FakeCdn());
+        m_network.reset(new QNetworkAccessManager());
+        addObjects("assets", 5000 / scale, 1024, 24 * 1024);
+        addObjects("libraries", 200 / scale, 32 * 1024, 3 * 1024 * 1024);
+        qint64 bigSize = full ? 500ll * 1024 * 1024 : 64ll * 1024 * 1024;
+        addObjects("bigfile", 1, bigSize, bigSize);
+    }
+
+    void bench_assets_data()
+    {
+        addScenarios(2 * 1024 * 1024);
+    }
+    void bench_assets()
+    {
+        QFETCH(int, latencyMs);
+        QFETCH(qint64, bytesPerSecond);
+        QBENCHMARK_ONCE
+        {
+            runWorkload("assets", remote(latencyMs, bytesPerSecond));
+        }
+    }
+
+    void bench_libraries_data()
+    {
+        addScenarios(4 * 1024 * 1024);
+    }
+    void bench_libraries()
+    {
+        QFETCH(int, latencyMs);
+        QFETCH(qint64, bytesPerSecond);
+        QBENCHMARK_ONCE
+        {
+            runWorkload("libraries", remote(latencyMs, bytesPerSecond));
+        }
+    }
+
+    void bench_bigfile_data()
+    {
+        addScenarios(32 * 1024 * 1024);
+    }
+    void bench_bigfile()
+    {
+        QFETCH(int, latencyMs);
+        QFETCH(qint64, bytesPerSecond);
+        QBENCHMARK_ONCE
+        {
+            runWorkload("bigfile", remote(latencyMs, bytesPerSecond));
+        }
+    }
+
+private:
+    std::unique_ptr<FakeCdn> m_cdn;
+    shared_qobject_ptr<QNetworkAccessManager> m_network;
+    QHash<QString, QList<Object>> m_workloads;
+};
+
+QTEST_GUILESS_MAIN(NetJobBenchmark)
+
+#include "NetJob_benchmark.moc"
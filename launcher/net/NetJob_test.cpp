@@ -0,0 +1,55 @@
+#include <QTest>
+#include <QSignalSpy>
+
+#include "net/NetJob.h"
+#include "net/Download.h"
+
+class NetJobTest : public QObject
+{
+    Q_OBJECT
+private
+slots:
+    void test_abortQueued()
+    {
+        shared_qobject_ptr<QNetworkAccessManager> network(new QNetworkAccessManager());
+        Net::Scheduler::Ptr scheduler(new Net::Scheduler());
+        scheduler->setConnectionLimit(1);
+        // somebody else has the only connection to the host
+        scheduler->hosts().acquire("127.0.0.1");
+
+        NetJob::Ptr job(new NetJob("Abort test", network));
+        job->setScheduler(scheduler);
+        QByteArray first, second;
+        job->addNetAction(Net::Download::makeByteArray(QUrl("http://127.0.0.1:1/first"), &first));
+        job->addNetAction(Net::Download::makeByteArray(QUrl("http://127.0.0.1:1/second"), &second));
+        QSignalSpy finished(job.get(), &Task::finished);
+        job->start();
+        QTest::qWait(50);
+        QVERIFY(job->isRunning());
+        QCOMPARE(finished.count(), 0);
+
+        job->abort();
+        QVERIFY(finished.wait(1000));
+        QVERIFY(!job->wasSuccessful());
+        QCOMPARE(job->failReason(), QString("Aborted."));
+    }
+
+    void test_leaderDestroyed()
+    {
+        QByteArray first, second;
+        auto leader = Net::Download::makeByteArray(QUrl("http://127.0.0.1:1/same"), &first);
+        auto follower = Net::Download::makeByteArray(QUrl("http://127.0.0.1:1/same"), &second);
+        QSignalSpy failed(follower.get(), &NetAction::failed);
+        follower->follow(leader.get());
+        QVERIFY(follower->isRunning());
+        leader.reset();
+        // its job starts it again, on its own this time
+        QTRY_COMPARE(failed.count(), 1);
+        QVERIFY(!follower->isRunning());
+        QVERIFY(!follower->wasSuccessful());
+    }
+};
+
+QTEST_GUILESS_MAIN(NetJobTest)
+
+#include "NetJob_test.moc"
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace Net
+{
+// order in which the scheduler serves jobs, most important first
+enum class Priority
+{
+    Interactive,
+    Background,
+    Thumbnail
+};
+}
@@ -0,0 +1,307 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "RangeSegment.h"
+
+#include <QDebug>
+#include <QtConcurrentRun>
+#include <QTimer>
+
+namespace Net {
+
+namespace {
+// a segment picks up where it stopped this many times before it gives up
+const int MaxRetries = 2;
+}
+
+RangeSegment::RangeSegment(const QNetworkRequest &request, const QByteArray &ifRange, const QString &path, qint64 first, qint64 end)
+    : m_request(request), m_ifRange(ifRange), m_path(path), m_first(first), m_end(end)
+{
+    connect(&m_writeWatcher, &QFutureWatcher<bool>::finished, this, &RangeSegment::writeFinished);
+}
+
+RangeSegment::~RangeSegment()
+{
+    // a write that is still running holds on to the file and closes it when it is done
+}
+
+void RangeSegment::setRateLimiter(RateLimiter * limiter, Priority priority, std::shared_ptr<TokenBucket> jobBucket)
+{
+    m_limiter = limiter;
+    m_priority = priority;
+    m_jobBucket = jobBucket;
+}
+
+void RangeSegment::start(shared_qobject_ptr<QNetworkAccessManager> network)
+{
+    m_network = network;
+    m_timer.start();
+    m_file = std::make_shared<QFile>(m_path);
+    if(!m_file->open(QIODevice::ReadWrite))
+    {
+        qCritical() << "Could not open" << m_path << "for writing a segment:" << m_file->errorString();
+        m_file.reset();
+        // not while the download is still setting up the other segments
+        QTimer::singleShot(0, this, [this]()
+        {
+            if(!m_done)
+            {
+                finish(false);
+            }
+        });
+        return;
+    }
+    sendRequest();
+}
+
+void RangeSegment::sendRequest()
+{
+    QNetworkRequest request = m_request;
+    request.setRawHeader("Range", QString("bytes=%1-%2").arg(m_first + m_received).arg(m_end - 1).toLatin1());
+    request.setRawHeader("If-Range", m_ifRange);
+    m_rangeChecked = false;
+    auto rep = m_network->get(request);
+    if(m_limiter && m_limiter->isLimited(m_priority, m_jobBucket.get()))
+    {
+        rep->setReadBufferSize(RateLimiter::ReadBufferSize);
+    }
+    m_reply.reset(rep);
+    connect(rep, &QNetworkReply::readyRead, this, &RangeSegment::readyRead);
+    connect(rep, &QNetworkReply::finished, this, &RangeSegment::replyFinished);
+}
+
+bool RangeSegment::checkRange()
+{
+    if(m_rangeChecked)
+    {
+        return true;
+    }
+    int statusCode = m_reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    // Content-Range: bytes <first>-<last>/<total>
+    auto range = QString::fromLatin1(m_reply->rawHeader("Content-Range"));
+    bool ok = false;
+    qint64 first = range.section(' ', 1).section('-', 0, 0).toLongLong(&ok);
+    if(statusCode != 206 || !ok || first != m_first + m_received)
+    {
+        qWarning() << "Segment of" << m_reply->url().toString() << "got" << statusCode << range
+                   << "instead of the range starting at" << m_first + m_received;
+        return false;
+    }
+    m_rangeChecked = true;
+    return true;
+}
+
+QByteArray RangeSegment::readAllowed(bool limited)
+{
+    qint64 wanted = qMin(m_reply->bytesAvailable(), m_end - m_first - m_received);
+    if(limited && m_limiter)
+    {
+        qint64 allowed = m_limiter->acquire(m_priority, m_jobBucket.get(), wanted);
+        if(allowed < wanted)
+        {
+            connect(m_limiter, &RateLimiter::tokensAvailable, this, &RangeSegment::readyRead, Qt::UniqueConnection);
+        }
+        else
+        {
+            disconnect(m_limiter, &RateLimiter::tokensAvailable, this, &RangeSegment::readyRead);
+        }
+        wanted = allowed;
+    }
+    if(wanted <= 0)
+    {
+        return QByteArray();
+    }
+    return m_reply->read(wanted);
+}
+
+void RangeSegment::readyRead()
+{
+    if(!m_reply || m_failed || m_done)
+    {
+        return;
+    }
+    if(!checkRange())
+    {
+        fail();
+        return;
+    }
+    auto data = readAllowed(true);
+    if(data.size())
+    {
+        queueWrite(data);
+    }
+}
+
+void RangeSegment::queueWrite(const QByteArray &data)
+{
+    if(m_pendingData.isEmpty())
+    {
+        m_pendingOffset = m_first + m_received;
+    }
+    m_pendingData.append(data);
+    m_received += data.size();
+    emit progress();
+    if(!m_writeWatcher.isRunning())
+    {
+        startWrite();
+    }
+}
+
+void RangeSegment::startWrite()
+{
+    QByteArray data;
+    data.swap(m_pendingData);
+    auto file = m_file;
+    qint64 offset = m_pendingOffset;
+    m_writeWatcher.setFuture(QtConcurrent::run(QThreadPool::globalInstance(), [file, offset, data]()
+    {
+        return file->seek(offset) && file->write(data) == data.size();
+    }));
+}
+
+void RangeSegment::writeFinished()
+{
+    if(m_done)
+    {
+        // aborted while writing, the file was left open for the write
+        closeFile();
+        return;
+    }
+    if(!m_writeWatcher.result() && !m_failed)
+    {
+        qCritical() << "Failed writing a segment into" << m_path << ":" << m_file->errorString();
+        m_failed = true;
+        if(m_reply)
+        {
+            m_reply->disconnect(this);
+            m_reply->abort();
+        }
+        m_finishPending = true;
+    }
+    if(!m_failed && m_pendingData.size())
+    {
+        startWrite();
+        return;
+    }
+    m_pendingData.clear();
+    if(m_finishPending)
+    {
+        m_finishPending = false;
+        replyFinished();
+    }
+}
+
+void RangeSegment::fail()
+{
+    m_failed = true;
+    if(m_reply)
+    {
+        m_reply->disconnect(this);
+        m_reply->abort();
+    }
+    replyFinished();
+}
+
+void RangeSegment::replyFinished()
+{
+    if(m_done)
+    {
+        return;
+    }
+    if(m_limiter)
+    {
+        disconnect(m_limiter, &RateLimiter::tokensAvailable, this, &RangeSegment::readyRead);
+    }
+    if(m_writeWatcher.isRunning())
+    {
+        m_finishPending = true;
+        return;
+    }
+    if(m_failed)
+    {
+        finish(false);
+        return;
+    }
+    if(m_reply->error() == QNetworkReply::NoError)
+    {
+        if(!checkRange())
+        {
+            finish(false);
+            return;
+        }
+        // whatever the rate limits held back
+        auto data = readAllowed(false);
+        if(data.size())
+        {
+            queueWrite(data);
+            m_finishPending = true;
+            return;
+        }
+    }
+    if(m_received >= size())
+    {
+        finish(true);
+        return;
+    }
+    if(m_reply->error() != QNetworkReply::OperationCanceledError && m_retries < MaxRetries)
+    {
+        m_retries++;
+        qDebug() << "Segment of" << m_reply->url().toString() << "stopped at" << m_first + m_received << "- retrying";
+        sendRequest();
+        return;
+    }
+    finish(false);
+}
+
+void RangeSegment::finish(bool success)
+{
+    m_done = true;
+    m_reply.reset();
+    if(m_file)
+    {
+        success &= m_file->flush();
+        closeFile();
+    }
+    emit finished(success);
+}
+
+void RangeSegment::abort()
+{
+    m_failed = true;
+    m_done = true;
+    if(m_reply)
+    {
+        m_reply->disconnect(this);
+        m_reply->abort();
+        m_reply.reset();
+    }
+    m_pendingData.clear();
+    // a running write is not waited for, writeFinished closes the file after it
+    if(!m_writeWatcher.isRunning())
+    {
+        closeFile();
+    }
+}
+
+void RangeSegment::closeFile()
+{
+    if(m_file)
+    {
+        m_file->close();
+        m_file.reset();
+    }
+}
+}
@@ -0,0 +1,115 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <QObject>
+#include <QFile>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <memory>
+
+#include "RateLimiter.h"
+#include "QObjectPtr.h"
+
+namespace Net {
+/*
+ * One byte range of a download that was split up, written straight to its place in the partial file.
+ *
+ * The range is requested with If-Range, so a file that changed on the server in the meantime
+ * fails the segment instead of mixing two versions.
+ */
+class RangeSegment : public QObject
+{
+    Q_OBJECT
+public: /* con/des */
+    // fetches [first, end) of the file at the URL of the request into the file at path
+    RangeSegment(const QNetworkRequest &request, const QByteArray &ifRange, const QString &path, qint64 first, qint64 end);
+    virtual ~RangeSegment();
+
+public: /* methods */
+    void start(shared_qobject_ptr<QNetworkAccessManager> network);
+    void abort();
+    void setRateLimiter(RateLimiter * limiter, Priority priority, std::shared_ptr<TokenBucket> jobBucket);
+
+    // bytes received so far
+    qint64 received() const
+    {
+        return m_received;
+    }
+    qint64 size() const
+    {
+        return m_end - m_first;
+    }
+    bool isFinished() const
+    {
+        return m_done;
+    }
+    qint64 elapsedMs() const
+    {
+        return m_timer.isValid() ? m_timer.elapsed() : 0;
+    }
+
+signals:
+    void progress();
+    void finished(bool success);
+
+private slots:
+    void readyRead();
+    void replyFinished();
+    void writeFinished();
+
+private: /* methods */
+    void sendRequest();
+    bool checkRange();
+    // as much of the available data as the range and the rate limits allow
+    QByteArray readAllowed(bool limited);
+    void queueWrite(const QByteArray &data);
+    void startWrite();
+    void fail();
+    void finish(bool success);
+    void closeFile();
+
+private: /* data */
+    QNetworkRequest m_request;
+    QByteArray m_ifRange;
+    QString m_path;
+    qint64 m_first;
+    qint64 m_end;
+    qint64 m_received = 0;
+    int m_retries = 0;
+    // the response was checked to be the range we asked for
+    bool m_rangeChecked = false;
+    bool m_done = false;
+
+    shared_qobject_ptr<QNetworkAccessManager> m_network;
+    unique_qobject_ptr<QNetworkReply> m_reply;
+    std::shared_ptr<QFile> m_file;
+    QByteArray m_pendingData;
+    qint64 m_pendingOffset = 0;
+    QFutureWatcher<bool> m_writeWatcher;
+    bool m_finishPending = false;
+    bool m_failed = false;
+    QElapsedTimer m_timer;
+
+    QPointer<RateLimiter> m_limiter;
+    Priority m_priority = Priority::Background;
+    std::shared_ptr<TokenBucket> m_jobBucket;
+};
+}
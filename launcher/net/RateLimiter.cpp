@@ -0,0 +1,114 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RateLimiter.h"
+
+#include <limits>
+
+namespace Net {
+
+void TokenBucket::setRate(qint64 bytesPerSecond)
+{
+    m_rate = qMax<qint64>(bytesPerSecond, 0);
+    m_tokens = 0.0;
+    m_lastMs = -1;
+}
+
+qint64 TokenBucket::available(qint64 nowMs)
+{
+    if(!isLimited())
+    {
+        return std::numeric_limits<qint64>::max();
+    }
+    if(m_lastMs >= 0)
+    {
+        double capacity = qMax<qint64>(m_rate / 4, 16 * 1024);
+        m_tokens = qMin(capacity, m_tokens + (nowMs - m_lastMs) * m_rate / 1000.0);
+    }
+    m_lastMs = nowMs;
+    return qint64(m_tokens);
+}
+
+void TokenBucket::take(qint64 bytes)
+{
+    if(isLimited())
+    {
+        m_tokens -= bytes;
+    }
+}
+
+RateLimiter::RateLimiter(QObject *parent) : QObject(parent)
+{
+    m_clock.start();
+    m_refillTimer.setSingleShot(true);
+    m_refillTimer.setInterval(20);
+    connect(&m_refillTimer, &QTimer::timeout, this, &RateLimiter::tokensAvailable);
+}
+
+void RateLimiter::setGlobalLimit(qint64 bytesPerSecond)
+{
+    m_global.setRate(bytesPerSecond);
+    emit tokensAvailable();
+}
+
+void RateLimiter::setBackgroundLimit(qint64 bytesPerSecond)
+{
+    m_background.setRate(bytesPerSecond);
+    emit tokensAvailable();
+}
+
+bool RateLimiter::isLimited(Priority priority, TokenBucket *jobBucket) const
+{
+    if(m_global.isLimited())
+    {
+        return true;
+    }
+    if(priority != Priority::Interactive && m_background.isLimited())
+    {
+        return true;
+    }
+    return jobBucket && jobBucket->isLimited();
+}
+
+qint64 RateLimiter::acquire(Priority priority, TokenBucket *jobBucket, qint64 wanted)
+{
+    QList<TokenBucket *> buckets;
+    buckets.append(&m_global);
+    if(priority != Priority::Interactive)
+    {
+        buckets.append(&m_background);
+    }
+    if(jobBucket)
+    {
+        buckets.append(jobBucket);
+    }
+    auto now = m_clock.elapsed();
+    qint64 granted = wanted;
+    for(auto bucket: buckets)
+    {
+        granted = qMin(granted, bucket->available(now));
+    }
+    granted = qMax<qint64>(granted, 0);
+    for(auto bucket: buckets)
+    {
+        bucket->take(granted);
+    }
+    if(granted < wanted && !m_refillTimer.isActive())
+    {
+        m_refillTimer.start();
+    }
+    return granted;
+}
+}
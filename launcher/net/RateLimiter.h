@@ -0,0 +1,87 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include "Priority.h"
+
+namespace Net {
+/*
+ * Token bucket. Fills up at the configured rate, holding at most a quarter of a second worth of data.
+ */
+class TokenBucket
+{
+public: /* methods */
+    // bytes per second, 0 means no limit
+    void setRate(qint64 bytesPerSecond);
+    qint64 rate() const
+    {
+        return m_rate;
+    }
+    bool isLimited() const
+    {
+        return m_rate > 0;
+    }
+    // tokens available at the given time
+    qint64 available(qint64 nowMs);
+    void take(qint64 bytes);
+
+private: /* data */
+    qint64 m_rate = 0;
+    double m_tokens = 0.0;
+    qint64 m_lastMs = -1;
+};
+
+/*
+ * Paces how fast replies are read, and with that how fast the data comes in over the network.
+ *
+ * Reading is limited by a global bucket, a bucket shared by everything that is not interactive, and
+ * optionally a bucket of the job the reply belongs to. Paced replies get a small read buffer, so the
+ * network stack stops accepting data as long as we do not read it.
+ */
+class RateLimiter : public QObject
+{
+    Q_OBJECT
+public: /* con/des */
+    explicit RateLimiter(QObject *parent = nullptr);
+    virtual ~RateLimiter() {};
+
+public: /* methods */
+    // limits in bytes per second, 0 means no limit
+    void setGlobalLimit(qint64 bytesPerSecond);
+    void setBackgroundLimit(qint64 bytesPerSecond);
+
+    bool isLimited(Priority priority, TokenBucket *jobBucket) const;
+    // how many of the wanted bytes can be read now. If that is less than wanted, tokensAvailable follows.
+    qint64 acquire(Priority priority, TokenBucket *jobBucket, qint64 wanted);
+
+    // read buffer size for replies that are being paced
+    static const qint64 ReadBufferSize = 64 * 1024;
+
+signals:
+    void tokensAvailable();
+
+private: /* data */
+    TokenBucket m_global;
+    TokenBucket m_background;
+    QElapsedTimer m_clock;
+    QTimer m_refillTimer;
+};
+}
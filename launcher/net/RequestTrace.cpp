@@ -0,0 +1,112 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "RequestTrace.h"
+
+namespace Net {
+
+void RequestTrace::restart()
+{
+    cacheResult = CacheResult::None;
+    statusCode = 0;
+    bytes = 0;
+    success = false;
+    hedged = false;
+    segments = 0;
+    http2 = false;
+    prewarmed = false;
+    savedHandshakeMs = 0;
+    encryptedMs = -1;
+    headersMs = -1;
+    finishedMs = -1;
+}
+
+qint64 RequestTrace::transferMs() const
+{
+    if(headersMs < 0 || finishedMs < 0)
+    {
+        return -1;
+    }
+    return finishedMs - headersMs;
+}
+
+QString RequestTrace::cacheResultName(CacheResult result)
+{
+    switch(result)
+    {
+        case CacheResult::Hit:
+            return "hit";
+        case CacheResult::NotModified:
+            return "not-modified";
+        case CacheResult::Fetched:
+            return "fetched";
+        case CacheResult::Adopted:
+            return "adopted";
+        case CacheResult::None:
+        default:
+            return "none";
+    }
+}
+
+QJsonObject RequestTrace::toJson() const
+{
+    QJsonObject out;
+    out.insert("url", url.toString());
+    if(originalUrl != url)
+    {
+        out.insert("originalUrl", originalUrl.toString());
+    }
+    if(!mirror.isEmpty())
+    {
+        out.insert("mirror", mirror);
+    }
+    if(!rule.isEmpty())
+    {
+        out.insert("rule", rule);
+    }
+    out.insert("cache", cacheResultName(cacheResult));
+    out.insert("status", statusCode);
+    out.insert("attempts", attempts);
+    out.insert("redirects", redirects);
+    if(failovers)
+    {
+        out.insert("failovers", failovers);
+    }
+    if(hedged)
+    {
+        out.insert("hedged", hedged);
+    }
+    if(segments)
+    {
+        out.insert("segments", segments);
+    }
+    if(http2)
+    {
+        out.insert("http2", http2);
+    }
+    if(prewarmed)
+    {
+        out.insert("prewarmed", prewarmed);
+        out.insert("savedHandshakeMs", savedHandshakeMs);
+    }
+    out.insert("bytes", bytes);
+    out.insert("success", success);
+    out.insert("encryptedMs", encryptedMs);
+    out.insert("ttfbMs", headersMs);
+    out.insert("transferMs", transferMs());
+    out.insert("totalMs", finishedMs);
+    return out;
+}
+}
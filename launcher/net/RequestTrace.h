@@ -0,0 +1,82 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <QUrl>
+#include <QString>
+#include <QJsonObject>
+
+namespace Net {
+/*
+ * What happened to one download, for finding out why things are slow.
+ *
+ * Qt does not tell us about name resolution and connecting separately, so the timings are
+ * measured from the moment the request is handed to the network access manager.
+ */
+struct RequestTrace
+{
+    enum class CacheResult
+    {
+        None,
+        // the local copy was good enough, no request was made
+        Hit,
+        // the server confirmed the local copy (304)
+        NotModified,
+        // the body was transferred
+        Fetched,
+        // another download fetched the same file
+        Adopted
+    };
+
+    // the URL as asked for, and what was actually requested after rewriting
+    QUrl originalUrl;
+    QUrl url;
+    // host of the mirror that served the request, if it was not the original
+    QString mirror;
+    // the routing rule that rewrote the URL
+    QString rule;
+    CacheResult cacheResult = CacheResult::None;
+    int statusCode = 0;
+    int attempts = 0;
+    int redirects = 0;
+    // switches to another mirror within an attempt
+    int failovers = 0;
+    // another mirror was asked too, because the first one took too long to answer
+    bool hedged = false;
+    // number of ranges the body was fetched in, 0 if it came in one piece
+    int segments = 0;
+    bool http2 = false;
+    // the request found a connection opened for it ahead of time, which saved it about this long
+    bool prewarmed = false;
+    qint64 savedHandshakeMs = 0;
+    // body bytes of the last attempt
+    qint64 bytes = 0;
+    bool success = false;
+
+    // ms after the request was sent, -1 if it did not happen (yet)
+    qint64 encryptedMs = -1;
+    qint64 headersMs = -1;
+    qint64 finishedMs = -1;
+
+    // start of a new attempt, keeping the counters
+    void restart();
+    // time from the response headers to the end
+    qint64 transferMs() const;
+    QJsonObject toJson() const;
+    static QString cacheResultName(CacheResult result);
+};
+}
@@ -0,0 +1,216 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "Scheduler.h"
+#include "NetJob.h"
+
+namespace Net {
+
+Scheduler::Scheduler(QObject *parent) : QObject(parent)
+{
+    setConnectionLimit(8);
+}
+
+void Scheduler::setConnectionLimit(int perHost)
+{
+    m_hosts.setHardCap(perHost);
+    m_budget = m_hosts.hardCap() * 2;
+    schedule();
+}
+
+void Scheduler::addJob(NetJob *job)
+{
+    auto &list = m_jobs[int(job->priority())];
+    if(!list.contains(job))
+    {
+        list.append(job);
+    }
+}
+
+void Scheduler::removeJob(NetJob *job)
+{
+    for(auto & list: m_jobs)
+    {
+        list.removeAll(job);
+    }
+}
+
+NetAction *Scheduler::producerOf(NetAction *action)
+{
+    auto key = action->targetKey();
+    if(key.isEmpty())
+    {
+        return nullptr;
+    }
+    auto iter = m_targets.find(key);
+    if(iter == m_targets.end())
+    {
+        return nullptr;
+    }
+    NetAction *producer = iter->data();
+    if(!producer || producer == action || producer->isFinished())
+    {
+        return nullptr;
+    }
+    return producer;
+}
+
+void Scheduler::claimTarget(NetAction *action)
+{
+    auto key = action->targetKey();
+    if(!key.isEmpty())
+    {
+        m_targets[key] = action;
+    }
+}
+
+void Scheduler::releaseTarget(NetAction *action)
+{
+    auto key = action->targetKey();
+    auto iter = m_targets.find(key);
+    if(iter != m_targets.end() && (iter->isNull() || iter->data() == action))
+    {
+        m_targets.erase(iter);
+    }
+}
+
+void Scheduler::warmUp(QNetworkAccessManager *network, const QList<QUrl> &urls)
+{
+    QList<QUrl> routed;
+    for(auto & url: urls)
+    {
+        routed.append(m_router.lookup(url).url);
+    }
+    m_warmer.warmUp(network, routed);
+}
+
+QString Scheduler::hostFor(const QUrl &url) const
+{
+    auto candidates = m_router.lookupCandidates(url);
+    for(auto & route: candidates)
+    {
+        if(!m_mirrorHealth.isDemoted(route.url.host()))
+        {
+            return route.url.host();
+        }
+    }
+    return candidates.isEmpty() ? url.host() : candidates.first().url.host();
+}
+
+int Scheduler::acquireSegments(const QString &host, Priority priority, int wanted)
+{
+    int acquired = 0;
+    while(acquired < wanted && m_hosts.inFlight() < limitFor(priority) && m_hosts.tryAcquire(host))
+    {
+        acquired++;
+    }
+    return acquired;
+}
+
+void Scheduler::releaseSegment(const QString &host, bool success, qint64 bytes, qint64 elapsedMs)
+{
+    m_hosts.release(host, success, bytes, elapsedMs);
+    schedule();
+}
+
+int Scheduler::limitFor(Priority priority) const
+{
+    // slots only interactive jobs may use
+    int reserve = qMax(2, m_budget / 4);
+    switch(priority)
+    {
+        case Priority::Interactive:
+            return m_budget;
+        case Priority::Background:
+            return qMax(1, m_budget - reserve);
+        case Priority::Thumbnail:
+        default:
+            return qMax(1, qMin(reserve, m_budget - reserve));
+    }
+}
+
+int Scheduler::runningParts(Priority priority) const
+{
+    int running = 0;
+    for(auto & job: m_jobs[int(priority)])
+    {
+        if(job)
+        {
+            running += job->runningParts();
+        }
+    }
+    return running;
+}
+
+bool Scheduler::startOne(Priority priority)
+{
+    auto &list = m_jobs[int(priority)];
+    list.removeAll(QPointer<NetJob>());
+    auto candidates = list;
+    for(auto & job: candidates)
+    {
+        if(!job)
+        {
+            continue;
+        }
+        // move it to the back, so the other jobs of the same priority go first next time
+        list.removeOne(job);
+        list.append(job);
+        if(job->startNextPart(m_hosts))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Scheduler::schedule()
+{
+    // parts can finish (and jobs can ask for more work) while we are starting other parts
+    if(m_scheduling)
+    {
+        m_rescheduleRequested = true;
+        return;
+    }
+    m_scheduling = true;
+    do
+    {
+        m_rescheduleRequested = false;
+        bool startedAny = true;
+        while(startedAny)
+        {
+            startedAny = false;
+            for(int i = 0; i < PriorityCount; i++)
+            {
+                auto priority = Priority(i);
+                if(m_hosts.inFlight() >= limitFor(priority))
+                {
+                    continue;
+                }
+                if(priority == Priority::Thumbnail && runningParts(priority) >= limitFor(priority))
+                {
+                    continue;
+                }
+                if(startOne(priority))
+                {
+                    startedAny = true;
+                    break;
+                }
+            }
+        }
+    } while(m_rescheduleRequested);
+    m_scheduling = false;
+}
+}
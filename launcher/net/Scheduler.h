@@ -0,0 +1,134 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QPointer>
+#include <QList>
+#include <QHash>
+
+#include "ConnectionWarmer.h"
+#include "HostConcurrency.h"
+#include "MirrorHealth.h"
+#include "RateLimiter.h"
+#include "UrlRouter.h"
+#include "Priority.h"
+#include "QObjectPtr.h"
+
+class NetJob;
+class NetAction;
+
+namespace Net {
+/*
+ * Owns the connection budget of the whole process and hands it out to running NetJobs.
+ *
+ * Jobs are served strictly by priority and round-robin within a priority. A part of the budget
+ * is kept free for interactive jobs, and thumbnail jobs only get a small share of it, so a launch
+ * never waits behind icon downloads.
+ */
+class Scheduler : public QObject
+{
+    Q_OBJECT
+public: /* types */
+    using Ptr = shared_qobject_ptr<Scheduler>;
+
+public: /* con/des */
+    explicit Scheduler(QObject *parent = nullptr);
+    virtual ~Scheduler() {};
+
+public: /* methods */
+    // the number of connections allowed to a single host, the total budget is derived from it
+    void setConnectionLimit(int perHost);
+    int connectionBudget() const
+    {
+        return m_budget;
+    }
+
+    void addJob(NetJob *job);
+    void removeJob(NetJob *job);
+
+    HostConcurrency &hosts()
+    {
+        return m_hosts;
+    }
+
+    RateLimiter &rateLimiter()
+    {
+        return m_rateLimiter;
+    }
+
+    UrlRouter &router()
+    {
+        return m_router;
+    }
+
+    MirrorHealth &mirrorHealth()
+    {
+        return m_mirrorHealth;
+    }
+
+    ConnectionWarmer &warmer()
+    {
+        return m_warmer;
+    }
+    // connect ahead of time to wherever the router sends the URLs
+    void warmUp(QNetworkAccessManager *network, const QList<QUrl> &urls);
+    // the host a download of the URL asks first: the healthiest mirror the router knows, or the URL's own
+    QString hostFor(const QUrl &url) const;
+
+    // file the summaries of finished jobs are appended to, as JSON lines. Empty to not write them
+    void setTraceFile(const QString &path)
+    {
+        m_traceFile = path;
+    }
+    QString traceFile() const
+    {
+        return m_traceFile;
+    }
+
+    // take up to the given number of additional connections to the host, to split a download over them
+    int acquireSegments(const QString &host, Priority priority, int wanted);
+    void releaseSegment(const QString &host, bool success, qint64 bytes, qint64 elapsedMs);
+
+    // the running action that already produces the same target as the given one, if any
+    NetAction *producerOf(NetAction *action);
+    void claimTarget(NetAction *action);
+    void releaseTarget(NetAction *action);
+
+public slots:
+    // start as many parts of the registered jobs as the budget allows
+    void schedule();
+
+private: /* methods */
+    int limitFor(Priority priority) const;
+    int runningParts(Priority priority) const;
+    bool startOne(Priority priority);
+
+private: /* data */
+    static const int PriorityCount = 3;
+    QList<QPointer<NetJob>> m_jobs[PriorityCount];
+    HostConcurrency m_hosts;
+    RateLimiter m_rateLimiter;
+    UrlRouter m_router;
+    MirrorHealth m_mirrorHealth;
+    ConnectionWarmer m_warmer;
+    QHash<QString, QPointer<NetAction>> m_targets;
+    QString m_traceFile;
+    int m_budget = 16;
+    bool m_scheduling = false;
+    bool m_rescheduleRequested = false;
+};
+}
@@ -18,6 +18,39 @@ public: /* methods */
     virtual JobStatus finalize(QNetworkReply & reply) = 0;
     virtual bool hasLocalData() = 0;
 
+    // called once the response headers are known, before the body is written
+    virtual JobStatus headersReceived(QNetworkReply &)
+    {
+        return Job_InProgress;
+    }
+    // the target was produced by another download, pick up its result
+    virtual JobStatus adopt()
+    {
+        return Job_Failed;
+    }
+    // number of bytes already present locally that the response continues from
+    virtual qint64 resumeOffset()
+    {
+        return 0;
+    }
+
+    // file the body can be written to in ranges, empty if it can't
+    virtual QString segmentTarget()
+    {
+        return QString();
+    }
+    // make room for the whole body in the segment target, the ranges are written there directly
+    virtual bool preallocate(qint64)
+    {
+        return false;
+    }
+    // the body from the given offset to the end was written to the segment target directly, check it.
+    // Called from a worker thread, once nothing else is written
+    virtual JobStatus segmentsWritten(qint64, qint64)
+    {
+        return Job_Failed;
+    }
+
     void addValidator(Validator * validator)
     {
         if(validator)
@@ -47,6 +80,7 @@ protected: /* methods */
     }
     bool initAllValidators(QNetworkRequest & request)
     {
+        shareHashes();
         for(auto & validator: validators)
         {
             if(!validator->init(request))
@@ -56,6 +90,10 @@ protected: /* methods */
     }
     bool writeAllValidators(QByteArray & data)
     {
+        if(m_hashes)
+        {
+            m_hashes->addData(data);
+        }
         for(auto & validator: validators)
         {
             if(!validator->write(data))
@@ -64,7 +102,38 @@ protected: /* methods */
         return true;
     }
 
+private: /* methods */
+    // one pass over the data for all the digests the validators need, instead of one per validator
+    void shareHashes()
+    {
+        Hashing::Algorithms wanted;
+        for(auto & validator: validators)
+        {
+            wanted |= validator->hashes();
+        }
+        if(!wanted)
+        {
+            m_hashes.reset();
+            return;
+        }
+        if(m_hashes && m_hashes->algorithms() == wanted)
+        {
+            m_hashes->reset();
+        }
+        else
+        {
+            m_hashes = std::make_shared<Hashing::MultiHash>(wanted);
+        }
+        for(auto & validator: validators)
+        {
+            validator->useHashes(m_hashes);
+        }
+    }
+
 protected: /* data */
     std::vector<std::shared_ptr<Validator>> validators;
+
+private: /* data */
+    std::shared_ptr<Hashing::MultiHash> m_hashes;
 };
 }
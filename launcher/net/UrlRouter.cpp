@@ -0,0 +1,328 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "UrlRouter.h"
+
+#include <QHostAddress>
+
+namespace Net {
+
+namespace {
+struct BuiltinRule
+{
+    const char *match;
+    const char *replacement;
+};
+// where the mirrors keep what, relative to their base URL
+const BuiltinRule builtinRules[] = {
+    {"resources.download.minecraft.net", "<j_url>/assets"},
+    {"libraries.minecraft.net", "<j_url>/maven"},
+    {"maven.fabricmc.net", "<j_url>/maven"},
+    {"launchermeta.mojang.com", "<j_url>"},
+    {"launcher.mojang.com", "<j_url>"},
+    {"files.minecraftforge.net", "<j_url>"},
+    {"meta.fabricmc.net", "<j_url>/fabric-meta"},
+    {"maven.neoforged.net/releases", "<j_url>/maven"},
+    {"maven.quiltmc.org/repository/release", "<j_url>/maven"},
+    {"meta.quiltmc.org", "<j_url>/quilt-meta"},
+    {"edge.forgecdn.net", ""},
+    {"mediafilez.forgecdn.net", ""}
+};
+}
+
+void UrlRouter::compile(const QList<Source> &sources, const QList<Rule> &userRules)
+{
+    m_nodes.clear();
+    m_rules.clear();
+    m_sources.clear();
+    m_nodes.append(Node());
+
+    for (auto source : sources)
+    {
+        source.baseUrl = normalizeBaseUrl(source.baseUrl);
+        bool known = source.baseUrl.isEmpty();
+        for (auto & other : m_sources)
+        {
+            known |= other.baseUrl == source.baseUrl;
+        }
+        if (!known)
+        {
+            m_sources.append(source);
+        }
+    }
+    if (!m_sources.isEmpty())
+    {
+        for (auto & builtin : builtinRules)
+        {
+            Rule rule;
+            rule.match = builtin.match;
+            rule.name = builtin.match;
+            rule.mode = Mode::Mirror;
+            rule.replacement = builtin.replacement;
+            addRule(rule);
+        }
+    }
+    // user rules win over the built in ones
+    for (auto & rule : userRules)
+    {
+        addRule(rule);
+    }
+}
+
+void UrlRouter::compile(const QString &baseUrl, bool proxy, const QList<Rule> &userRules)
+{
+    QList<Source> sources;
+    if (!baseUrl.trimmed().isEmpty())
+    {
+        Source source;
+        source.baseUrl = baseUrl;
+        source.proxy = proxy;
+        sources.append(source);
+    }
+    compile(sources, userRules);
+}
+
+QString UrlRouter::normalizeBaseUrl(const QString &baseUrl)
+{
+    QString base = baseUrl.trimmed();
+    if (base.isEmpty())
+    {
+        return base;
+    }
+    auto parsed = QUrl::fromUserInput(base);
+    base = parsed.toString();
+    // plain HTTP is only fine for a mirror on this machine
+    bool local = parsed.host() == "localhost" || QHostAddress(parsed.host()).isLoopback();
+    if (!base.startsWith("https://") && !local)
+    {
+        base = base.replace("http://", "https://");
+    }
+    if (!base.endsWith("/"))
+    {
+        base.append('/');
+    }
+    return base;
+}
+
+QList<UrlRouter::Rule> UrlRouter::parseUserRules(const QString &rules)
+{
+    QList<Rule> out;
+    for (auto & line : rules.split(';', QString::SkipEmptyParts))
+    {
+        auto separator = line.indexOf('=');
+        if (separator <= 0)
+        {
+            continue;
+        }
+        Rule rule;
+        rule.match = line.left(separator).trimmed();
+        rule.replacement = line.mid(separator + 1).trimmed();
+        rule.name = "user:" + rule.match;
+        if (!rule.match.isEmpty() && !rule.replacement.isEmpty())
+        {
+            out.append(rule);
+        }
+    }
+    return out;
+}
+
+void UrlRouter::addRule(const Rule &rule)
+{
+    int node = 0;
+    for (auto c : rule.match)
+    {
+        auto iter = m_nodes[node].next.find(c);
+        if (iter == m_nodes[node].next.end())
+        {
+            m_nodes.append(Node());
+            int created = m_nodes.size() - 1;
+            m_nodes[node].next.insert(c, created);
+            node = created;
+        }
+        else
+        {
+            node = *iter;
+        }
+    }
+    m_rules.append(rule);
+    m_nodes[node].rule = m_rules.size() - 1;
+}
+
+int UrlRouter::findRule(const QUrl &url, int &length) const
+{
+    if (m_rules.isEmpty())
+    {
+        return -1;
+    }
+    auto original = url.toString();
+    for (auto & source : m_sources)
+    {
+        if (original.contains(source.baseUrl))
+        {
+            // already going to a mirror
+            return -1;
+        }
+    }
+
+    // find the longest rule that covers the URL, ending at a host or path boundary
+    QString key = url.host() + url.path();
+    int node = 0;
+    int found = -1;
+    for (int i = 0; i <= key.size(); i++)
+    {
+        auto &current = m_nodes[node];
+        if (current.rule != -1 && (i == key.size() || key[i] == '/' || key[i - 1] == '/'))
+        {
+            found = current.rule;
+            length = i;
+        }
+        if (i == key.size())
+        {
+            break;
+        }
+        auto iter = current.next.find(key[i]);
+        if (iter == current.next.end())
+        {
+            break;
+        }
+        node = *iter;
+    }
+    return found;
+}
+
+UrlRouter::Route UrlRouter::apply(const Rule &rule, int length, const QUrl &url, const Source *source) const
+{
+    Route out;
+    out.rule = rule.name;
+    auto original = url.toString();
+    QString key = url.host() + url.path();
+    if (rule.mode == Mode::Mirror)
+    {
+        out.source = source->name;
+        if (source->proxy)
+        {
+            out.url = QUrl(source->baseUrl + original);
+        }
+        else
+        {
+            // the replacement is a path on the source, <j_url> only marks where the base URL goes
+            auto path = rule.replacement;
+            path.remove("<j_url>");
+            auto prefix = source->baseUrl + path.mid(path.startsWith('/') ? 1 : 0);
+            auto rest = key.mid(length);
+            if (prefix.endsWith('/') && rest.startsWith('/'))
+            {
+                prefix.chop(1);
+            }
+            QUrl rewritten(prefix + rest);
+            rewritten.setQuery(url.query());
+            rewritten.setFragment(url.fragment());
+            out.url = rewritten;
+        }
+        return out;
+    }
+    QUrl rewritten(rule.replacement + key.mid(length));
+    rewritten.setQuery(url.query());
+    rewritten.setFragment(url.fragment());
+    out.url = rewritten;
+    return out;
+}
+
+UrlRouter::Route UrlRouter::route(const QUrl &url)
+{
+    int length = 0;
+    int found = findRule(url, length);
+    if (found == -1)
+    {
+        Route out;
+        out.url = url;
+        return out;
+    }
+    auto &rule = m_rules[found];
+    rule.hits++;
+    return apply(rule, length, url, m_sources.isEmpty() ? nullptr : &m_sources.first());
+}
+
+UrlRouter::Route UrlRouter::lookup(const QUrl &url) const
+{
+    int length = 0;
+    int found = findRule(url, length);
+    if (found == -1)
+    {
+        Route out;
+        out.url = url;
+        return out;
+    }
+    return apply(m_rules[found], length, url, m_sources.isEmpty() ? nullptr : &m_sources.first());
+}
+
+QList<UrlRouter::Route> UrlRouter::candidates(const QUrl &url)
+{
+    int length = 0;
+    int found = findRule(url, length);
+    if (found == -1)
+    {
+        return QList<Route>();
+    }
+    m_rules[found].hits++;
+    return candidatesFor(found, length, url);
+}
+
+QList<UrlRouter::Route> UrlRouter::lookupCandidates(const QUrl &url) const
+{
+    int length = 0;
+    int found = findRule(url, length);
+    if (found == -1)
+    {
+        return QList<Route>();
+    }
+    return candidatesFor(found, length, url);
+}
+
+QList<UrlRouter::Route> UrlRouter::candidatesFor(int found, int length, const QUrl &url) const
+{
+    QList<Route> out;
+    auto &rule = m_rules[found];
+    if (rule.mode == Mode::Mirror)
+    {
+        for (auto & source : m_sources)
+        {
+            out.append(apply(rule, length, url, &source));
+        }
+    }
+    else
+    {
+        out.append(apply(rule, length, url, nullptr));
+    }
+    // the original servers, as a last resort
+    Route original;
+    original.url = url;
+    out.append(original);
+    return out;
+}
+
+QStringList UrlRouter::describe() const
+{
+    QStringList out;
+    for (auto & rule : m_rules)
+    {
+        if (rule.hits)
+        {
+            out.append(QString("%1: %2 requests").arg(rule.name).arg(rule.hits));
+        }
+    }
+    return out;
+}
+}
@@ -0,0 +1,108 @@
+/* Copyright 2013-2023 MultiMC Contributors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <QUrl>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+
+namespace Net {
+/*
+ * Rewrites download URLs to mirrors.
+ *
+ * The rules are compiled into a trie of "host/path" prefixes whenever the download sources change,
+ * so routing a URL only walks its host and as much of its path as the rules cover. The built in rules
+ * know where each download source keeps the files of the official servers, which gives every such URL
+ * a list of candidates: the selected source, the other sources, and the original URL.
+ */
+class UrlRouter
+{
+public: /* types */
+    struct Source
+    {
+        QString name;
+        QString baseUrl;
+        // the source takes the whole original URL appended to its base URL
+        bool proxy = false;
+    };
+    enum class Mode
+    {
+        // the URL from the host on is replaced by the replacement
+        ReplacePrefix,
+        // rewritten for every download source, the replacement is the path on the source
+        Mirror
+    };
+    struct Rule
+    {
+        // "host" or "host/path" prefix the rule applies to
+        QString match;
+        QString replacement;
+        Mode mode = Mode::ReplacePrefix;
+        QString name;
+        int hits = 0;
+    };
+    struct Route
+    {
+        QUrl url;
+        // name of the rule that rewrote the URL, empty if none did
+        QString rule;
+        // name of the download source the URL points to, empty if none
+        QString source;
+    };
+
+public: /* methods */
+    // the first source is the selected one
+    void compile(const QList<Source> &sources, const QList<Rule> &userRules = QList<Rule>());
+    // only one source. An empty base URL means no source
+    void compile(const QString &baseUrl, bool proxy, const QList<Rule> &userRules = QList<Rule>());
+    // "match=replacement" pairs, separated by ';'
+    static QList<Rule> parseUserRules(const QString &rules);
+    static QString normalizeBaseUrl(const QString &baseUrl);
+
+    // where the URL goes by default
+    Route route(const QUrl &url);
+    // the same, without counting it as a use of the rule
+    Route lookup(const QUrl &url) const;
+    // everywhere the URL could be fetched from, in order of preference. Empty if no rule applies
+    QList<Route> candidates(const QUrl &url);
+    // the same, without counting it as a use of the rule
+    QList<Route> lookupCandidates(const QUrl &url) const;
+    // one line per rule that was used
+    QStringList describe() const;
+
+private: /* types */
+    struct Node
+    {
+        QHash<QChar, int> next;
+        int rule = -1;
+    };
+
+private: /* methods */
+    void addRule(const Rule &rule);
+    // the rule covering the URL and the length of the part it covers, -1 if there is none
+    int findRule(const QUrl &url, int &length) const;
+    Route apply(const Rule &rule, int length, const QUrl &url, const Source *source) const;
+    QList<Route> candidatesFor(int found, int length, const QUrl &url) const;
+
+private: /* data */
+    QVector<Node> m_nodes;
+    QVector<Rule> m_rules;
+    QList<Source> m_sources;
+};
+}
@@ -0,0 +1,114 @@
+#include <QTest>
+#include "TestUtil.h"
+
+#include "net/UrlRouter.h"
+
+class UrlRouterTest : public QObject
+{
+    Q_OBJECT
+private
+slots:
+    void test_noSource()
+    {
+        Net::UrlRouter router;
+        router.compile(QString(), false);
+        auto route = router.route(QUrl("https://libraries.minecraft.net/a/b.jar"));
+        QCOMPARE(route.url, QUrl("https://libraries.minecraft.net/a/b.jar"));
+        QVERIFY(route.rule.isEmpty());
+    }
+
+    void test_proxy()
+    {
+        Net::UrlRouter router;
+        router.compile("mirror.example", true);
+        auto route = router.route(QUrl("https://maven.neoforged.net/releases/net/neoforged/x.jar"));
+        QCOMPARE(route.url, QUrl("https://mirror.example/https://maven.neoforged.net/releases/net/neoforged/x.jar"));
+        QCOMPARE(route.rule, QString("maven.neoforged.net/releases"));
+
+        // already on the mirror
+        route = router.route(route.url);
+        QVERIFY(route.rule.isEmpty());
+    }
+
+    void test_hostBoundary()
+    {
+        Net::UrlRouter router;
+        router.compile("https://mirror.example/", true);
+        auto route = router.route(QUrl("https://libraries.minecraft.network/a/b.jar"));
+        QVERIFY(route.rule.isEmpty());
+        route = router.route(QUrl("https://maven.neoforged.net/releasesx/a.jar"));
+        QVERIFY(route.rule.isEmpty());
+    }
+
+    void test_userRules()
+    {
+        Net::UrlRouter router;
+        auto rules = Net::UrlRouter::parseUserRules("example.com/files=https://cdn.example.org/mirror; libraries.minecraft.net/special=https://other.example/special;broken");
+        QCOMPARE(rules.size(), 2);
+        router.compile("https://mirror.example/", true, rules);
+
+        auto route = router.route(QUrl("https://example.com/files/a.zip?x=1"));
+        QCOMPARE(route.url, QUrl("https://cdn.example.org/mirror/a.zip?x=1"));
+        QCOMPARE(route.rule, QString("user:example.com/files"));
+
+        // the longest matching rule wins
+        route = router.route(QUrl("https://libraries.minecraft.net/special/c.jar"));
+        QCOMPARE(route.url, QUrl("https://other.example/special/c.jar"));
+        route = router.route(QUrl("https://libraries.minecraft.net/other/c.jar"));
+        QCOMPARE(route.rule, QString("libraries.minecraft.net"));
+
+        QCOMPARE(router.describe().size(), 3);
+    }
+
+    void test_normalizeBaseUrl()
+    {
+        QCOMPARE(Net::UrlRouter::normalizeBaseUrl("mirror.example"), QString("https://mirror.example/"));
+        QCOMPARE(Net::UrlRouter::normalizeBaseUrl("http://mirror.example/x"), QString("https://mirror.example/x/"));
+        QCOMPARE(Net::UrlRouter::normalizeBaseUrl("http://127.0.0.1:8080"), QString("http://127.0.0.1:8080/"));
+        QCOMPARE(Net::UrlRouter::normalizeBaseUrl("http://localhost:8080/"), QString("http://localhost:8080/"));
+        QVERIFY(Net::UrlRouter::normalizeBaseUrl(" ").isEmpty());
+    }
+
+    void test_candidates()
+    {
+        Net::UrlRouter router;
+        QList<Net::UrlRouter::Source> sources;
+        auto addSource = [&](const QString &name, const QString &baseUrl, bool proxy)
+        {
+            Net::UrlRouter::Source source;
+            source.name = name;
+            source.baseUrl = baseUrl;
+            source.proxy = proxy;
+            sources.append(source);
+        };
+        addSource("first", "https://first.example/", false);
+        addSource("second", "second.example", true);
+        // the same mirror twice is only asked once
+        addSource("again", "https://first.example", false);
+        router.compile(sources);
+
+        QUrl original("https://libraries.minecraft.net/a/b.jar");
+        auto candidates = router.candidates(original);
+        QCOMPARE(candidates.size(), 3);
+        QCOMPARE(candidates[0].url, QUrl("https://first.example/maven/a/b.jar"));
+        QCOMPARE(candidates[0].source, QString("first"));
+        QCOMPARE(candidates[1].url, QUrl("https://second.example/https://libraries.minecraft.net/a/b.jar"));
+        QCOMPARE(candidates[2].url, original);
+        QVERIFY(candidates[2].rule.isEmpty());
+        QCOMPARE(router.route(original).url, candidates[0].url);
+
+        // the path of the rule, the rest of the original path and the query are kept
+        candidates = router.candidates(QUrl("https://maven.neoforged.net/releases/net/x.jar?a=1"));
+        QCOMPARE(candidates[0].url, QUrl("https://first.example/maven/net/x.jar?a=1"));
+        candidates = router.candidates(QUrl("https://edge.forgecdn.net/files/1/2/x.jar"));
+        QCOMPARE(candidates[0].url, QUrl("https://first.example/files/1/2/x.jar"));
+
+        // nothing to choose from
+        QVERIFY(router.candidates(QUrl("https://example.com/a.zip")).isEmpty());
+        QVERIFY(router.candidates(candidates[1].url).isEmpty());
+    }
+};
+
+QTEST_GUILESS_MAIN(UrlRouterTest)
+
+#include "UrlRouter_test.moc"
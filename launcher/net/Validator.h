@@ -1,6 +1,9 @@
 #pragma once
 
 #include "net/NetAction.h"
+#include "hashing/MultiHash.h"
+
+#include <memory>
 
 namespace Net {
 class Validator
@@ -14,5 +17,15 @@ public: /* methods */
     virtual bool write(QByteArray & data) = 0;
     virtual bool abort() = 0;
     virtual bool validate(QNetworkReply & reply) = 0;
+
+    // digests of the data this validator needs. The sink computes them once for all its
+    // validators and hands them over through useHashes()
+    virtual Hashing::Algorithms hashes() const
+    {
+        return Hashing::Algorithms();
+    }
+    virtual void useHashes(std::shared_ptr<Hashing::MultiHash>)
+    {
+    }
 };
 }
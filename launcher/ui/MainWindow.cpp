@@ -75,6 +75,9 @@
 #include "ui/widgets/LabeledToolButton.h"
 #include "ui/dialogs/NewInstanceDialog.h"
 #include "ui/dialogs/ProgressDialog.h"
+#include "minecraft/GarbageCollectionTask.h"
+#include "minecraft/LaunchFingerprint.h"
+#include "minecraft/MinecraftInstance.h"
 #include "ui/dialogs/AboutDialog.h"
 #include "ui/dialogs/VersionSelectDialog.h"
 #include "ui/dialogs/CustomMessageBox.h"
@@ -218,6 +221,7 @@ public:
     TranslatedAction actionViewSelectedModsFolder;
     TranslatedAction actionDeleteInstance;
     TranslatedAction CheckInstanceupdates;
+    TranslatedAction actionVerifyInstance;
     TranslatedAction actionConfig_Folder;
     TranslatedAction actionCAT;
     TranslatedAction actionCopyInstance;
@@ -234,6 +238,7 @@ public:
     TranslatedToolButton foldersMenuButton;
     TranslatedAction actionViewInstanceFolder;
     TranslatedAction actionViewCentralModsFolder;
+    TranslatedAction actionCleanUpSharedFiles;
 
     QMenu * helpMenu = nullptr;
     TranslatedToolButton helpMenuButton;
@@ -313,6 +318,14 @@ public:
         all_actions.append(&actionViewCentralModsFolder);
         foldersMenu->addAction(actionViewCentralModsFolder);
 
+        foldersMenu->addSeparator();
+        actionCleanUpSharedFiles = TranslatedAction(MainWindow);
+        actionCleanUpSharedFiles->setObjectName(QStringLiteral("actionCleanUpSharedFiles"));
+        actionCleanUpSharedFiles.setTextId(QT_TRANSLATE_NOOP("MainWindow", "Clean Up Shared Files..."));
+        actionCleanUpSharedFiles.setTooltipId(QT_TRANSLATE_NOOP("MainWindow", "Find and remove libraries and assets no instance uses any more."));
+        all_actions.append(&actionCleanUpSharedFiles);
+        foldersMenu->addAction(actionCleanUpSharedFiles);
+
         foldersMenuButton = TranslatedToolButton(MainWindow);
         foldersMenuButton.setTextId(QT_TRANSLATE_NOOP("MainWindow", "Folders"));
         foldersMenuButton.setTooltipId(QT_TRANSLATE_NOOP("MainWindow", "Open one of the folders shared between instances."));
@@ -638,6 +651,13 @@ public:
         all_actions.append(&CheckInstanceupdates);
         instanceToolBar->addAction(CheckInstanceupdates);
 
+        actionVerifyInstance = TranslatedAction(MainWindow);
+        actionVerifyInstance->setObjectName(QStringLiteral("actionVerifyInstance"));
+        actionVerifyInstance.setTextId(QT_TRANSLATE_NOOP("MainWindow", "Verify Files"));
+        actionVerifyInstance.setTooltipId(QT_TRANSLATE_NOOP("MainWindow", "Check the game files of the selected instance and download the damaged ones again."));
+        all_actions.append(&actionVerifyInstance);
+        instanceToolBar->addAction(actionVerifyInstance);
+
 
         all_toolbars.append(&instanceToolBar);
         MainWindow->addToolBar(Qt::RightToolBarArea, instanceToolBar);
@@ -1061,6 +1081,17 @@ void MainWindow::updateToolsMenu()
             {
                 APPLICATION->launch(m_selectedInstance, false);
             });
+    auto minecraftInstance = std::dynamic_pointer_cast<MinecraftInstance>(m_selectedInstance);
+    if (minecraftInstance)
+    {
+        QAction *fullCheckLaunch = launchMenu->addAction(tr("Launch with Full Update"));
+        fullCheckLaunch->setToolTip(tr("Check everything the instance needs before launching, even if nothing changed since the last update."));
+        connect(fullCheckLaunch, &QAction::triggered, [this, minecraftInstance]()
+                {
+                    LaunchFingerprint::clear(minecraftInstance.get());
+                    APPLICATION->launch(m_selectedInstance, true);
+                });
+    }
     QString profilersTitle = tr("Profilers");
     launchMenu->addSeparator()->setText(profilersTitle);
     launchOfflineMenu->addSeparator()->setText(profilersTitle);
@@ -1464,6 +1495,33 @@ void MainWindow::on_actionCopyInstance_triggered()
     runModalTask(task.get());
 }
 
+void MainWindow::on_actionVerifyInstance_triggered()
+{
+    if (!m_selectedInstance)
+        return;
+
+    if (m_selectedInstance->isRunning())
+    {
+        QMessageBox::information(this, tr("Verify Files"), tr("The files of a running instance can't be verified."));
+        return;
+    }
+    auto task = m_selectedInstance->createUpdateTask(Net::Mode::Verify);
+    if (!task)
+    {
+        QMessageBox::information(this, tr("Verify Files"), tr("This kind of instance has no files that can be verified."));
+        return;
+    }
+    auto rawTask = task.get();
+    connect(rawTask, &Task::succeeded, [this, rawTask]()
+        {
+            if (rawTask->warnings().isEmpty())
+            {
+                CustomMessageBox::selectable(this, tr("Verify Files"), tr("All the game files are intact."), QMessageBox::Information)->show();
+            }
+        });
+    runModalTask(rawTask);
+}
+
 void MainWindow::on_CheckInstanceupdates_triggered()
 {
     if (!m_selectedInstance) return;
@@ -1749,6 +1807,44 @@ void MainWindow::on_actionViewCentralModsFolder_triggered()
     DesktopServices::openDirectory(APPLICATION->settings()->get("CentralModsDir").toString(), true);
 }
 
+void MainWindow::on_actionCleanUpSharedFiles_triggered()
+{
+    GarbageCollectionTask scan(APPLICATION->instances(), true);
+    ProgressDialog scanDialog(this);
+    if (!scanDialog.execWithTask(&scan))
+    {
+        CustomMessageBox::selectable(this, tr("Error"), scan.failReason(), QMessageBox::Warning)->show();
+        return;
+    }
+    if (scan.report().files() == 0)
+    {
+        CustomMessageBox::selectable(this, tr("Clean Up Shared Files"), tr("There is nothing to clean up."), QMessageBox::Information)->show();
+        return;
+    }
+    auto answer = CustomMessageBox::selectable(
+        this,
+        tr("Clean Up Shared Files"),
+        scan.report().summary() + "\n\n" + tr("Remove them? Files an instance needs again are downloaded or extracted again when it is updated."),
+        QMessageBox::Question,
+        QMessageBox::Yes | QMessageBox::No,
+        QMessageBox::No
+    )->exec();
+    if (answer != QMessageBox::Yes)
+    {
+        return;
+    }
+
+    // look again, an instance may have changed in the meantime
+    GarbageCollectionTask clean(APPLICATION->instances(), false);
+    ProgressDialog cleanDialog(this);
+    if (!cleanDialog.execWithTask(&clean))
+    {
+        CustomMessageBox::selectable(this, tr("Error"), clean.failReason(), QMessageBox::Warning)->show();
+        return;
+    }
+    CustomMessageBox::selectable(this, tr("Clean Up Shared Files"), clean.report().summary(), QMessageBox::Information)->show();
+}
+
 void MainWindow::on_actionConfig_Folder_triggered()
 {
     if (m_selectedInstance)
@@ -2045,6 +2141,9 @@ void MainWindow::instanceChanged(const QModelIndex &current, const QModelIndex &
 
         updateToolsMenu();
 
+        // the user is likely to update or launch it next
+        APPLICATION->warmUpConnections(m_selectedInstance->likelyDownloadUrls());
+
         APPLICATION->settings()->set("SelectedInstance", m_selectedInstance->id());
     }
     else
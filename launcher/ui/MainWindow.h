@@ -81,6 +81,8 @@ private slots:
 
     void on_CheckInstanceupdates_triggered();
 
+    void on_actionVerifyInstance_triggered();
+
     void on_actionChangeInstGroup_triggered();
 
     void on_actionChangeInstIcon_triggered();
@@ -103,6 +105,8 @@ private slots:
 
     void on_actionViewCentralModsFolder_triggered();
 
+    void on_actionCleanUpSharedFiles_triggered();
+
     void checkForUpdates();
 
     void on_actionSettings_triggered();
@@ -218,6 +218,9 @@ void LauncherPage::applySettings()
         break;
     }
 
+    s->set("DownloadRateLimit", ui->rateLimitSpinBox->value());
+    s->set("BackgroundRateLimit", ui->backgroundRateLimitSpinBox->value());
+
     if(original != s->get("IconTheme"))
     {
         APPLICATION->setIconTheme(s->get("IconTheme").toString());
@@ -343,6 +346,8 @@ void LauncherPage::loadSettings()
     {
         ui->threadcomboBox->setCurrentIndex(2);
     }
+    ui->rateLimitSpinBox->setValue(s->get("DownloadRateLimit").toInt());
+    ui->backgroundRateLimitSpinBox->setValue(s->get("BackgroundRateLimit").toInt());
 
 
     {
@@ -54,6 +54,7 @@ void Modplatform::DescriptionDocument::requestResource(const QUrl& url) {
 
     ImageLoad *load = new ImageLoad;
     load->job = new NetJob(QString("Document Image Download %1").arg(key), APPLICATION->network());
+    load->job->setPriority(Net::Priority::Thumbnail);
     load->job->addNetAction(Net::Download::makeByteArray(url, &load->output));
     load->key = key;
 
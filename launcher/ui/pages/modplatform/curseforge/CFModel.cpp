@@ -101,6 +101,7 @@ void ListModel::requestLogo(QString logo, QString url)
 
     MetaEntryPtr entry = APPLICATION->metacache()->resolveEntry("CurseForgePacks", QString("logos/%1").arg(logo.section(".", 0, 0)));
     NetJob *job = new NetJob(QString("CurseForge Icon Download %1").arg(logo), APPLICATION->network());
+    job->setPriority(Net::Priority::Thumbnail);
     job->addNetAction(Net::Download::makeCached(QUrl(url), entry));
 
     auto fullPath = entry->getFullPath();
@@ -325,6 +325,7 @@ void ListModel::requestLogo(QString logo, QString url)
     bool stale = entry->isStale();
 
     auto *job = new NetJob(QString("ModpacksCH Icon Download %1").arg(logo), APPLICATION->network());
+    job->setPriority(Net::Priority::Thumbnail);
     job->addNetAction(Net::Download::makeCached(QUrl(url), entry));
 
     auto fullPath = entry->getFullPath();
@@ -234,6 +234,7 @@ void Modrinth::ListModel::requestLogo(const QString &logo, const QUrl &url)
 
     MetaEntryPtr entry = APPLICATION->metacache()->resolveEntry("ModrinthPacks", QString("logos/%1").arg(logo.section(".", 0, 0)));
     auto *job = new NetJob(QString("Modrinth Icon Download %1").arg(logo), APPLICATION->network());
+    job->setPriority(Net::Priority::Thumbnail);
     job->addNetAction(Net::Download::makeCached(url, entry));
 
     auto fullPath = entry->getFullPath();